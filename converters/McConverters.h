@@ -0,0 +1,31 @@
+/**
+ * Entry points of the converters
+ *
+ * Every converter source file provides a function that converts one
+ * input file to one mcDst file, and its own main() unless the
+ * MCDST_CONVERTER_NO_MAIN macro is defined. This allows to call the
+ * converters from other programs (e.g. mcdst-convert) without running
+ * a separate process for each input file. Each function returns
+ * number of converted events (or -1 if something went wrong).
+ */
+
+#ifndef McConverters_h
+#define McConverters_h
+
+/// Convert UrQMD ftn13 or ftn14 ascii file
+int urqmd2mc(const char *inFileName, const char *oFileName, int nEvents);
+
+/// Convert OSCAR 2013 extended ascii file (e.g. from SMASH)
+int oscar2013ext(const char *inFileName, const char *oFileName, int nEvents,
+                 int compressionLevel, int compressionAlgo);
+
+/// Convert HepMC3 ascii file using nThreads parsing threads
+int hepmc2mc(const char *inFileName, const char *oFileName, int nEvents,
+             int nThreads, int onlyFinal, int compressionLevel,
+             int compressionAlgo);
+
+/// Convert SMASH binary OSCAR file
+int smashbin2mc(const char *inFileName, const char *oFileName, int nEvents,
+                int compressionLevel, int compressionAlgo);
+
+#endif // McConverters_h
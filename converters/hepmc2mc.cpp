@@ -0,0 +1,849 @@
+/*
+  vim:et:sw=2:
+
+  hepmc2mc converts HepMC3 ASCII files (HepMC::Asciiv3) to the McDst
+  format. The HepMC3 library is not needed.
+
+  E, U, A, P and V records are mapped to McEvent and McParticle:
+  * particle index is the HepMC particle id minus one;
+  * parent is the first incoming particle of the production vertex;
+  * first and last children are the lowest and the highest index of
+    the particles outgoing from the end vertex;
+  * position is the one of the production vertex (the event position
+    if the vertex has none), converted to fm;
+  * impact parameter, event plane angle, Npart and Ncoll are taken from
+    the GenHeavyIon attribute.
+
+  The input is split into blocks of whole events by a reader thread,
+  the blocks are parsed by a pool of threads, and the main thread fills
+  the tree in the input order. Blocks and all parsed buffers are
+  recycled, so no memory is allocated per line or per event once the
+  buffers have grown to the size of the largest event.
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+#include <errno.h>
+
+// C headers
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+
+// C++ headers
+#include <iostream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// ROOT headers
+#include <TObject.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TString.h>
+#include <TClonesArray.h>
+#include <Compression.h>
+#include <TLorentzVector.h>
+
+// McDst headers
+#include "McRun.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McArrays.h"
+#include "McDstCut.h"
+#include "McBoundedQueue.h"
+#include "McConverters.h"
+
+// There is only one namespace is used. So make it default.
+using namespace std;
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "hepmc2mc.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "hepmc2mc"
+#define VERSION "1.0"
+#define OFILE_DEFAULT "out_hepmc.mcDst.root"
+
+// Size of the input blocks (bytes).
+#define BLOCK_SIZE (4 << 20)
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+// Options for getopt.
+static struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "ifname", .has_arg = 1, .flag = 0, .val = 'i' },
+  { .name = "ofname", .has_arg = 1, .flag = 0, .val = 'o' },
+  { .name = "events", .has_arg = 1, .flag = 0, .val = 'e' },
+  { .name = "threads", .has_arg = 1, .flag = 0, .val = 'j' },
+  { .name = "final-only", .has_arg = 0, .flag = 0, .val = 'f' },
+  { .name = "compression-level", .has_arg = 1, .flag = 0, .val = 0xFF01 },
+  { .name = "compression-algo", .has_arg = 1, .flag = 0, .val = 0xFF02 },
+  { .name = "self-test", .has_arg = 0, .flag = 0, .val = 0xFF03 },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+static void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " HepMC3 ASCII to McDst converter\n"          \
+    "Usage: " PROGNAME " [Options]\n"                                   \
+    "Options:\n\
+    -h, --help                        help\n\
+    -i, --ifname <filename>           input HepMC3 ASCII file\n\
+    -e, --events <number of events>   number of events to read\n\
+    -o, --ofname <filename>           output file (default: " OFILE_DEFAULT ")\n\
+    -j, --threads <number of threads> number of parsing threads (default: number of cores)\n\
+    -f, --final-only                  write only final state particles (status 1)\n\
+    --compression-level <level>       set compression level to <level>.\n\
+                                      valid levels are from 1 (low) 9 (high).\n\
+    --compression-algo <aglorithm>    set compression algorithm to <algorithm>\n\
+                                      possible values are zlib, lz4 (only for ROOT > 6), lzma\n\
+    --self-test                       check parsing of the GenHeavyIon attribute and exit\n";
+
+  cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+/*
+  Simple hash function to compare 4 bytes char arrays.  If char array
+  are more than 4 bytes long it could results in hash collisions.
+*/
+static uint32_t
+hash4(char *s)
+{
+  uint32_t hash = 0;
+
+  while (*s++)
+    hash = (hash << 8) | (uint32_t)*s;
+  return hash;
+}
+#endif // MCDST_CONVERTER_NO_MAIN
+
+// Particle record (P line).
+struct HepParticle
+{
+  int prodVtx;        // production vertex id (<0) or parent particle id (>0)
+  int pdg;
+  int status;
+  double px, py, pz, e;
+  // Filled by build_links().
+  int parent;         // index of the parent particle or -1
+  int child[2];       // first and last child index or -1
+  double x, y, z, t;  // production position
+};
+
+// Vertex record (V line).
+struct HepVertex
+{
+  int firstIn;        // position of the first incoming id in HepEvent::incoming
+  int nIn;            // number of incoming particles
+  bool hasPos;
+  double x, y, z, t;
+  int outMin, outMax; // lowest and highest index of the outgoing particles
+};
+
+// Parsed event. Vectors keep their capacity between events.
+struct HepEvent
+{
+  int eventNr;
+  double x, y, z, t;         // event position
+  double momUnit, lenUnit;   // conversion to GeV and fm
+  double b, phi;             // impact parameter (fm) and event plane angle
+  int npart, ncoll;
+  double sigma;              // cross section (mb), negative if not given
+  std::vector<HepParticle> particles;
+  std::vector<HepVertex> vertices;
+  std::vector<int> incoming; // incoming particle ids of all vertices
+  std::vector<int> endVtx;   // end vertex index of each particle or -1
+};
+
+// Block of whole events as read from the input file.
+struct HepBlock
+{
+  long seq;                     // sequence number of the block
+  std::string text;             // input text
+  std::vector<HepEvent> events; // parsed events (only the first nevents are valid)
+  std::size_t nevents;
+};
+
+//_________________
+// Skip spaces and tabs.
+static inline const char*
+skip_ws(const char *p)
+{
+  while (*p == ' ' || *p == '\t')
+    ++p;
+  return p;
+}
+
+//_________________
+// Read integer from *p and move *p behind it.
+static inline int
+next_int(const char **p)
+{
+  char *end;
+  long val = strtol(skip_ws(*p), &end, 10);
+  *p = end;
+  return (int)val;
+}
+
+//_________________
+// Read floating point number from *p and move *p behind it.
+static inline double
+next_double(const char **p)
+{
+  char *end;
+  double val = strtod(skip_ws(*p), &end);
+  *p = end;
+  return val;
+}
+
+//_________________
+// Compare word at p with the given one.
+static inline bool
+is_word(const char *p, const char *word)
+{
+  std::size_t n = strlen(word);
+  return strncmp(p, word, n) == 0 && (p[n] == ' ' || p[n] == '\t' || p[n] == '\n' || p[n] == '\0');
+}
+
+//_________________
+// Parse U line: momentum and length units.
+static void
+parse_units(const char *p, HepEvent &ev)
+{
+  p = skip_ws(p);
+  ev.momUnit = is_word(p, "MEV") ? 1.e-3 : 1.;
+  while (*p && *p != ' ' && *p != '\t' && *p != '\n')
+    ++p;
+  p = skip_ws(p);
+  // McDst positions are in fm.
+  ev.lenUnit = is_word(p, "CM") ? 1.e13 : 1.e12;
+}
+
+//_________________
+// Parse A line (attributes) of the event.
+static void
+parse_attribute(const char *p, HepEvent &ev)
+{
+  next_int(&p); // object id, 0 for the event itself
+  p = skip_ws(p);
+  if (is_word(p, "GenHeavyIon"))
+  {
+    p = skip_ws(p + 11);
+    // Since HepMC 3.2.1 the attribute starts with the version tag "v0".
+    // The leading numbers are the same, the separate numbers of proton
+    // and neutron spectators follow the centrality.
+    if (is_word(p, "v0"))
+      p += 2;
+    next_int(&p); // Ncoll_hard
+    int npartProj = next_int(&p);
+    int npartTarg = next_int(&p);
+    ev.ncoll = next_int(&p);
+    for (int i = 0; i < 5; ++i)
+      next_int(&p); // spectator neutrons and protons, wounded collisions
+    ev.npart = npartProj + npartTarg;
+    ev.b = next_double(&p);
+    ev.phi = next_double(&p);
+  }
+  else if (is_word(p, "GenCrossSection"))
+  {
+    // Cross section is given in pb.
+    p += 15;
+    ev.sigma = next_double(&p) * 1.e-9;
+  }
+}
+
+//_________________
+// Parse P line.
+static void
+parse_particle(const char *p, HepEvent &ev)
+{
+  int id = next_int(&p);
+  if (id != (int)ev.particles.size() + 1)
+    ERR(0, "particle id %d is out of order in event %d", id, ev.eventNr);
+  ev.particles.resize(ev.particles.size() + 1);
+  HepParticle &part = ev.particles.back();
+  part.prodVtx = next_int(&p);
+  part.pdg = next_int(&p);
+  part.px = next_double(&p);
+  part.py = next_double(&p);
+  part.pz = next_double(&p);
+  part.e = next_double(&p);
+  next_double(&p); // generated mass
+  part.status = next_int(&p);
+}
+
+//_________________
+// Parse V line.
+static void
+parse_vertex(const char *p, HepEvent &ev)
+{
+  int id = next_int(&p);
+  if (id != -(int)ev.vertices.size() - 1)
+    ERR(0, "vertex id %d is out of order in event %d", id, ev.eventNr);
+  ev.vertices.resize(ev.vertices.size() + 1);
+  HepVertex &vtx = ev.vertices.back();
+  next_int(&p); // status
+  vtx.firstIn = (int)ev.incoming.size();
+  vtx.nIn = 0;
+  vtx.hasPos = false;
+  vtx.x = vtx.y = vtx.z = vtx.t = 0;
+  vtx.outMin = vtx.outMax = -1;
+  p = skip_ws(p);
+  if (*p == '[')
+  {
+    ++p;
+    while (*p && *p != ']' && *p != '\n')
+    {
+      char *end;
+      long in = strtol(p, &end, 10);
+      if (end == p)
+      {
+        ++p; // comma or space
+        continue;
+      }
+      ev.incoming.push_back((int)in);
+      ++vtx.nIn;
+      p = end;
+    }
+    if (*p == ']')
+      ++p;
+  }
+  else if (*p != '@' && *p != '\n' && *p != '\0')
+  { // Single incoming particle without brackets.
+    ev.incoming.push_back(next_int(&p));
+    ++vtx.nIn;
+  }
+  p = skip_ws(p);
+  if (*p == '@')
+  {
+    ++p;
+    vtx.hasPos = true;
+    vtx.x = next_double(&p);
+    vtx.y = next_double(&p);
+    vtx.z = next_double(&p);
+    vtx.t = next_double(&p);
+  }
+}
+
+//_________________
+// Parse E line and reset the event.
+static void
+parse_event_line(const char *p, HepEvent &ev)
+{
+  ev.eventNr = next_int(&p);
+  int nvtx = next_int(&p);
+  int npart = next_int(&p);
+  ev.x = ev.y = ev.z = ev.t = 0;
+  p = skip_ws(p);
+  if (*p == '@')
+  {
+    ++p;
+    ev.x = next_double(&p);
+    ev.y = next_double(&p);
+    ev.z = next_double(&p);
+    ev.t = next_double(&p);
+  }
+  ev.momUnit = 1.;
+  ev.lenUnit = 1.e12;
+  ev.b = ev.phi = 0;
+  ev.npart = ev.ncoll = 0;
+  ev.sigma = -1;
+  ev.particles.clear();
+  ev.vertices.clear();
+  ev.incoming.clear();
+  if (npart > 0)
+    ev.particles.reserve(npart);
+  if (nvtx > 0)
+    ev.vertices.reserve(nvtx);
+}
+
+//_________________
+// Set parent, children and positions of all particles of the event.
+static void
+build_links(HepEvent &ev)
+{
+  const int np = (int)ev.particles.size();
+  const int nv = (int)ev.vertices.size();
+
+  ev.endVtx.assign(np, -1);
+  for (int iv = 0; iv < nv; ++iv)
+  {
+    const HepVertex &vtx = ev.vertices[iv];
+    for (int k = 0; k < vtx.nIn; ++k)
+    {
+      int in = ev.incoming[vtx.firstIn + k] - 1;
+      if (in >= 0 && in < np)
+        ev.endVtx[in] = iv;
+    }
+  }
+
+  for (int ip = 0; ip < np; ++ip)
+  {
+    HepParticle &part = ev.particles[ip];
+    part.parent = -1;
+    part.child[0] = part.child[1] = -1;
+    part.x = ev.x;
+    part.y = ev.y;
+    part.z = ev.z;
+    part.t = ev.t;
+  }
+
+  for (int ip = 0; ip < np; ++ip)
+  {
+    HepParticle &part = ev.particles[ip];
+    if (part.prodVtx > 0 && part.prodVtx <= np)
+    { // Implicit vertex with a single incoming particle.
+      int parent = part.prodVtx - 1;
+      part.parent = parent;
+      HepParticle &mother = ev.particles[parent];
+      if (mother.child[0] < 0 || ip < mother.child[0])
+        mother.child[0] = ip;
+      if (ip > mother.child[1])
+        mother.child[1] = ip;
+    }
+    else if (part.prodVtx < 0 && -part.prodVtx <= nv)
+    {
+      HepVertex &vtx = ev.vertices[-part.prodVtx - 1];
+      if (vtx.nIn > 0)
+        part.parent = ev.incoming[vtx.firstIn] - 1;
+      if (vtx.hasPos)
+      {
+        part.x = vtx.x;
+        part.y = vtx.y;
+        part.z = vtx.z;
+        part.t = vtx.t;
+      }
+      if (vtx.outMin < 0 || ip < vtx.outMin)
+        vtx.outMin = ip;
+      if (ip > vtx.outMax)
+        vtx.outMax = ip;
+    }
+  }
+
+  for (int ip = 0; ip < np; ++ip)
+  {
+    if (ev.endVtx[ip] < 0)
+      continue;
+    const HepVertex &vtx = ev.vertices[ev.endVtx[ip]];
+    ev.particles[ip].child[0] = vtx.outMin;
+    ev.particles[ip].child[1] = vtx.outMax;
+  }
+}
+
+//_________________
+// Parse all events of the block.
+static void
+parse_block(HepBlock &block)
+{
+  const char *p = block.text.c_str();
+  HepEvent *ev = 0;
+
+  block.nevents = 0;
+  while (*p)
+  {
+    const char *eol = strchr(p, '\n');
+    switch (p[0])
+    {
+    case 'E':
+      if (ev)
+        build_links(*ev);
+      if (block.events.size() <= block.nevents)
+        block.events.resize(block.nevents + 1);
+      ev = &block.events[block.nevents++];
+      parse_event_line(p + 1, *ev);
+      break;
+    case 'U':
+      if (ev)
+        parse_units(p + 1, *ev);
+      break;
+    case 'A':
+      if (ev)
+        parse_attribute(p + 1, *ev);
+      break;
+    case 'P':
+      if (ev)
+        parse_particle(p + 1, *ev);
+      break;
+    case 'V':
+      if (ev)
+        parse_vertex(p + 1, *ev);
+      break;
+    default: // Header, weights, tools, etc.
+      break;
+    }
+    if (!eol)
+      break;
+    p = eol + 1;
+  }
+  if (ev)
+    build_links(*ev);
+}
+
+//_________________
+// Find beginning of the last event in text. The event at the very
+// beginning of text is not counted. Return std::string::npos if there is none.
+static std::size_t
+last_event_start(const std::string &text)
+{
+  std::size_t pos = text.rfind("\nE ");
+  if (pos == std::string::npos)
+    return std::string::npos;
+  return pos + 1;
+}
+
+//_________________
+// Reader thread: fill free blocks with whole events and pass them to the parsers.
+static void
+read_blocks(FILE *ifile, McBoundedQueue<HepBlock*> *freeBlocks,
+            McBoundedQueue<HepBlock*> *toParse)
+{
+  std::string carry;
+  std::vector<char> buf(BLOCK_SIZE);
+  long seq = 0;
+  bool eof = false;
+  HepBlock *block;
+
+  while (!eof && freeBlocks->pop(block))
+  {
+    block->seq = seq++;
+    block->text.swap(carry);
+    carry.clear();
+    // Read until the block has at least one complete event.
+    std::size_t cut = std::string::npos;
+    while (cut == std::string::npos)
+    {
+      std::size_t nr = fread(buf.data(), 1, buf.size(), ifile);
+      if (nr == 0)
+      {
+        eof = true;
+        break;
+      }
+      block->text.append(buf.data(), nr);
+      cut = last_event_start(block->text);
+    }
+    if (!eof)
+    {
+      carry.assign(block->text, cut, std::string::npos);
+      block->text.resize(cut);
+    }
+    if (!toParse->push(block))
+      break;
+  }
+  toParse->close();
+}
+
+/*
+  Convert nev events of the HepMC3 ASCII file ifname to the McDst file
+  ofname using nthreads parsing threads. If onlyFinal is not zero then
+  only particles with status 1 are written. Return number of converted
+  events.
+*/
+int
+hepmc2mc(const char *ifname, const char *ofname, int nev, int nthreads,
+         int onlyFinal, int ofnameCompLevel, int ofnameCompAlgo)
+{
+  TFile *ofile = 0;
+  FILE *ifile;
+  TTree *tree = 0;
+  int treeAutoSave = -(4 << 20); /* Do auto save each 4 MB == 4^20 Bytes.
+                                    Minus stands for bytes limit rather than number of entries. */
+  TClonesArray *mcArrays[McArrays::NAllMcArrays];
+  // Preselection cut class.
+  McDstCut cut;
+  // Number of converted events.
+  int nconv = 0;
+  // Cross section (mb) of the last event that provided it.
+  double sigma = 0;
+
+  if (nthreads < 1)
+    nthreads = 1;
+
+  // Input file
+  ifile = fopen(ifname, "r");
+  if (!ifile)
+    ERR(1, "cannot open input file %s", ifname);
+
+  // Output file
+  ofile = new TFile(ofname, "RECREATE");
+  if (!ofile || ofile->IsZombie())
+  {
+    fclose(ifile);
+    ERR(1, "cannot open output file %s", ofname);
+  }
+  ofile->SetCompressionLevel(ofnameCompLevel);
+  ofile->SetCompressionAlgorithm(ofnameCompAlgo);
+
+  // Setting up McDst.
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+  tree = new TTree("McDst", "HepMC3 tree");
+  tree->SetAutoSave(treeAutoSave);
+  for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+  { // Create arrays.
+    mcArrays[i] = new TClonesArray(McArrays::mcArrayTypes[i], McArrays::mcArraySizes[i]);
+    // Set branch.
+    tree->Branch(McArrays::mcArrayNames[i], &mcArrays[i]);
+  }
+
+  // Pipeline: free blocks -> reader -> parsers -> ordered writer -> free blocks.
+  // Blocks in flight never exceed nblocks, thus the parsed blocks can
+  // be put to the slot seq % nblocks of the ring.
+  const std::size_t nblocks = 2 * nthreads + 2;
+  std::vector<HepBlock> blocks(nblocks);
+  std::vector<HepBlock*> ring(nblocks, (HepBlock*)0);
+  std::mutex ringMutex;
+  std::condition_variable ringReady;
+  std::size_t parsersLeft = nthreads;
+  McBoundedQueue<HepBlock*> freeBlocks(nblocks);
+  McBoundedQueue<HepBlock*> toParse(nblocks);
+  for (std::size_t i = 0; i < nblocks; ++i)
+    freeBlocks.push(&blocks[i]);
+
+  std::thread reader(read_blocks, ifile, &freeBlocks, &toParse);
+  std::vector<std::thread> parsers;
+  for (int i = 0; i < nthreads; ++i)
+  {
+    parsers.push_back(std::thread([&]() {
+      HepBlock *block;
+      while (toParse.pop(block))
+      {
+        parse_block(*block);
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ring[block->seq % nblocks] = block;
+        ringReady.notify_all();
+      }
+      std::lock_guard<std::mutex> lock(ringMutex);
+      --parsersLeft;
+      ringReady.notify_all();
+    }));
+  }
+
+  // Write blocks in the input order.
+  for (long seq = 0; nconv < nev; ++seq)
+  {
+    HepBlock *block = 0;
+    {
+      std::unique_lock<std::mutex> lock(ringMutex);
+      ringReady.wait(lock, [&]() { return ring[seq % nblocks] || parsersLeft == 0; });
+      block = ring[seq % nblocks];
+      ring[seq % nblocks] = 0;
+    }
+    if (!block)
+      break; // End of file.
+
+    for (std::size_t iev = 0; iev < block->nevents && nconv < nev; ++iev)
+    {
+      const HepEvent &ev = block->events[iev];
+
+      // Clear all arrays.
+      for (int i = 0; i < McArrays::NAllMcArrays; mcArrays[i++]->Clear());
+
+      TClonesArray *mcEvCol = mcArrays[McArrays::Event];
+      McEvent *mcEv = new ((*mcEvCol)[mcEvCol->GetEntries()]) McEvent();
+      mcEv->setEventNr(ev.eventNr);
+      mcEv->setB(ev.b);
+      mcEv->setPhi(ev.phi);
+      mcEv->setNes(0);
+      mcEv->setComment(0);
+      mcEv->setStepNr(0);
+      mcEv->setStepT(0);
+      mcEv->setNpart(ev.npart);
+      mcEv->setNcoll(ev.ncoll);
+      if (ev.sigma >= 0)
+        sigma = ev.sigma;
+
+      TClonesArray *mcTrkCol = mcArrays[McArrays::Particle];
+      for (std::size_t ip = 0; ip < ev.particles.size(); ++ip)
+      {
+        const HepParticle &part = ev.particles[ip];
+        if (onlyFinal && part.status != 1)
+          continue;
+
+        TLorentzVector momentum(part.px * ev.momUnit, part.py * ev.momUnit,
+                                part.pz * ev.momUnit, part.e * ev.momUnit);
+        // Check particle cut.
+        if (!cut.isGoodParticle(momentum, part.pdg))
+          continue;
+
+        // Workaround for useless T& constructor parameters
+        int index = (int)ip;
+        int none = -1;
+        int child[2] = { part.child[0], part.child[1] };
+        new ((*mcTrkCol)[mcTrkCol->GetEntries()]) McParticle(index,
+                                                             part.pdg,
+                                                             part.status,
+                                                             part.parent,
+                                                             none, // decayed parent id
+                                                             none, // mate
+                                                             none, // decay id
+                                                             child,
+                                                             momentum.Px(),
+                                                             momentum.Py(),
+                                                             momentum.Pz(),
+                                                             momentum.E(),
+                                                             part.x * ev.lenUnit,
+                                                             part.y * ev.lenUnit,
+                                                             part.z * ev.lenUnit,
+                                                             part.t * ev.lenUnit);
+      }
+
+      // Add an event to DST.
+      tree->Fill();
+      ++nconv;
+    }
+
+    if (!freeBlocks.push(block))
+      break;
+  }
+
+  // Stop the pipeline. It is possible that not all events were read.
+  freeBlocks.close();
+  toParse.close();
+  reader.join();
+  for (std::size_t i = 0; i < parsers.size(); ++i)
+    parsers[i].join();
+  fclose(ifile);
+
+  McRun *run = new McRun("HepMC3", ifname, 0, 0, 0., 0, 0, 0.,
+                         0., 0., 0, 0., 0., sigma, nconv);
+  run->Write();
+  ofile->Write();
+  ofile->Close();
+  delete run;
+  return nconv;
+}
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+//_________________
+// Write GenHeavyIon attributes in both layouts, parse them back and
+// compare. Return the number of failed checks.
+static int
+self_test()
+{
+  const int npartProj = 100, npartTarg = 98, ncoll = 500;
+  const double b = 7.5, phi = 0.25;
+  char lines[2][256];
+  // Before HepMC 3.2.1.
+  snprintf(lines[0], sizeof(lines[0]),
+           "A 0 GenHeavyIon 2 %d %d %d 1 2 3 4 5 %g %g 0.3 70 0.15",
+           npartProj, npartTarg, ncoll, b, phi);
+  // HepMC 3.2.1 and later.
+  snprintf(lines[1], sizeof(lines[1]),
+           "A 0 GenHeavyIon v0 2 %d %d %d 1 2 3 4 5 %g %g 0.3 70 0.15 -1 10 11 12 13 0 0",
+           npartProj, npartTarg, ncoll, b, phi);
+
+  int nfailed = 0;
+  for (int i = 0; i < 2; ++i)
+  {
+    HepEvent ev = HepEvent();
+    parse_attribute(lines[i] + 1, ev);
+    if (ev.npart != npartProj + npartTarg || ev.ncoll != ncoll || ev.b != b || ev.phi != phi)
+    {
+      ERR(0, "self-test failed for \"%s\": npart %d ncoll %d b %g phi %g",
+          lines[i], ev.npart, ev.ncoll, ev.b, ev.phi);
+      ++nfailed;
+    }
+  }
+  std::cout << PROGNAME ": self-test " << (nfailed ? "failed" : "passed") << std::endl;
+  return nfailed;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hi:o:e:j:f"; // This string must be sync with a struct option array.
+  int opt, nev = std::numeric_limits<int>::max();
+  int nthreads = std::thread::hardware_concurrency();
+  int onlyFinal = 0;
+  char *ifname = 0;
+  const char *ofname = OFILE_DEFAULT;
+  int ofnameCompLevel = ROOT::RCompressionSetting::ELevel::kDefaultLZMA;
+  int ofnameCompAlgo = ROOT::kLZMA; // Use LZMA by default.
+  // Precalculated hashes.
+  const uint32_t lzma = 2053988608; // hash4("lzma")
+  const uint32_t zlib = 1818845696; // hash4("zlib")
+  const uint32_t lz4 = 8008704; // hash4("lz4")
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'i':
+      ifname = optarg;
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'e':
+      nev = std::stoi(optarg);
+      break;
+    case 'j':
+      nthreads = std::stoi(optarg);
+      break;
+    case 'f':
+      onlyFinal = 1;
+      break;
+    case 0xFF01:
+      ofnameCompLevel = std::stoi(optarg);
+      break;
+    case 0xFF02:
+      switch (hash4(optarg))
+      {
+      case lzma:
+        ofnameCompAlgo = ROOT::kLZMA;
+        break;
+      case zlib:
+        ofnameCompAlgo = ROOT::kZLIB;
+        break;
+      case lz4:
+        ofnameCompAlgo = ROOT::kLZ4;
+        break;
+      default:
+        std::cout << "Warning: there is no support for " << optarg << " compression algorithm"
+                  << "\nWarning: fallback to the lzma!\n";
+        ofnameCompAlgo = ROOT::kLZMA;
+      }
+      break;
+    case 0xFF03:
+      return self_test() ? EXIT_FAILURE : EXIT_SUCCESS;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  if (!ifname)
+    ERR(1, "no input file is given");
+
+  int nconv = hepmc2mc(ifname, ofname, nev, nthreads, onlyFinal,
+                       ofnameCompLevel, ofnameCompAlgo);
+  std::cout << nconv << " events converted to " << ofname << std::endl;
+  return (nconv < 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+#endif // MCDST_CONVERTER_NO_MAIN
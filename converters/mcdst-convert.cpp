@@ -0,0 +1,469 @@
+/*
+  mcdst-convert converts many generator output files to mcDst in one go.
+
+  Input files are dispatched to the converter entry points (see
+  McConverters.h) on a bounded pool of worker processes. The workers are
+  forked after ROOT, the McDst dictionaries and the PID tables are loaded,
+  so no job pays the ROOT start-up again, and a broken input file does
+  not bring the other jobs down.
+
+  The converter is chosen by the extension of the input file:
+    .f13, .f14   UrQMD (urqmd2mc)
+    .oscar       OSCAR 2013 extended (oscar2013ext)
+    .hepmc       HepMC3 ASCII (hepmc2mc)
+    .bin         SMASH binary OSCAR (smashbin2mc)
+
+  The produced files are written to a .list file that can be passed to
+  McDstReader, and a manifest keeps one line per input. Inputs that would
+  give the same output file (e.g. run.f13 and run.f14) are rejected before
+  any job starts. The manifest has the columns:
+    status input output format events bytes_in bytes_out seconds
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+// fork/waitpid/stat
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <map>
+#include <chrono>
+#include <thread>
+#include <limits>
+
+// ROOT headers
+#include "TObject.h"
+#include "Compression.h"
+
+// McDst headers
+#include "McRun.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McPIDConverter.h"
+#include "McConverters.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-convert.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-convert"
+#define VERSION "1.0"
+#define OLIST_DEFAULT "mcdst-convert.list"
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "input-list", .has_arg = 1, .flag = 0, .val = 'f' },
+  { .name = "jobs", .has_arg = 1, .flag = 0, .val = 'j' },
+  { .name = "events", .has_arg = 1, .flag = 0, .val = 'e' },
+  { .name = "odir", .has_arg = 1, .flag = 0, .val = 'd' },
+  { .name = "olist", .has_arg = 1, .flag = 0, .val = 'l' },
+  { .name = "manifest", .has_arg = 1, .flag = 0, .val = 'm' },
+  { .name = "quiet", .has_arg = 0, .flag = 0, .val = 'q' },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " converts many generator files to McDst\n"   \
+    "Usage: " PROGNAME " [Options] [input files]\n"                     \
+    "Options:\n\
+    -h, --help                        help\n\
+    -f, --input-list <filename>       file with one input file per line\n\
+    -j, --jobs <number of jobs>       number of parallel worker processes\n\
+                                      (default: number of cores)\n\
+    -e, --events <number of events>   maximal number of events per input file\n\
+    -d, --odir <directory>            output directory (default: next to the input)\n\
+    -l, --olist <filename>            list of produced files (default: " OLIST_DEFAULT ")\n\
+    -m, --manifest <filename>         manifest (default: <olist>.manifest)\n\
+    -q, --quiet                       suppress output of the converters\n\
+Supported inputs: .f13, .f14 (UrQMD), .oscar (OSCAR 2013 extended),\n\
+                  .hepmc, .hepmc3 (HepMC3 ASCII), .bin (SMASH binary)\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+// Supported input formats.
+enum
+{
+  kUnknownFormat = 0,
+  kUrQMD,
+  kOscar2013,
+  kHepMC3,
+  kSmashBinary
+};
+
+// Names of the formats for the manifest.
+const char *formatNames[] = { "unknown", "urqmd", "oscar2013ext", "hepmc3", "smash-binary" };
+
+// Conversion job.
+struct Job
+{
+  std::string input;  // input file
+  std::string output; // output mcDst file
+  int format;         // input format
+  pid_t pid;          // worker process
+  int fd;             // pipe to receive number of events from the worker
+  double start;       // start time (s)
+  double seconds;     // conversion time (s)
+  long nevents;       // number of converted events (-1 if failed)
+  long long bytesIn;  // size of the input file
+  long long bytesOut; // size of the output file
+  bool ok;            // conversion succeeded
+};
+
+// Return wall-clock time in seconds.
+double
+now()
+{
+  return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Return file size in bytes or 0 if the file does not exist.
+long long
+file_size(const std::string &name)
+{
+  struct stat st;
+  if (stat(name.c_str(), &st) != 0)
+    return 0;
+  return (long long)st.st_size;
+}
+
+// Return true if name ends with suffix.
+bool
+ends_with(const std::string &name, const std::string &suffix)
+{
+  return name.size() >= suffix.size() &&
+    name.compare(name.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// Find format of the input file by its extension.
+int
+input_format(const std::string &name)
+{
+  if (ends_with(name, ".f13") || ends_with(name, ".f14"))
+    return kUrQMD;
+  if (ends_with(name, ".oscar"))
+    return kOscar2013;
+  if (ends_with(name, ".hepmc") || ends_with(name, ".hepmc3"))
+    return kHepMC3;
+  if (ends_with(name, ".bin"))
+    return kSmashBinary;
+  return kUnknownFormat;
+}
+
+/*
+  Make output name: the extension of the input is replaced with
+  .mcDst.root. If odir is not empty then the file is put there.
+*/
+std::string
+output_name(const std::string &input, const std::string &odir)
+{
+  std::string name = input;
+  if (!odir.empty())
+  {
+    std::size_t slash = name.rfind('/');
+    if (slash != std::string::npos)
+      name = name.substr(slash + 1);
+    name = odir + "/" + name;
+  }
+  std::size_t dot = name.rfind('.');
+  std::size_t slash = name.rfind('/');
+  if (dot != std::string::npos && (slash == std::string::npos || dot > slash))
+    name.erase(dot);
+  return name + ".mcDst.root";
+}
+
+// Run conversion in the worker process. Return number of events.
+int
+run_job(const Job &job, int nev)
+{
+  switch (job.format)
+  {
+  case kUrQMD:
+    return urqmd2mc(job.input.c_str(), job.output.c_str(), nev);
+  case kOscar2013:
+    return oscar2013ext(job.input.c_str(), job.output.c_str(), nev,
+                        ROOT::RCompressionSetting::ELevel::kDefaultLZMA, ROOT::kLZMA);
+  case kHepMC3: // Jobs already run in parallel, so one parsing thread is enough.
+    return hepmc2mc(job.input.c_str(), job.output.c_str(), nev, 1, 0,
+                    ROOT::RCompressionSetting::ELevel::kDefaultLZMA, ROOT::kLZMA);
+  case kSmashBinary:
+    return smashbin2mc(job.input.c_str(), job.output.c_str(), nev,
+                       ROOT::RCompressionSetting::ELevel::kDefaultLZMA, ROOT::kLZMA);
+  default:
+    return -1;
+  }
+}
+
+// Start a worker process for the job.
+void
+start_job(Job &job, int nev, bool quiet)
+{
+  int fds[2];
+  if (pipe(fds) != 0)
+    ERR(1, "cannot create pipe");
+
+  // Do not duplicate buffered output in the child.
+  std::cout.flush();
+  fflush(NULL);
+
+  job.start = now();
+  job.pid = fork();
+  if (job.pid < 0)
+    ERR(1, "cannot fork worker for %s", job.input.c_str());
+
+  if (job.pid == 0)
+  { // Worker.
+    close(fds[0]);
+    if (quiet)
+    {
+      int devnull = open("/dev/null", O_WRONLY);
+      if (devnull >= 0)
+        dup2(devnull, STDOUT_FILENO);
+    }
+    int nconv = run_job(job, nev);
+    ssize_t nw = write(fds[1], &nconv, sizeof(nconv));
+    close(fds[1]);
+    std::cout.flush();
+    fflush(NULL);
+    _exit((nconv >= 0 && nw == sizeof(nconv)) ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+
+  close(fds[1]);
+  job.fd = fds[0];
+}
+
+// Collect result of the finished worker.
+void
+finish_job(Job &job, int wstatus)
+{
+  int nconv = -1;
+  if (read(job.fd, &nconv, sizeof(nconv)) != sizeof(nconv))
+    nconv = -1;
+  close(job.fd);
+
+  job.seconds = now() - job.start;
+  job.ok = WIFEXITED(wstatus) && WEXITSTATUS(wstatus) == EXIT_SUCCESS && nconv >= 0;
+  job.nevents = job.ok ? nconv : -1;
+  job.bytesIn = file_size(job.input);
+  job.bytesOut = job.ok ? file_size(job.output) : 0;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hf:j:e:d:l:m:q"; // This string must be sync with a struct option array.
+  int opt;
+  int nev = std::numeric_limits<int>::max();
+  unsigned int njobs = std::thread::hardware_concurrency();
+  std::string odir;
+  std::string olist = OLIST_DEFAULT;
+  std::string manifest;
+  bool quiet = false;
+  std::vector<Job> jobs;
+  std::vector<std::string> inputs;
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'f':
+    {
+      std::ifstream flist(optarg);
+      if (!flist)
+        ERR(1, "cannot open input list %s", optarg);
+      std::string line;
+      while (std::getline(flist, line))
+      {
+        if (!line.empty() && line[0] != '#')
+          inputs.push_back(line);
+      }
+      break;
+    }
+    case 'j':
+      njobs = std::stoi(optarg);
+      break;
+    case 'e':
+      nev = std::stoi(optarg);
+      break;
+    case 'd':
+      odir = optarg;
+      break;
+    case 'l':
+      olist = optarg;
+      break;
+    case 'm':
+      manifest = optarg;
+      break;
+    case 'q':
+      quiet = true;
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  for (int i = optind; i < argc; ++i)
+    inputs.push_back(argv[i]);
+  if (inputs.empty())
+    ERR(1, "no input files are given");
+  if (njobs == 0)
+    njobs = 1;
+  if (manifest.empty())
+    manifest = olist + ".manifest";
+
+  for (std::vector<std::string>::iterator it = inputs.begin(); it != inputs.end(); ++it)
+  {
+    Job job;
+    job.input = *it;
+    job.output = output_name(*it, odir);
+    job.format = input_format(*it);
+    job.pid = -1;
+    job.fd = -1;
+    job.start = job.seconds = 0;
+    job.nevents = -1;
+    job.bytesIn = job.bytesOut = 0;
+    job.ok = false;
+    jobs.push_back(job);
+  }
+
+  // Workers must not write the same file, e.g. for run.f13 and run.f14
+  // or for inputs with the same name in different directories.
+  std::map<std::string, std::size_t> outputs;
+  for (std::size_t i = 0; i < jobs.size(); ++i)
+  {
+    if (jobs[i].format == kUnknownFormat)
+      continue;
+    std::map<std::string, std::size_t>::const_iterator it = outputs.find(jobs[i].output);
+    if (it != outputs.end())
+      ERR(1, "%s and %s would be converted to the same file %s", jobs[it->second].input.c_str(),
+          jobs[i].input.c_str(), jobs[i].output.c_str());
+    outputs[jobs[i].output] = i;
+  }
+
+  // Load dictionaries and PID tables once. Workers inherit them.
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+  McPIDConverter::instance()->pdgCode(3001, McPIDConverter::eUrQMD);
+
+  std::cout << PROGNAME ": " << jobs.size() << " input files, " << njobs << " jobs" << std::endl;
+
+  // Job pool.
+  double start = now();
+  std::size_t next = 0;
+  std::size_t ndone = 0;
+  std::map<pid_t, std::size_t> active;
+  while (next < jobs.size() || !active.empty())
+  {
+    // Start new workers while there are free places in the pool.
+    while (next < jobs.size() && active.size() < njobs)
+    {
+      Job &job = jobs[next];
+      if (job.format == kUnknownFormat)
+      {
+        std::cout << "Warning: unknown format of " << job.input << ", skipping\n";
+        job.bytesIn = file_size(job.input);
+        ++next;
+        ++ndone;
+        continue;
+      }
+      start_job(job, nev, quiet);
+      active[job.pid] = next++;
+    }
+    if (active.empty())
+      continue;
+
+    // Wait for any worker.
+    int wstatus = 0;
+    pid_t pid = waitpid(-1, &wstatus, 0);
+    if (pid < 0)
+    {
+      if (errno == EINTR)
+        continue;
+      ERR(1, "waitpid failed");
+    }
+    std::map<pid_t, std::size_t>::iterator it = active.find(pid);
+    if (it == active.end())
+      continue;
+    Job &job = jobs[it->second];
+    active.erase(it);
+    finish_job(job, wstatus);
+    ++ndone;
+    std::cout << "[" << ndone << "/" << jobs.size() << "] "
+              << (job.ok ? "done   " : "FAILED ") << job.input;
+    if (job.ok)
+      std::cout << " -> " << job.output << " (" << job.nevents << " events, "
+                << std::fixed << std::setprecision(1) << job.seconds << " s)";
+    std::cout << std::endl;
+  }
+  double seconds = now() - start;
+
+  // Write list of produced files and the manifest.
+  std::ofstream flist(olist.c_str());
+  std::ofstream fmanifest(manifest.c_str());
+  if (!flist || !fmanifest)
+    ERR(1, "cannot write %s or %s", olist.c_str(), manifest.c_str());
+  fmanifest << "# status input output format events bytes_in bytes_out seconds\n";
+  long long nevents = 0, bytesIn = 0, bytesOut = 0;
+  std::size_t nok = 0;
+  for (std::vector<Job>::iterator job = jobs.begin(); job != jobs.end(); ++job)
+  {
+    if (job->ok)
+    {
+      flist << job->output << "\n";
+      nevents += job->nevents;
+      bytesOut += job->bytesOut;
+      ++nok;
+    }
+    bytesIn += job->bytesIn;
+    fmanifest << (job->ok ? "ok" : "failed") << " " << job->input << " "
+              << job->output << " " << formatNames[job->format] << " "
+              << job->nevents << " " << job->bytesIn << " " << job->bytesOut << " "
+              << std::fixed << std::setprecision(3) << job->seconds << "\n";
+  }
+
+  // Report throughput.
+  const double mb = 1024. * 1024.;
+  std::cout << PROGNAME ": converted " << nok << " of " << jobs.size() << " files, "
+            << nevents << " events in " << std::fixed << std::setprecision(1)
+            << seconds << " s\n"
+            << PROGNAME ": " << std::setprecision(1) << nevents / seconds << " events/s, "
+            << std::setprecision(2) << bytesIn / mb / seconds << " MB/s read, "
+            << bytesOut / mb / seconds << " MB/s written\n"
+            << PROGNAME ": list " << olist << ", manifest " << manifest << std::endl;
+
+  return (nok == jobs.size()) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
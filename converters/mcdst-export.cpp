@@ -0,0 +1,527 @@
+/*
+  vim:et:sw=2:
+
+  mcdst-export writes McDst files (or a list of them) as OSCAR 2013
+  particle lists or as HepMC3 ASCII, for afterburners that cannot read
+  McDst.
+
+  Events are read by McDstReader in the main thread and copied to plain
+  batches. The batches are formatted to text by a pool of threads and a
+  writer thread puts them to the output in the original order. Numbers
+  are formatted with std::to_chars (the shortest representation that
+  reads back to the same float), printf is not used.
+
+  OSCAR 2013 output has the "particle_lists" columns:
+    t x y z mass p0 px py pz pdg ID charge
+  HepMC3 output has no vertices: a particle refers to its parent via the
+  parent particle id when the parent was written before it, positions
+  are not written. McDst status 0 (used by the transport converters for
+  final particles) is written as HepMC status 1.
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <limits>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <charconv>
+#include <cstdio>
+#include <cstdint>
+#include <cstring>
+#include <cmath>
+#include <chrono>
+
+// ROOT headers
+#include "TChain.h"
+#include "TDatabasePDG.h"
+#include "TParticlePDG.h"
+
+// McDst headers
+#include "McDstReader.h"
+#include "McDst.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McRun.h"
+#include "McBoundedQueue.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-export.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-export"
+#define VERSION "1.0"
+
+// Number of events in one batch.
+#define BATCH_EVENTS 64
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "ifname", .has_arg = 1, .flag = 0, .val = 'i' },
+  { .name = "ofname", .has_arg = 1, .flag = 0, .val = 'o' },
+  { .name = "format", .has_arg = 1, .flag = 0, .val = 'f' },
+  { .name = "events", .has_arg = 1, .flag = 0, .val = 'e' },
+  { .name = "threads", .has_arg = 1, .flag = 0, .val = 'j' },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " exports McDst to OSCAR 2013 or HepMC3 ASCII\n" \
+    "Usage: " PROGNAME " [Options]\n"                                   \
+    "Options:\n\
+    -h, --help                        help\n\
+    -i, --ifname <filename>           input .mcDst.root file or a .list of them\n\
+    -o, --ofname <filename>           output file, - for stdout (default: -)\n\
+    -f, --format <format>             oscar (OSCAR 2013 particle lists, default) or hepmc\n\
+    -e, --events <number of events>   number of events to export\n\
+    -j, --threads <number of threads> number of formatting threads (default: number of cores)\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+// Output formats.
+enum
+{
+  kOscar2013 = 0,
+  kHepMC3
+};
+
+// Particle as copied from McDst.
+struct ExpParticle
+{
+  float t, x, y, z;
+  float e, px, py, pz;
+  int pdg;
+  int index;
+  int charge;
+  int status;
+  int parent;      // position of the parent in the event or -1
+};
+
+// Event as copied from McDst.
+struct ExpEvent
+{
+  int eventNr;
+  float b, phi;
+  int npart, ncoll;
+  std::size_t first; // position of the first particle in ExpBatch::particles
+  std::size_t n;     // number of particles
+};
+
+// Batch of events. Buffers keep their capacity when the batch is reused.
+struct ExpBatch
+{
+  long seq;
+  std::vector<ExpEvent> events;
+  std::vector<ExpParticle> particles;
+  std::string text;
+};
+
+//_________________
+// Append integer to the string.
+static inline void
+append_int(std::string &s, long val)
+{
+  char buf[24];
+  std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), val);
+  s.append(buf, res.ptr - buf);
+}
+
+//_________________
+// Append the shortest representation of the float to the string.
+static inline void
+append_float(std::string &s, float val)
+{
+  char buf[32];
+#if defined(__cpp_lib_to_chars)
+  std::to_chars_result res = std::to_chars(buf, buf + sizeof(buf), val);
+  s.append(buf, res.ptr - buf);
+#else
+  // Floating point std::to_chars is not available.
+  int n = snprintf(buf, sizeof(buf), "%.9g", val);
+  s.append(buf, n);
+#endif
+}
+
+//_________________
+// Format one event as OSCAR 2013 particle list.
+static void
+format_oscar(const ExpEvent &ev, const ExpParticle *prt, std::string &s)
+{
+  s += "# event ";
+  append_int(s, ev.eventNr);
+  s += " out ";
+  append_int(s, (long)ev.n);
+  s += '\n';
+  for (std::size_t i = 0; i < ev.n; ++i)
+  {
+    const ExpParticle &p = prt[i];
+    float m2 = p.e * p.e - p.px * p.px - p.py * p.py - p.pz * p.pz;
+    append_float(s, p.t);
+    s += ' ';
+    append_float(s, p.x);
+    s += ' ';
+    append_float(s, p.y);
+    s += ' ';
+    append_float(s, p.z);
+    s += ' ';
+    append_float(s, (m2 > 0) ? std::sqrt(m2) : -std::sqrt(-m2));
+    s += ' ';
+    append_float(s, p.e);
+    s += ' ';
+    append_float(s, p.px);
+    s += ' ';
+    append_float(s, p.py);
+    s += ' ';
+    append_float(s, p.pz);
+    s += ' ';
+    append_int(s, p.pdg);
+    s += ' ';
+    append_int(s, p.index);
+    s += ' ';
+    append_int(s, p.charge);
+    s += '\n';
+  }
+  s += "# event ";
+  append_int(s, ev.eventNr);
+  s += " end 0 impact ";
+  append_float(s, ev.b);
+  s += " scattering_projectile_target yes\n";
+}
+
+//_________________
+// Format one event as HepMC3 ASCII.
+static void
+format_hepmc(const ExpEvent &ev, const ExpParticle *prt, std::string &s)
+{
+  s += "E ";
+  append_int(s, ev.eventNr);
+  s += " 0 ";
+  append_int(s, (long)ev.n);
+  s += "\nU GEV MM\n";
+  // Legacy GenHeavyIon layout: Ncoll_hard Npart_proj Npart_targ Ncoll
+  // spectator_neutrons spectator_protons N_Nwounded_collisions
+  // Nwounded_N_collisions Nwounded_Nwounded_collisions impact_parameter
+  // event_plane_angle eccentricity sigma_inel_NN centrality.
+  // McDst keeps only the total Npart, it is written as Npart_proj.
+  s += "A 0 GenHeavyIon -1 ";
+  append_int(s, ev.npart);
+  s += " 0 ";
+  append_int(s, ev.ncoll);
+  s += " -1 -1 -1 -1 -1 ";
+  append_float(s, ev.b);
+  s += ' ';
+  append_float(s, ev.phi);
+  s += " -1 -1 -1\n";
+  for (std::size_t i = 0; i < ev.n; ++i)
+  {
+    const ExpParticle &p = prt[i];
+    float m2 = p.e * p.e - p.px * p.px - p.py * p.py - p.pz * p.pz;
+    s += "P ";
+    append_int(s, (long)i + 1);
+    s += ' ';
+    append_int(s, (p.parent >= 0 && (std::size_t)p.parent < i) ? p.parent + 1 : 0);
+    s += ' ';
+    append_int(s, p.pdg);
+    s += ' ';
+    append_float(s, p.px);
+    s += ' ';
+    append_float(s, p.py);
+    s += ' ';
+    append_float(s, p.pz);
+    s += ' ';
+    append_float(s, p.e);
+    s += ' ';
+    append_float(s, (m2 > 0) ? std::sqrt(m2) : -std::sqrt(-m2));
+    s += ' ';
+    append_int(s, (p.status == 0) ? 1 : p.status);
+    s += '\n';
+  }
+}
+
+//_________________
+// Format all events of the batch.
+static void
+format_batch(ExpBatch &batch, int format)
+{
+  batch.text.clear();
+  for (std::size_t iev = 0; iev < batch.events.size(); ++iev)
+  {
+    const ExpEvent &ev = batch.events[iev];
+    if (format == kHepMC3)
+      format_hepmc(ev, batch.particles.data() + ev.first, batch.text);
+    else
+      format_oscar(ev, batch.particles.data() + ev.first, batch.text);
+  }
+}
+
+//_________________
+// Return charge of the particle in units of e. Values are cached,
+// the lookup in TDatabasePDG is done once per PDG code.
+static int
+pdg_charge(std::map<int, int> &cache, int pdg)
+{
+  std::map<int, int>::iterator it = cache.find(pdg);
+  if (it != cache.end())
+    return it->second;
+  TParticlePDG *part = TDatabasePDG::Instance()->GetParticle(pdg);
+  // TParticlePDG keeps charge in units of |e|/3.
+  int charge = part ? (int)std::lround(part->Charge() / 3.) : 0;
+  cache[pdg] = charge;
+  return charge;
+}
+
+//_________________
+// Copy current McDst event to the batch.
+static void
+copy_event(ExpBatch &batch, std::map<int, int> &charges, std::vector<int> &position)
+{
+  McEvent *event = McDst::event();
+  UInt_t npart = McDst::numberOfParticles();
+
+  ExpEvent ev;
+  ev.eventNr = event->eventNr();
+  ev.b = event->b();
+  ev.phi = event->phi();
+  ev.npart = event->npart();
+  ev.ncoll = event->ncoll();
+  ev.first = batch.particles.size();
+  ev.n = npart;
+
+  // Position of each particle index in the event, for the parent lookup.
+  position.clear();
+  for (UInt_t i = 0; i < npart; ++i)
+  {
+    int index = McDst::particle(i)->index();
+    if (index < 0)
+      continue;
+    if ((std::size_t)index >= position.size())
+      position.resize(index + 1, -1);
+    position[index] = i;
+  }
+
+  for (UInt_t i = 0; i < npart; ++i)
+  {
+    McParticle *particle = McDst::particle(i);
+    ExpParticle p;
+    p.t = particle->t();
+    p.x = particle->x();
+    p.y = particle->y();
+    p.z = particle->z();
+    p.e = particle->e();
+    p.px = particle->px();
+    p.py = particle->py();
+    p.pz = particle->pz();
+    p.pdg = particle->pdg();
+    p.index = particle->index();
+    p.charge = pdg_charge(charges, p.pdg);
+    p.status = particle->status();
+    int parent = particle->parent();
+    p.parent = (parent >= 0 && (std::size_t)parent < position.size()) ? position[parent] : -1;
+    batch.particles.push_back(p);
+  }
+  batch.events.push_back(ev);
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hi:o:f:e:j:"; // This string must be sync with a struct option array.
+  int opt;
+  long nev = std::numeric_limits<long>::max();
+  int nthreads = std::thread::hardware_concurrency();
+  int format = kOscar2013;
+  const char *ifname = 0;
+  const char *ofname = "-";
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'i':
+      ifname = optarg;
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'f':
+      if (strcmp(optarg, "oscar") == 0)
+        format = kOscar2013;
+      else if (strcmp(optarg, "hepmc") == 0)
+        format = kHepMC3;
+      else
+        ERR(1, "unknown format %s", optarg);
+      break;
+    case 'e':
+      nev = std::stol(optarg);
+      break;
+    case 'j':
+      nthreads = std::stoi(optarg);
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  if (!ifname)
+    ERR(1, "no input file is given");
+  if (nthreads < 1)
+    nthreads = 1;
+
+  FILE *ofile = (strcmp(ofname, "-") == 0) ? stdout : fopen(ofname, "w");
+  if (!ofile)
+    ERR(1, "cannot open output file %s", ofname);
+  // Keep messages of the reader out of the exported stream.
+  if (ofile == stdout)
+    std::cout.rdbuf(std::cerr.rdbuf());
+
+  McDstReader reader(ifname);
+  reader.Init();
+  if (!reader.chain())
+    ERR(1, "cannot read %s", ifname);
+  Long64_t nentries = reader.chain()->GetEntries();
+  if (nentries > nev)
+    nentries = nev;
+
+  // Header.
+  std::string header;
+  if (format == kHepMC3)
+    header = "HepMC::Version 3.02.05\nHepMC::Asciiv3-START_EVENT_LISTING\n";
+  else
+    header = "#!OSCAR2013 particle_lists t x y z mass p0 px py pz pdg ID charge\n"
+             "# Units: fm fm fm fm GeV GeV GeV GeV GeV none none e\n"
+             "# " PROGNAME " " VERSION "\n";
+  fwrite(header.data(), 1, header.size(), ofile);
+
+  // Pipeline: free batches -> main thread (reading) -> formatters ->
+  // ordered writer -> free batches. Batches in flight never exceed
+  // nbatches, so a formatted batch goes to the slot seq % nbatches.
+  const std::size_t nbatches = 2 * nthreads + 2;
+  std::vector<ExpBatch> batches(nbatches);
+  std::vector<ExpBatch*> ring(nbatches, (ExpBatch*)0);
+  std::mutex ringMutex;
+  std::condition_variable ringReady;
+  int formattersLeft = nthreads;
+  McBoundedQueue<ExpBatch*> freeBatches(nbatches);
+  McBoundedQueue<ExpBatch*> toFormat(nbatches);
+  for (std::size_t i = 0; i < nbatches; ++i)
+    freeBatches.push(&batches[i]);
+
+  std::vector<std::thread> formatters;
+  for (int i = 0; i < nthreads; ++i)
+  {
+    formatters.push_back(std::thread([&]() {
+      ExpBatch *batch;
+      while (toFormat.pop(batch))
+      {
+        format_batch(*batch, format);
+        std::lock_guard<std::mutex> lock(ringMutex);
+        ring[batch->seq % nbatches] = batch;
+        ringReady.notify_all();
+      }
+      std::lock_guard<std::mutex> lock(ringMutex);
+      --formattersLeft;
+      ringReady.notify_all();
+    }));
+  }
+
+  long long nbytes = 0;
+  std::thread writer([&]() {
+    for (long seq = 0; ; ++seq)
+    {
+      ExpBatch *batch = 0;
+      {
+        std::unique_lock<std::mutex> lock(ringMutex);
+        ringReady.wait(lock, [&]() { return ring[seq % nbatches] || formattersLeft == 0; });
+        batch = ring[seq % nbatches];
+        ring[seq % nbatches] = 0;
+      }
+      if (!batch)
+        break;
+      if (fwrite(batch->text.data(), 1, batch->text.size(), ofile) != batch->text.size())
+        ERR(1, "cannot write to %s", ofname);
+      nbytes += batch->text.size();
+      freeBatches.push(batch);
+    }
+  });
+
+  // Read events.
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  std::map<int, int> charges;
+  std::vector<int> position;
+  long seq = 0;
+  Long64_t nread = 0;
+  ExpBatch *batch = 0;
+  for (Long64_t iEntry = 0; iEntry < nentries; ++iEntry)
+  {
+    if (!reader.loadEntry(iEntry))
+      break;
+    if (!batch)
+    {
+      freeBatches.pop(batch);
+      batch->seq = seq++;
+      batch->events.clear();
+      batch->particles.clear();
+    }
+    copy_event(*batch, charges, position);
+    ++nread;
+    if (batch->events.size() == BATCH_EVENTS)
+    {
+      toFormat.push(batch);
+      batch = 0;
+    }
+  }
+  if (batch)
+    toFormat.push(batch);
+  toFormat.close();
+  for (std::size_t i = 0; i < formatters.size(); ++i)
+    formatters[i].join();
+  writer.join();
+  reader.Finish();
+
+  // Footer.
+  if (format == kHepMC3)
+  {
+    const char footer[] = "HepMC::Asciiv3-END_EVENT_LISTING\n";
+    fwrite(footer, 1, sizeof(footer) - 1, ofile);
+  }
+  if (ofile != stdout)
+    fclose(ofile);
+  else
+    fflush(ofile);
+
+  double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+  std::cerr << PROGNAME ": " << nread << " events, " << nbytes / (1024. * 1024.)
+            << " MB in " << seconds << " s" << std::endl;
+  return EXIT_SUCCESS;
+}
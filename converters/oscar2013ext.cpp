@@ -25,6 +25,7 @@
 #include <string>
 #include <map>
 #include <cstdint>
+#include <limits>
 
 // ROOT headers
 #include <TObject.h>
@@ -44,6 +45,7 @@
 #include "McPIDConverter.h"
 #include "McArrays.h"
 #include "McDstCut.h"
+#include "McConverters.h"
 
 // There is only one namespace is used. So make it default.
 using namespace std;
@@ -64,8 +66,9 @@ using namespace std;
 #define VERSION "1.0"
 #define OFILE_DEFAULT "out_oscar2013.root"
 
+#ifndef MCDST_CONVERTER_NO_MAIN
 // Options for getopt.
-struct option longopts[] =
+static struct option longopts[] =
 {
   { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
   { .name = "ifname", .has_arg = 1, .flag = 0, .val = 'i' },
@@ -77,7 +80,7 @@ struct option longopts[] =
 };
 
 // Output help string.
-void
+static void
 help_me()
 {
   const char *hstr =                                                    \
@@ -101,7 +104,7 @@ help_me()
   Simple hash function to compare 4 bytes char arrays.  If char array
   are more than 4 bytes long it could results in hash collisions.
 */
-uint32_t
+static uint32_t
 hash4(char *s)
 {
   uint32_t hash = 0;
@@ -110,93 +113,34 @@ hash4(char *s)
     hash = (hash << 8) | (uint32_t)*s;
   return hash;
 }
+#endif // MCDST_CONVERTER_NO_MAIN
 
+/*
+  Convert nev events of the OSCAR 2013 extended file ifname to the McDst
+  file ofname. Return number of converted events.
+*/
 int
-main(int argc, char *argv[])
+oscar2013ext(const char *ifname, const char *ofname, int nev,
+             int ofnameCompLevel, int ofnameCompAlgo)
 {
-  const char optstring[] = "hi:o:e:"; // This string must be sync with a struct option array.
   char line[MAX_LINE_LENGTH];
-  int opt, nev;
-  char *ifname = 0;
-  char *ofname = OFILE_DEFAULT; // FIXME: ISO C++ forbids converting a string constant to ‘char*’
   TFile *ofile = 0;
   FILE *ifile;
   TTree *tree = 0;
-#if defined(ROOT_VERSION_CODE) && defined(ROOT_VERSION)
-#  if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0) // ROOT 5.
-  int ofnameCompLevel = 7;
-#  else // ROOT 6.
-  int ofnameCompLevel = ROOT::RCompressionSetting::ELevel::kDefaultLZMA;
-#  endif
-#else
-#  error "Could not find ROOT_VERSION_CODE or ROOT_VERSION macros."
-#endif
-  int ofnameCompAlgo = ROOT::kLZMA; // Use LZMA by default.
   int treeAutoSave = -(4 << 20); /* Do auto save each 4 MB == 4^20 Bytes.
                                     Minus stands for bytes limit rather than number of entries. */
   TClonesArray *mcArrays[McArrays::NAllMcArrays];
-  // Precalculated hashes.
-  const uint32_t lzma = 2053988608; // hash4("lzma")
-  const uint32_t zlib = 1818845696; // hash4("zlib")
-  const uint32_t lz4 = 8008704; // hash4("lz4")
   // Preselection cut class.
   McDstCut cut;
-
-  // Parse command line arguments.
-  if (argc <= 1)
-    ERR(1, "For the help message try: %s --help", PROGNAME);
-
-  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
-  {
-    switch (opt)
-    {
-    case 'h':
-      help_me();
-      break;
-    case 'i':
-      ifname = optarg;
-      break;
-    case 'o':
-      ofname = optarg;
-      break;
-    case 'e':
-      nev = std::stoi(optarg);
-      break;
-    case 0xFF01:
-      ofnameCompLevel = std::stoi(optarg);
-      std::cout << "ofnameCompLevel = " << ofnameCompLevel << std::endl;
-      break;
-    case 0xFF02:
-      switch (hash4(optarg))
-      {
-      case lzma:
-        ofnameCompLevel = ROOT::kLZMA;
-        break;
-      case zlib:
-        ofnameCompLevel = ROOT::kZLIB;
-        break;
-#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0) // ROOT 5.
-      case lz4:
-        ofnameCompLevel = ROOT::kLZ4;
-        break;
-#endif
-      default:
-        std::cout << "Warning: there is no support for " << optarg << " compression algorithm"
-                  << "\nWarning: fallback to the lzma!\n";
-        ofnameCompLevel = ROOT::kLZMA;
-      }
-      break;
-    default:
-      ERR(1, "Wrong option: %c", (char)opt);
-    }
-  }
+  // Number of converted events.
+  int nconv = 0;
 
   // Output file
   ofile = new TFile(ofname, "RECREATE");
   if (!ofile)
     ERR(1, "cannot open output file");
   ofile->SetCompressionLevel(ofnameCompLevel);
-  ofile->SetCompressionLevel(ofnameCompAlgo);
+  ofile->SetCompressionAlgorithm(ofnameCompAlgo);
 
   // Input file
   ifile = fopen(ifname, "r");
@@ -237,7 +181,8 @@ main(int argc, char *argv[])
     // Get number of tracks.
     int tmp, ntrk;
     float impact;
-    fscanf(ifile, "# event %d out %d\n", &tmp, &ntrk);
+    if (fscanf(ifile, "# event %d out %d\n", &tmp, &ntrk) != 2)
+      break; // End of file.
 
     // Clear all arrays.
     for (int i = 0; i < McArrays::NAllMcArrays; mcArrays[i++]->Clear());
@@ -343,9 +288,88 @@ main(int argc, char *argv[])
 
     // Add an event to DST.
     tree->Fill();
+    ++nconv;
   }
 
+  fclose(ifile);
   ofile->Write();
   ofile->Close();
+  return nconv;
+}
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hi:o:e:"; // This string must be sync with a struct option array.
+  int opt, nev = std::numeric_limits<int>::max();
+  char *ifname = 0;
+  char *ofname = OFILE_DEFAULT; // FIXME: ISO C++ forbids converting a string constant to ‘char*’
+#if defined(ROOT_VERSION_CODE) && defined(ROOT_VERSION)
+#  if ROOT_VERSION_CODE < ROOT_VERSION(6,0,0) // ROOT 5.
+  int ofnameCompLevel = 7;
+#  else // ROOT 6.
+  int ofnameCompLevel = ROOT::RCompressionSetting::ELevel::kDefaultLZMA;
+#  endif
+#else
+#  error "Could not find ROOT_VERSION_CODE or ROOT_VERSION macros."
+#endif
+  int ofnameCompAlgo = ROOT::kLZMA; // Use LZMA by default.
+  // Precalculated hashes.
+  const uint32_t lzma = 2053988608; // hash4("lzma")
+  const uint32_t zlib = 1818845696; // hash4("zlib")
+  const uint32_t lz4 = 8008704; // hash4("lz4")
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'i':
+      ifname = optarg;
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'e':
+      nev = std::stoi(optarg);
+      break;
+    case 0xFF01:
+      ofnameCompLevel = std::stoi(optarg);
+      break;
+    case 0xFF02:
+      switch (hash4(optarg))
+      {
+      case lzma:
+        ofnameCompAlgo = ROOT::kLZMA;
+        break;
+      case zlib:
+        ofnameCompAlgo = ROOT::kZLIB;
+        break;
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0) // ROOT 5.
+      case lz4:
+        ofnameCompAlgo = ROOT::kLZ4;
+        break;
+#endif
+      default:
+        std::cout << "Warning: there is no support for " << optarg << " compression algorithm"
+                  << "\nWarning: fallback to the lzma!\n";
+        ofnameCompAlgo = ROOT::kLZMA;
+      }
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+
+  if (oscar2013ext(ifname, ofname, nev, ofnameCompLevel, ofnameCompAlgo) < 0)
+    return EXIT_FAILURE;
   return EXIT_SUCCESS;
 }
+#endif // MCDST_CONVERTER_NO_MAIN
@@ -19,6 +19,11 @@
 #include <string>
 #include <map>
 #include <cstdint>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <functional>
+#include <atomic>
 
 // ROOT headers.
 #include "TObject.h"
@@ -38,6 +43,8 @@
 #include "McPIDConverter.h"
 #include "McArrays.h"
 #include "McDstCut.h"
+#include "McDstParallelWriter.h"
+#include "McBoundedQueue.h"
 
 // Pythia 8 headers.
 #include "Pythia8/Pythia.h"
@@ -77,6 +84,8 @@ struct option longopts[] =
   { .name = "eta-low", .has_arg = 1, .flag = 0, .val = 0xFF07 },
   { .name = "eta-high", .has_arg = 1, .flag = 0, .val = 0xFF08 },
   { .name = "exclude-pdg", .has_arg = 1, .flag = 0, .val = 0xFF09 },
+  { .name = "writer-threads", .has_arg = 1, .flag = 0, .val = 0xFF0A },
+  { .name = "threads", .has_arg = 1, .flag = 0, .val = 0xFF0B },
   { 0, 0, 0, 0 }
 };
 
@@ -104,7 +113,15 @@ help_me()
     --eta-low <low eta cut>         Low edge of the pseudorapidity cut.\n\
     --eta-high <high eta cut>       High edge of the pseudorapidity cut.\n\
     --exclude-pdg <pdg code>        Exclude <pdg code>. Could be defined multiple times\n\
-                                    to exclude multiple particles.\n";
+                                    to exclude multiple particles.\n\
+    --writer-threads <N>            Serialize and compress events in <N> threads\n\
+                                    and merge them into the output file. Events are\n\
+                                    stored in blocks, use McEvent::eventNr() for order.\n\
+                                    Cannot be combined with --threads.\n\
+    --threads <N>                   Run <N> independent Pythia 8 instances. Instance k\n\
+                                    (k = 0..N-1) uses seed <SEED>+k and generates events\n\
+                                    with McEvent::eventNr() = k, k+N, k+2N, ... so the result\n\
+                                    is reproducible for a given <SEED> and <N>.\n";
 
   std::cout << hstr;
   exit(EXIT_SUCCESS);
@@ -124,6 +141,355 @@ hash4(char *s)
   return hash;
 }
 
+/*
+  Convert the current Pythia 8 event to McDst. Args:
+  * pythia - generator that holds the event.
+  * hion - Angantyr model (nullptr if the beams are not nuclei).
+  * iev - event number.
+  * onlyFinal - if not 0 then skip not final particles.
+  * cut - particle preselection.
+  * mcArrays - McDst arrays to fill. They must be cleared before.
+*/
+void
+fill_event(Pythia8::Pythia &pythia, Pythia8::Angantyr *hion, int iev,
+           int onlyFinal, McDstCut &cut, TClonesArray **mcArrays)
+{
+  // Get event.
+  const Pythia8::Event &ev = pythia.event;
+  // Set McEvent. FIXME: check nullptr.
+  TClonesArray *mcEvCol = mcArrays[McArrays::Event];
+  McEvent *mcEv = new ((*mcEvCol)[mcEvCol->GetEntries()]) McEvent();
+  mcEv->setEventNr(iev);
+  mcEv->setB(hion ? hion->hiinfo.b() : 0.);
+  mcEv->setPhi(0.0); // 0 in Pythia 8.
+  mcEv->setNes(0);
+  mcEv->setComment(0);
+  mcEv->setStepNr(0);
+  mcEv->setStepT(0);
+
+  // Set McTrack.
+  int ntrk = ev.size();
+  for (int itrk = 0; itrk < ntrk; ++itrk)
+  {
+    int status = ev[itrk].status();
+    int decay = -1; /* -1 means not decayed, see McParticle.h for
+                        more details. But there is no more
+                        details... :( */
+    int parent = 0;
+    int parent_decay = 0;
+    int mate = 0;
+    int child[2] = {0};
+
+    // Skip beam particles.
+    if (abs(status) < 19)
+      continue;
+
+    // Optionally do skip not final particles.
+    if (status < 0)
+    {
+      if (onlyFinal)
+        continue;
+      decay = 0;
+    }
+
+    /*
+      From the Pythia 8 docs (this information should be here[1]):
+
+      1. mother1 = mother2 = 0: for lines 0 - 2, where line 0
+      represents the event as a whole, and 1 and 2 the two
+      incoming beam particles;
+
+      2. mother1 = mother2 > 0: the particle is a "carbon copy" of
+      its mother, but with changed momentum as a "recoil" effect,
+      e.g. in a shower;
+
+      3. mother1 > 0, mother2 = 0: the "normal" mother case, where
+      it is meaningful to speak of one single mother to several
+      products, in a shower or decay;
+
+      4. mother1 < mother2, both > 0, for abs(status) = 81 - 86:
+      primary hadrons produced from the fragmentation of a string
+      spanning the range from mother1 to mother2, so that all
+      partons in this range should be considered mothers; and
+      analogously for abs(status) = 101 - 106, the formation of
+      R-hadrons;
+
+      5. mother1 < mother2, both > 0, except case 4: particles
+      with two truly different mothers, in particular the
+      particles emerging from a hard 2 → n interaction.
+
+      6. mother2 < mother1, both > 0: particles with two truly
+      different mothers, notably for the special case that two
+      nearby partons are joined together into a status 73 or 74
+      new parton, in the g + q → q case the q is made first mother
+      to simplify flavour tracing.
+
+      We are consider only "normal" mother case (3).
+
+      [1] http://home.thep.lu.se/~torbjorn/pythia82html/Welcome.html
+    */
+    int mother1 = ev[itrk].mother1();
+    int mother2 = ev[itrk].mother2();
+
+    /*
+       Don't nervous about goto statements.
+       We use goto here as it is actually make code easier and lighter. 
+     */
+    // Normal daughter
+    if (mother1 > 0 && mother2 == 0)
+    {
+      parent = mother1;
+      goto l_aft_mcmp;
+    }
+    // HBT case
+    if (mother1 == mother2 && status == 99)
+      goto l_aft_mcmp;
+    // In other cases go to the next iteration step
+    continue;
+l_aft_mcmp:
+
+    /*
+      This was taken from the same source as for mothers description:
+      1. daughter1 = daughter2 = 0: there are no daughters (so far);
+
+      2. daughter1 = daughter2 > 0: the particle has a "carbon copy"
+      as its sole daughter, but with changed momentum as a "recoil"
+      effect, e.g. in a shower;
+
+      3. daughter1 > 0, daughter2 = 0: each of the incoming beams
+      has only (at most) one daughter, namely the initiator parton
+      of the hardest interaction; further, in a 2 → 1 hard
+      interaction, like q qbar → Z^0, or in a clustering of two
+      nearby partons, the initial partons only have this one
+      daughter;
+
+      4. daughter1 < daughter2, both > 0: the particle has a range
+      of decay products from daughter1 to daughter2;
+
+      5. daughter2 < daughter1, both > 0: the particle has two
+      separately stored decay products (e.g. in backwards evolution
+      of initial-state showers).
+
+      We are consider only forth case where:
+      mother -> daughter1 + ... + daughter2
+      here, daughter2 - daughter1 must equals to 1. In that case
+      only 2 daughter are produced.
+    */
+    int daughter1 = ev[itrk].daughter1();
+    int daughter2 = ev[itrk].daughter2();
+    if (daughter1 != 0 || daughter2 != 0)
+    {
+      if (daughter2 - daughter1 == 1 && daughter1 < daughter2 && daughter1 > 0)
+      {
+        child[0] = daughter1;
+        child[1] = daughter2;
+      }
+      else
+      {
+        continue;
+      }
+    }
+    int index = ev[itrk].index();
+    int pdg = ev[itrk].id();
+    float px = ev[itrk].px();
+    float py = ev[itrk].py();
+    float pz = ev[itrk].pz();
+    float e = ev[itrk].e();
+    TLorentzVector v(ev[itrk].px(), ev[itrk].py(), ev[itrk].pz(), ev[itrk].e());
+    float x = ev[itrk].xProd()*1e-12; // In Pythia 8 these values in mm (mm/c).
+    float y = ev[itrk].yProd()*1e-12; // Convert mm (and mm/c) to fm (fm/c).
+    float z = ev[itrk].zProd()*1e-12; // It should be zero for primary particles - i.e. not from
+    float t = ev[itrk].tProd()*1e-12; // decayed particle.
+
+    // Check particle cut.
+    if (!cut.isGoodParticle(v, pdg))
+    {
+      continue;
+    }
+
+    // Add new track. FIXME: check nullptr.
+    TClonesArray *mcTrkCol = mcArrays[McArrays::Particle];
+    new ((*mcTrkCol)[mcTrkCol->GetEntries()]) McParticle(index, pdg, status, parent,
+                                                         parent_decay, mate-1, decay, child,
+                                                         px, py, pz, e, x, y, z, t);
+  }
+}
+
+/*
+  Read settings and set random seed of a Pythia 8 instance. Args:
+  * pythia - generator to configure.
+  * pills - options passed with --pythia-option.
+  * ifile - Pythia 8 configuration file.
+  * seed - random seed.
+*/
+void
+configure_pythia(Pythia8::Pythia &pythia, const std::vector<std::string> &pills,
+                 const char *ifile, long seed)
+{
+  /*
+    One pill makes you larger
+    And one pill makes you small
+    And the ones that mother gives you
+    Don't do anything at all
+    Go ask Alice
+    When she's ten feet tall
+
+    Choose pills with a caution!
+    But not forget what Dormouse said.
+    Feed your head!
+  */
+  for (std::vector<std::string>::const_iterator pill = pills.begin(); pill != pills.end(); ++pill)
+  {
+    pythia.readString(pill->c_str());
+  }
+  pythia.readFile(ifile);
+  pythia.readString("Random:setSeed = on");
+  pythia.readString("Random:seed = " + std::to_string(seed));
+}
+
+/*
+  Set hion to the Angantyr model of the initialized generator or to
+  nullptr if the beams are not nuclei. Return false if the beams are
+  nuclei but there is no Angantyr model.
+*/
+bool
+angantyr(Pythia8::Pythia &pythia, Pythia8::Angantyr *&hion)
+{
+  hion = nullptr;
+  // If beams are not nuclei then do not set Agantyr
+  if (pythia.beamA.id() >= (int)1e9 && pythia.beamB.id() >= (int)1e9)
+  {
+    hion = (Pythia8::Angantyr *)pythia.getHeavyIonsPtr();
+    if (!hion)
+    {
+      ERR(0, "cannot work with Agantyr model");
+      return false;
+    }
+  }
+  return true;
+}
+
+/*
+  Random seed of the k-th generator thread. It is seed + k wrapped into
+  the 1..900000000 range accepted by Pythia 8 (0 would mean a seed from
+  the time).
+*/
+long
+thread_seed(long seed, int k)
+{
+  const long maxSeed = 900000000;
+  long s = (seed + k - 1) % maxSeed;
+  if (s < 0)
+    s += maxSeed;
+  return s + 1;
+}
+
+/*
+  Body of the k-th of nthreads generator threads. The thread runs its
+  own Pythia 8 instance with the seed thread_seed(seed, k) and generates
+  events number k, k + nthreads, k + 2*nthreads, ... < nev. Thus the
+  content of every McEvent::eventNr() depends only on the seed and the
+  number of threads. Events are serialized and compressed in this
+  thread and merged into the output in blocks. If the generator cannot
+  be set up, failed is raised and all threads stop; main exits after
+  joining them.
+*/
+void
+generate_in_thread(int k, int nthreads, int nev, const char *xmldoc,
+                   const std::vector<std::string> &pills, const char *ifile,
+                   long seed, int onlyFinal, const McDstCut &cut,
+                   McDstParallelWriter &writer, std::atomic<bool> &failed)
+{
+  Pythia8::Pythia pythia(xmldoc, false);
+  configure_pythia(pythia, pills, ifile, thread_seed(seed, k));
+  Pythia8::Angantyr *hion = nullptr;
+  if (!pythia.init())
+  {
+    ERR(0, "cannot initialize Pythia 8 in thread %d", k);
+    failed = true;
+    return;
+  }
+  if (!angantyr(pythia, hion))
+  {
+    failed = true;
+    return;
+  }
+
+  // McDstCut is not thread-safe. Use own copy.
+  McDstCut threadCut(cut);
+  std::unique_ptr<McDstParallelWriter::Slot> slot = writer.createSlot();
+  TClonesArray *mcArrays[McArrays::NAllMcArrays];
+  for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+    mcArrays[i] = slot->array(i);
+
+  for (int iev = k; iev < nev && !failed; iev += nthreads)
+  {
+    // Generate event.
+    pythia.next();
+    slot->clear();
+    fill_event(pythia, hion, iev, onlyFinal, threadCut, mcArrays);
+    slot->fill();
+  }
+}
+
+/*
+  Generate events in the calling thread and let nthreads writer threads
+  serialize and compress them. Events travel through a pool of writer
+  slots: the generator fills a free slot, a writer thread fills the slot
+  tree (baskets are compressed there) and returns the slot to the pool.
+*/
+void
+generate_with_writers(Pythia8::Pythia &pythia, Pythia8::Angantyr *hion, int nev,
+                      int onlyFinal, McDstCut &cut, McDstParallelWriter &writer,
+                      int nthreads)
+{
+  // One extra slot is filled by the generator while all writers are busy.
+  const int nslots = nthreads + 1;
+  std::vector<std::unique_ptr<McDstParallelWriter::Slot>> slots;
+  McBoundedQueue<McDstParallelWriter::Slot *> freeSlots(nslots);
+  McBoundedQueue<McDstParallelWriter::Slot *> filledSlots(nslots);
+  for (int i = 0; i < nslots; ++i)
+  {
+    slots.push_back(writer.createSlot());
+    freeSlots.push(slots.back().get());
+  }
+
+  std::vector<std::thread> writers;
+  for (int i = 0; i < nthreads; ++i)
+  {
+    writers.emplace_back([&freeSlots, &filledSlots]()
+    {
+      McDstParallelWriter::Slot *slot = nullptr;
+      while (filledSlots.pop(slot))
+      {
+        slot->fill();
+        freeSlots.push(slot);
+      }
+    });
+  }
+
+  TClonesArray *mcArrays[McArrays::NAllMcArrays];
+  for (int iev = 0; iev < nev; ++iev)
+  {
+    // Generate event.
+    pythia.next();
+    // Take a free slot and convert event into it.
+    McDstParallelWriter::Slot *slot = nullptr;
+    freeSlots.pop(slot);
+    slot->clear();
+    for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+      mcArrays[i] = slot->array(i);
+    fill_event(pythia, hion, iev, onlyFinal, cut, mcArrays);
+    filledSlots.push(slot);
+  }
+
+  filledSlots.close();
+  for (std::vector<std::thread>::iterator it = writers.begin(); it != writers.end(); ++it)
+    it->join();
+  // Slots send the rest of their baskets to the merger on destruction.
+  slots.clear();
+}
+
 int
 main(int argc, char *argv[])
 {
@@ -158,6 +524,10 @@ main(int argc, char *argv[])
   McDstCut cut;
   // Heavy ion collision class.
   Pythia8::Angantyr *hion = nullptr;
+  // Number of threads that compress the output (0 - write in the main thread).
+  int writerThreads = 0;
+  // Number of generator threads.
+  int nthreads = 1;
 
   // Parse command line arguments.
   if (argc <= 1)
@@ -184,26 +554,25 @@ main(int argc, char *argv[])
       break;
     case 0xFF01:
       ofileCompLevel = std::stoi(optarg);
-      std::cout << "ofileCompLevel = " << ofileCompLevel << std::endl;
       break;
     case 0xFF02:
       switch (hash4(optarg))
       {
       case lzma:
-        ofileCompLevel = ROOT::kLZMA;
+        ofileCompAlgo = ROOT::kLZMA;
         break;
       case zlib:
-        ofileCompLevel = ROOT::kZLIB;
+        ofileCompAlgo = ROOT::kZLIB;
         break;
 #if ROOT_VERSION_CODE >= ROOT_VERSION(6,0,0) // ROOT 5.
       case lz4:
-        ofileCompLevel = ROOT::kLZ4;
+        ofileCompAlgo = ROOT::kLZ4;
         break;
 #endif
       default:
         std::cout << "Warning: there is no support for " << optarg << " compression algorithm"
                   << "\nWarning: fallback to the lzma!\n";
-        ofileCompLevel = ROOT::kLZMA;
+        ofileCompAlgo = ROOT::kLZMA;
       }
       break;
     case 0xFF03:
@@ -227,52 +596,74 @@ main(int argc, char *argv[])
     case 0xFF09:
       cut.excludePdg(std::stoi(optarg));
       break;
+    case 0xFF0A:
+      writerThreads = std::stoi(optarg);
+      break;
+    case 0xFF0B:
+      nthreads = std::stoi(optarg);
+      break;
     default:
       ERR(1, "Wrong option: %c", (char)opt);
     }
   }
 
-  // Initialize Pythia 8.
-  Pythia8::Pythia pythia(xmldoc, false);
-  /*
-    One pill makes you larger
-    And one pill makes you small
-    And the ones that mother gives you
-    Don't do anything at all
-    Go ask Alice
-    When she's ten feet tall
+  if (nthreads > 1 && writerThreads > 0)
+    ERR(1, "--writer-threads cannot be combined with --threads, generator threads compress their own events");
 
-    Choose pills with a caution!
-    But not forget what Dormouse said.
-    Feed your head!
-  */
-  for (std::vector<std::string>::iterator pill = pills.begin(); pill != pills.end(); ++pill)
-  {
-    pythia.readString(pill->c_str());
-  }
-  pythia.readFile(ifile);
-  pythia.readString("Random:setSeed = on");
-  std::string sseed = "Random:seed = ";
+  // Get random seed.
+  long seed;
   if (rnd)
   { // Set random seed manually.
-    sseed += rnd;
+    seed = std::stol(rnd);
   }
   else
   { // Get random seed from time.
     srand(time(NULL));
-    int seed = int(((float)rand()/RAND_MAX)*900000000.); // 900000000 is a maximum possible seed in Pythia 8.
-    sseed += std::to_string(seed);
+    seed = long(((float)rand()/RAND_MAX)*900000000.); // 900000000 is a maximum possible seed in Pythia 8.
+  }
+
+  // Initialize Pythia 8.
+  Pythia8::Pythia pythia(xmldoc, false);
+  configure_pythia(pythia, pills, ifile, seed);
+  nev = pythia.mode("Main:numberOfEvents");
+
+  if (nthreads > 1)
+  { // Every thread runs its own generator and compresses its own baskets.
+    std::cout << PROGNAME ": " << nthreads << " generator threads, base seed " << seed << std::endl;
+    std::atomic<bool> failed(false);
+    {
+      McDstParallelWriter writer(ofile,
+                                 ROOT::CompressionSettings((ROOT::ECompressionAlgorithm)ofileCompAlgo,
+                                                           ofileCompLevel),
+                                 "Pythia 8 tree");
+      std::vector<std::thread> generators;
+      for (int k = 0; k < nthreads; ++k)
+      {
+        generators.emplace_back(generate_in_thread, k, nthreads, nev, xmldoc,
+                                std::cref(pills), ifile, seed, onlyFinal,
+                                std::cref(cut), std::ref(writer), std::ref(failed));
+      }
+      for (std::vector<std::thread>::iterator it = generators.begin(); it != generators.end(); ++it)
+        it->join();
+    }
+    if (failed)
+      ERR(1, "generation failed, %s is incomplete", ofile);
+    return EXIT_SUCCESS;
   }
-  pythia.readString(sseed);
 
   // Setting up Pythia 8.
   pythia.init();
-  // If beams are not nuclei then do not set Agantyr
-  if (pythia.beamA.id() >= (int)1e9 && pythia.beamB.id() >= (int)1e9)
-  {
-    hion = (Pythia8::Angantyr *)pythia.getHeavyIonsPtr();
-    if (!hion)
-        ERR(1, "cannot work with Agantyr model");
+  if (!angantyr(pythia, hion))
+    exit(EXIT_FAILURE);
+
+  if (writerThreads > 0)
+  { // Baskets are compressed in the writer threads and merged into the output file.
+    McDstParallelWriter writer(ofile,
+                               ROOT::CompressionSettings((ROOT::ECompressionAlgorithm)ofileCompAlgo,
+                                                         ofileCompLevel),
+                               "Pythia 8 tree");
+    generate_with_writers(pythia, hion, nev, onlyFinal, cut, writer, writerThreads);
+    return EXIT_SUCCESS;
   }
 
   // Setting up McDst.
@@ -280,7 +671,7 @@ main(int argc, char *argv[])
   if (!outFile)
     ERR(1, "cannot open output file");
   outFile->SetCompressionLevel(ofileCompLevel);
-  outFile->SetCompressionLevel(ofileCompAlgo);
+  outFile->SetCompressionAlgorithm(ofileCompAlgo);
   McEvent::Class()->IgnoreTObjectStreamer();
   McParticle::Class()->IgnoreTObjectStreamer();
   McRun::Class()->IgnoreTObjectStreamer();
@@ -299,172 +690,14 @@ main(int argc, char *argv[])
   }
 
   // Main loop.
-  nev = pythia.mode("Main:numberOfEvents");
   for (int iev = 0; iev < nev; ++iev)
   {
     // Generate event.
     pythia.next();
     // Clear all arrays.
     for (int i = 0; i < McArrays::NAllMcArrays; mcArrays[i++]->Clear());
-    // Get event.
-    const Pythia8::Event &ev = pythia.event;
-    // Set McEvent. FIXME: check nullptr.
-    TClonesArray *mcEvCol = mcArrays[McArrays::Event];
-    McEvent *mcEv = new ((*mcEvCol)[mcEvCol->GetEntries()]) McEvent();
-    mcEv->setEventNr(iev);
-    mcEv->setB(hion ? hion->hiinfo.b() : 0.);
-    mcEv->setPhi(0.0); // 0 in Pythia 8.
-    mcEv->setNes(0);
-    mcEv->setComment(0);
-    mcEv->setStepNr(0);
-    mcEv->setStepT(0);
-
-    // Set McTrack.
-    int ntrk = ev.size();
-    for (int itrk = 0; itrk < ntrk; ++itrk)
-    {
-      int status = ev[itrk].status();
-      int decay = -1; /* -1 means not decayed, see McParticle.h for
-                          more details. But there is no more
-                          details... :( */
-      int parent = 0;
-      int parent_decay = 0;
-      int mate = 0;
-      int child[2] = {0};
-
-      // Skip beam particles.
-      if (abs(status) < 19)
-        continue;
-
-      // Optionally do skip not final particles.
-      if (status < 0)
-      {
-        if (onlyFinal)
-          continue;
-        decay = 0;
-      }
-
-      /*
-        From the Pythia 8 docs (this information should be here[1]):
-
-        1. mother1 = mother2 = 0: for lines 0 - 2, where line 0
-        represents the event as a whole, and 1 and 2 the two
-        incoming beam particles;
-
-        2. mother1 = mother2 > 0: the particle is a "carbon copy" of
-        its mother, but with changed momentum as a "recoil" effect,
-        e.g. in a shower;
-
-        3. mother1 > 0, mother2 = 0: the "normal" mother case, where
-        it is meaningful to speak of one single mother to several
-        products, in a shower or decay;
-
-        4. mother1 < mother2, both > 0, for abs(status) = 81 - 86:
-        primary hadrons produced from the fragmentation of a string
-        spanning the range from mother1 to mother2, so that all
-        partons in this range should be considered mothers; and
-        analogously for abs(status) = 101 - 106, the formation of
-        R-hadrons;
-
-        5. mother1 < mother2, both > 0, except case 4: particles
-        with two truly different mothers, in particular the
-        particles emerging from a hard 2 → n interaction.
-
-        6. mother2 < mother1, both > 0: particles with two truly
-        different mothers, notably for the special case that two
-        nearby partons are joined together into a status 73 or 74
-        new parton, in the g + q → q case the q is made first mother
-        to simplify flavour tracing.
-
-        We are consider only "normal" mother case (3).
-
-        [1] http://home.thep.lu.se/~torbjorn/pythia82html/Welcome.html
-      */
-      int mother1 = ev[itrk].mother1();
-      int mother2 = ev[itrk].mother2();
-
-      /*
-         Don't nervous about goto statements.
-         We use goto here as it is actually make code easier and lighter. 
-       */
-      // Normal daughter
-      if (mother1 > 0 && mother2 == 0)
-      {
-        parent = mother1;
-        goto l_aft_mcmp;
-      }
-      // HBT case
-      if (mother1 == mother2 && status == 99)
-        goto l_aft_mcmp;
-      // In other cases go to the next iteration step
-      continue;
-l_aft_mcmp:
-
-      /*
-        This was taken from the same source as for mothers description:
-        1. daughter1 = daughter2 = 0: there are no daughters (so far);
-
-        2. daughter1 = daughter2 > 0: the particle has a "carbon copy"
-        as its sole daughter, but with changed momentum as a "recoil"
-        effect, e.g. in a shower;
-
-        3. daughter1 > 0, daughter2 = 0: each of the incoming beams
-        has only (at most) one daughter, namely the initiator parton
-        of the hardest interaction; further, in a 2 → 1 hard
-        interaction, like q qbar → Z^0, or in a clustering of two
-        nearby partons, the initial partons only have this one
-        daughter;
-
-        4. daughter1 < daughter2, both > 0: the particle has a range
-        of decay products from daughter1 to daughter2;
-
-        5. daughter2 < daughter1, both > 0: the particle has two
-        separately stored decay products (e.g. in backwards evolution
-        of initial-state showers).
-
-        We are consider only forth case where:
-        mother -> daughter1 + ... + daughter2
-        here, daughter2 - daughter1 must equals to 1. In that case
-        only 2 daughter are produced.
-      */
-      int daughter1 = ev[itrk].daughter1();
-      int daughter2 = ev[itrk].daughter2();
-      if (daughter1 != 0 || daughter2 != 0)
-      {
-        if (daughter2 - daughter1 == 1 && daughter1 < daughter2 && daughter1 > 0)
-        {
-          child[0] = daughter1;
-          child[1] = daughter2;
-        }
-        else
-        {
-          continue;
-        }
-      }
-      int index = ev[itrk].index();
-      int pdg = ev[itrk].id();
-      float px = ev[itrk].px();
-      float py = ev[itrk].py();
-      float pz = ev[itrk].pz();
-      float e = ev[itrk].e();
-      TLorentzVector v(ev[itrk].px(), ev[itrk].py(), ev[itrk].pz(), ev[itrk].e());
-      float x = ev[itrk].xProd()*1e-12; // In Pythia 8 these values in mm (mm/c).
-      float y = ev[itrk].yProd()*1e-12; // Convert mm (and mm/c) to fm (fm/c).
-      float z = ev[itrk].zProd()*1e-12; // It should be zero for primary particles - i.e. not from
-      float t = ev[itrk].tProd()*1e-12; // decayed particle.
-
-      // Check particle cut.
-      if (!cut.isGoodParticle(v, pdg))
-      {
-        continue;
-      }
-
-      // Add new track. FIXME: check nullptr.
-      TClonesArray *mcTrkCol = mcArrays[McArrays::Particle];
-      new ((*mcTrkCol)[mcTrkCol->GetEntries()]) McParticle(index, pdg, status, parent,
-                                                           parent_decay, mate-1, decay, child,
-                                                           px, py, pz, e, x, y, z, t);
-    }
+    // Convert event.
+    fill_event(pythia, hion, iev, onlyFinal, cut, mcArrays);
     // Add an event to DST.
     tree->Fill();
   }
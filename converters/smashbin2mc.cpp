@@ -0,0 +1,524 @@
+/*
+  vim:et:sw=2:
+
+  smashbin2mc converts SMASH binary OSCAR output (e.g. particles_binary.bin)
+  to the McDst format.
+
+  The input file is mapped to memory and particle lines are read in place
+  through packed structures, so there is no intermediate copy and no text
+  parsing. Each particle block ('p') becomes one McDst event (time step).
+  Blocks of an event are kept as positions in the mapped file until its
+  end of event block ('f'), so all time steps get the event number and
+  the impact parameter. Interaction blocks ('i') are skipped.
+
+  For the extended format variant the particles are propagated back to
+  the point of the last interaction (kinetic freeze-out) exactly as it is
+  done by oscar2013ext for the ASCII format.
+
+  Layout of the file (numbers are little-endian):
+    header: char magic[4] = "SMSH", uint16 format_version,
+            uint16 format_variant (0 - default, 1 - extended),
+            uint32 len, char smash_version[len]
+    'p' block: char 'p', [int32 event, int32 ensemble,] uint32 n, n particle lines
+    'i' block: char 'i', uint32 nin, uint32 nout, [int32 event, int32 ensemble,]
+               double rho, double sigma, double sigma_partial,
+               uint32 process_type, nin + nout particle lines
+    'f' block: char 'f', uint32 event, [uint32 ensemble,] double impact,
+               [char empty_event]
+  Fields in brackets depend on the format version (see make_layout).
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+// mmap
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <string>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+// ROOT headers
+#include <TObject.h>
+#include <TFile.h>
+#include <TTree.h>
+#include <TString.h>
+#include <TClonesArray.h>
+#include <Compression.h>
+#include <TLorentzVector.h>
+
+// McDst headers
+#include "McRun.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McArrays.h"
+#include "McDstCut.h"
+#include "McConverters.h"
+
+// There is only one namespace is used. So make it default.
+using namespace std;
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "smashbin2mc.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "smashbin2mc"
+#define VERSION "1.0"
+#define OFILE_DEFAULT "out_smash.mcDst.root"
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+// Options for getopt.
+static struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "ifname", .has_arg = 1, .flag = 0, .val = 'i' },
+  { .name = "ofname", .has_arg = 1, .flag = 0, .val = 'o' },
+  { .name = "events", .has_arg = 1, .flag = 0, .val = 'e' },
+  { .name = "compression-level", .has_arg = 1, .flag = 0, .val = 0xFF01 },
+  { .name = "compression-algo", .has_arg = 1, .flag = 0, .val = 0xFF02 },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+static void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " SMASH binary OSCAR to McDst converter\n"    \
+    "Usage: " PROGNAME " [Options]\n"                                   \
+    "Options:\n\
+    -h, --help                        help\n\
+    -i, --ifname <filename>           input SMASH binary file\n\
+    -e, --events <number of events>   number of events to read\n\
+    -o, --ofname <filename>           output file (default: " OFILE_DEFAULT ")\n\
+    --compression-level <level>       set compression level to <level>.\n\
+                                      valid levels are from 1 (low) 9 (high).\n\
+    --compression-algo <aglorithm>    set compression algorithm to <algorithm>\n\
+                                      possible values are zlib, lz4 (only for ROOT > 6), lzma\n";
+
+  cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+/*
+  Simple hash function to compare 4 bytes char arrays.  If char array
+  are more than 4 bytes long it could results in hash collisions.
+*/
+static uint32_t
+hash4(char *s)
+{
+  uint32_t hash = 0;
+
+  while (*s++)
+    hash = (hash << 8) | (uint32_t)*s;
+  return hash;
+}
+#endif // MCDST_CONVERTER_NO_MAIN
+
+#pragma pack(push, 1)
+// Particle line of the default format variant.
+struct SmashParticle
+{
+  double t, x, y, z;
+  double mass;
+  double e, px, py, pz;
+  int32_t pdg;
+  int32_t id;
+  int32_t charge;
+};
+
+// Additional fields of the extended format variant.
+struct SmashParticleExt
+{
+  int32_t ncoll;          // number of collisions the particle has undergone
+  double formationTime;
+  double xsecFactor;      // cross section scaling factor
+  int32_t processId;      // id of the process the particle originates from
+  int32_t processType;    // type of the last process
+  double timeLastColl;    // time of the last collision
+  int32_t pdgMother1;
+  int32_t pdgMother2;
+};
+#pragma pack(pop)
+
+// Version dependent sizes of the blocks.
+struct SmashLayout
+{
+  bool extended;
+  std::size_t lineSize;      // size of a particle line
+  std::size_t pHeaderExtra;  // event and ensemble numbers in 'p' block
+  std::size_t iHeaderExtra;  // event and ensemble numbers in 'i' block
+  std::size_t fEnsemble;     // ensemble number in 'f' block
+  std::size_t fEmptyFlag;    // empty event flag in 'f' block
+};
+
+//_________________
+// Return block sizes for the given format version and variant.
+static SmashLayout
+make_layout(int version, int variant)
+{
+  SmashLayout layout;
+  layout.extended = (variant == 1);
+  layout.lineSize = sizeof(SmashParticle);
+  if (layout.extended)
+  {
+    layout.lineSize += sizeof(SmashParticleExt);
+    // Baryon number is appended to the extended lines since version 8,
+    // strangeness since version 10.
+    if (version >= 8)
+      layout.lineSize += sizeof(int32_t);
+    if (version >= 10)
+      layout.lineSize += sizeof(int32_t);
+  }
+  // Ensembles are written since version 7.
+  layout.pHeaderExtra = (version >= 7) ? 2 * sizeof(int32_t) : 0;
+  layout.iHeaderExtra = layout.pHeaderExtra;
+  layout.fEnsemble = (version >= 7) ? sizeof(uint32_t) : 0;
+  layout.fEmptyFlag = (version >= 9) ? sizeof(char) : 0;
+  return layout;
+}
+
+// Read-only view of the mapped file.
+struct SmashCursor
+{
+  const char *p;
+  const char *end;
+
+  bool has(std::size_t n) const { return (std::size_t)(end - p) >= n; }
+  template <class T> T get()
+  {
+    T val;
+    memcpy(&val, p, sizeof(T));
+    p += sizeof(T);
+    return val;
+  }
+};
+
+// Particle block of the mapped file, kept until the end of its event.
+struct SmashSnapshot
+{
+  const char *p;  // first particle line
+  uint32_t ntrk;
+};
+
+//_________________
+// Fill the arrays with the event header and the particles of the block.
+static void
+fill_snapshot(const char *p, uint32_t ntrk, const SmashLayout &layout, McDstCut &cut,
+              TClonesArray **mcArrays, int eventNr, int stepNr, double impact)
+{
+  // Clear all arrays.
+  for (int i = 0; i < McArrays::NAllMcArrays; mcArrays[i++]->Clear());
+  TClonesArray *mcEvCol = mcArrays[McArrays::Event];
+  McEvent *mcEv = new ((*mcEvCol)[mcEvCol->GetEntries()]) McEvent();
+  mcEv->setEventNr(eventNr);
+  mcEv->setB(impact);
+  mcEv->setPhi(0.0);
+  mcEv->setNes(0);
+  mcEv->setComment(0);
+  mcEv->setStepNr(stepNr);
+  mcEv->setStepT(0);
+
+  TClonesArray *mcTrkCol = mcArrays[McArrays::Particle];
+  for (uint32_t itrk = 0; itrk < ntrk; ++itrk, p += layout.lineSize)
+  {
+    const SmashParticle *prt = reinterpret_cast<const SmashParticle*>(p);
+    TLorentzVector momentum(prt->px, prt->py, prt->pz, prt->e);
+
+    // Check particle cut.
+    if (!cut.isGoodParticle(momentum, prt->pdg))
+      continue;
+
+    double x = prt->x, y = prt->y, z = prt->z, t = prt->t;
+    int parent = -1;
+    if (layout.extended)
+    {
+      const SmashParticleExt *ext =
+        reinterpret_cast<const SmashParticleExt*>(p + sizeof(SmashParticle));
+      // r0 = r - v*(t - t0), see oscar2013ext.cpp
+      double dt = (prt->t - ext->timeLastColl) / prt->e;
+      x -= prt->px * dt;
+      y -= prt->py * dt;
+      z -= prt->pz * dt;
+      t = ext->timeLastColl;
+      // Same convention as in oscar2013ext.cpp
+      parent = ext->pdgMother2 ? -1 : ext->pdgMother1;
+    }
+
+    // Workaround for useless T& constructor parameters
+    int index = (int)itrk;
+    int pdg = prt->pdg;
+    int status = 0;
+    int none = -1;
+    int child[2] = {-1, -1};
+    new ((*mcTrkCol)[mcTrkCol->GetEntries()]) McParticle(index,
+                                                         pdg,
+                                                         status,
+                                                         parent,
+                                                         none, // decayed parent id
+                                                         none, // mate
+                                                         none, // decay id
+                                                         child,
+                                                         prt->px, prt->py,
+                                                         prt->pz, prt->e,
+                                                         x, y, z, t);
+  }
+}
+
+/*
+  Convert nev events of the SMASH binary file ifname to the McDst file
+  ofname. Return number of converted events or -1 if the input is not
+  a SMASH binary file.
+*/
+int
+smashbin2mc(const char *ifname, const char *ofname, int nev,
+            int ofnameCompLevel, int ofnameCompAlgo)
+{
+  TFile *ofile = 0;
+  TTree *tree = 0;
+  int treeAutoSave = -(4 << 20); /* Do auto save each 4 MB == 4^20 Bytes.
+                                    Minus stands for bytes limit rather than number of entries. */
+  TClonesArray *mcArrays[McArrays::NAllMcArrays];
+  // Preselection cut class.
+  McDstCut cut;
+  // Number of converted events.
+  int nconv = 0;
+
+  // Map input file
+  int fd = open(ifname, O_RDONLY);
+  if (fd < 0)
+    ERR(1, "cannot open input file %s", ifname);
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0)
+  {
+    close(fd);
+    ERR(1, "cannot stat input file %s", ifname);
+  }
+  std::size_t fsize = st.st_size;
+  void *data = mmap(0, fsize, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED)
+    ERR(1, "cannot map input file %s", ifname);
+  madvise(data, fsize, MADV_SEQUENTIAL);
+
+  SmashCursor cur = { (const char*)data, (const char*)data + fsize };
+
+  // Header
+  if (!cur.has(12) || memcmp(cur.p, "SMSH", 4) != 0)
+  {
+    munmap(data, fsize);
+    ERR(0, "%s is not a SMASH binary file", ifname);
+    return -1;
+  }
+  cur.p += 4;
+  int version = cur.get<uint16_t>();
+  int variant = cur.get<uint16_t>();
+  uint32_t len = cur.get<uint32_t>();
+  if (!cur.has(len))
+  {
+    munmap(data, fsize);
+    ERR(0, "truncated header in %s", ifname);
+    return -1;
+  }
+  std::string smashVersion(cur.p, len);
+  cur.p += len;
+  SmashLayout layout = make_layout(version, variant);
+  std::cout << PROGNAME ": " << smashVersion << ", format version " << version
+            << (layout.extended ? ", extended" : ", default") << std::endl;
+
+  // Output file
+  ofile = new TFile(ofname, "RECREATE");
+  if (!ofile || ofile->IsZombie())
+  {
+    munmap(data, fsize);
+    ERR(1, "cannot open output file %s", ofname);
+  }
+  ofile->SetCompressionLevel(ofnameCompLevel);
+  ofile->SetCompressionAlgorithm(ofnameCompAlgo);
+
+  // Setting up McDst.
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+  tree = new TTree("McDst", "SMASH binary tree");
+  tree->SetAutoSave(treeAutoSave);
+  for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+  { // Create arrays.
+    mcArrays[i] = new TClonesArray(McArrays::mcArrayTypes[i], McArrays::mcArraySizes[i]);
+    // Set branch.
+    tree->Branch(McArrays::mcArrayNames[i], &mcArrays[i]);
+  }
+
+  // Particle blocks waiting for the end of event block.
+  std::vector<SmashSnapshot> snapshots;
+  int eventNr = 0;
+
+  // Main loop over blocks.
+  while (nconv < nev && cur.has(1))
+  {
+    char tag = cur.get<char>();
+
+    if (tag == 'p')
+    {
+      if (!cur.has(layout.pHeaderExtra + sizeof(uint32_t)))
+        break;
+      cur.p += layout.pHeaderExtra;
+      uint32_t ntrk = cur.get<uint32_t>();
+      if (!cur.has(ntrk * layout.lineSize))
+      {
+        ERR(0, "truncated particle block in event %d", eventNr);
+        break;
+      }
+      // Impact parameter and event number come with the end of event block.
+      SmashSnapshot snapshot = { cur.p, ntrk };
+      snapshots.push_back(snapshot);
+      cur.p += ntrk * layout.lineSize;
+    }
+    else if (tag == 'i')
+    {
+      std::size_t head = 2 * sizeof(uint32_t) + layout.iHeaderExtra +
+                         3 * sizeof(double) + sizeof(uint32_t);
+      if (!cur.has(head))
+        break;
+      uint32_t nin = cur.get<uint32_t>();
+      uint32_t nout = cur.get<uint32_t>();
+      cur.p += head - 2 * sizeof(uint32_t);
+      std::size_t skip = (std::size_t)(nin + nout) * layout.lineSize;
+      if (!cur.has(skip))
+        break;
+      cur.p += skip;
+    }
+    else if (tag == 'f')
+    {
+      std::size_t size = sizeof(uint32_t) + layout.fEnsemble + sizeof(double) + layout.fEmptyFlag;
+      if (!cur.has(size))
+        break;
+      eventNr = cur.get<uint32_t>();
+      cur.p += layout.fEnsemble;
+      double impact = cur.get<double>();
+      cur.p += layout.fEmptyFlag;
+      // Every time step of the event gets its number and impact parameter.
+      for (std::size_t i = 0; i < snapshots.size() && nconv < nev; ++i)
+      {
+        fill_snapshot(snapshots[i].p, snapshots[i].ntrk, layout, cut, mcArrays,
+                      eventNr, (int)i, impact);
+        tree->Fill();
+        ++nconv;
+      }
+      snapshots.clear();
+      ++eventNr;
+    }
+    else
+    {
+      ERR(0, "unknown block '%c' at byte %ld, format version %d is not supported?",
+          tag, (long)(cur.p - 1 - (const char*)data), version);
+      break;
+    }
+  }
+  // Incomplete last event, the impact parameter is not known.
+  for (std::size_t i = 0; i < snapshots.size() && nconv < nev; ++i)
+  {
+    fill_snapshot(snapshots[i].p, snapshots[i].ntrk, layout, cut, mcArrays,
+                  eventNr, (int)i, 0.);
+    tree->Fill();
+    ++nconv;
+  }
+
+  munmap(data, fsize);
+
+  McRun *run = new McRun(("SMASH " + smashVersion).c_str(), ifname,
+                         0, 0, 0., 0, 0, 0., 0., 0., 0, 0., 0., 0., nconv);
+  run->Write();
+  ofile->Write();
+  ofile->Close();
+  delete run;
+  return nconv;
+}
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hi:o:e:"; // This string must be sync with a struct option array.
+  int opt, nev = std::numeric_limits<int>::max();
+  char *ifname = 0;
+  const char *ofname = OFILE_DEFAULT;
+  int ofnameCompLevel = ROOT::RCompressionSetting::ELevel::kDefaultLZMA;
+  int ofnameCompAlgo = ROOT::kLZMA; // Use LZMA by default.
+  // Precalculated hashes.
+  const uint32_t lzma = 2053988608; // hash4("lzma")
+  const uint32_t zlib = 1818845696; // hash4("zlib")
+  const uint32_t lz4 = 8008704; // hash4("lz4")
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'i':
+      ifname = optarg;
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'e':
+      nev = std::stoi(optarg);
+      break;
+    case 0xFF01:
+      ofnameCompLevel = std::stoi(optarg);
+      break;
+    case 0xFF02:
+      switch (hash4(optarg))
+      {
+      case lzma:
+        ofnameCompAlgo = ROOT::kLZMA;
+        break;
+      case zlib:
+        ofnameCompAlgo = ROOT::kZLIB;
+        break;
+      case lz4:
+        ofnameCompAlgo = ROOT::kLZ4;
+        break;
+      default:
+        std::cout << "Warning: there is no support for " << optarg << " compression algorithm"
+                  << "\nWarning: fallback to the lzma!\n";
+        ofnameCompAlgo = ROOT::kLZMA;
+      }
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  if (!ifname)
+    ERR(1, "no input file is given");
+
+  int nconv = smashbin2mc(ifname, ofname, nev, ofnameCompLevel, ofnameCompAlgo);
+  if (nconv < 0)
+    return EXIT_FAILURE;
+  std::cout << nconv << " events converted to " << ofname << std::endl;
+  return EXIT_SUCCESS;
+}
+#endif // MCDST_CONVERTER_NO_MAIN
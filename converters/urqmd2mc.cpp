@@ -32,21 +32,23 @@
 #include "McParticle.h"
 #include "McPIDConverter.h"
 #include "McArrays.h"
+#include "McConverters.h"
 
 using namespace std;
 
-TFile *fi;
-TTree *tr;
-TClonesArray *arrays[McArrays::NAllMcArrays];
+static TFile *fi;
+static TTree *tr;
+static TClonesArray *arrays[McArrays::NAllMcArrays];
 
 //_________________
-void bomb(const char *myst) {
+static void bomb(const char *myst) {
   std::cerr << "Error: " << myst << ", bombing" << std::endl;
   exit(-1);
 }
 
+#ifndef MCDST_CONVERTER_NO_MAIN
 //_________________
-std::string newName(char* origName) {
+static std::string newName(char* origName) {
   std::string fname(origName);
   std::string key1 = ".f13";
   std::string key2 = ".f14";
@@ -64,9 +66,10 @@ std::string newName(char* origName) {
 
   return fname;
 }
+#endif // MCDST_CONVERTER_NO_MAIN
 
 //_________________
-int trapco(int ityp, int ichg) {
+static int trapco(int ityp, int ichg) {
   // translate UrQMD pid code to pdg code
 
   /* UrQMD PIDs are in fact composite - a particle is fully defined by the
@@ -95,12 +98,10 @@ int trapco(int ityp, int ichg) {
 }
 
 //_________________
-int main(int argc, char *argv[]) {
+int urqmd2mc(const char *inpfile, const char *oFileName, int nevents) {
 
   ifstream in;
-  char *inpfile;
   char c;
-  int nevents;
   string dust;
 
   // Print debug information during the conversion
@@ -116,30 +117,15 @@ int main(int argc, char *argv[]) {
   int filetype, eos, aproj, zproj, atarg, ztarg, nr;
   double beta, b, bmin, bmax, sigma, elab, plab, sqrts, time, dtime;
 
-  if (argc != 3) {
-    std::cout << "usage:   " << argv[0] << " inputfile nevents\n";
-    std::cout << "example: " << argv[0] << " inputfile.f14 10 \n"
-	      << "This will create inputfile.uDst.root\n";
-    exit(0);
-  }
-
-  // Read input file from the command line
-  inpfile = argv[1];
-  // Read number of events to convert from the command line
-  nevents = atoi(argv[2]);
-
   int nout=0;
 
-  // Check that filename contains .f13 or .f14
-  TString oFileName( newName( argv[1] ) );
-
   // Try to open file
   in.open(inpfile);
   if ( in.fail() ) {
     bomb("cannot open input file");
   }
 
-  fi = TFile::Open(oFileName.Data(), "RECREATE", "UrQMD");
+  fi = TFile::Open(oFileName, "RECREATE", "UrQMD");
   fi->SetCompressionLevel(9);
   int bufsize = 65536 * 4;
   int split = 99;
@@ -329,5 +315,25 @@ int main(int argc, char *argv[]) {
   fi->Write();
   fi->Close();
   std::cout << "Total bytes were written: " << nout << std::endl;
+  return events_processed;
+}
+
+#ifndef MCDST_CONVERTER_NO_MAIN
+//_________________
+int main(int argc, char *argv[]) {
+
+  if (argc != 3) {
+    std::cout << "usage:   " << argv[0] << " inputfile nevents\n";
+    std::cout << "example: " << argv[0] << " inputfile.f14 10 \n"
+	      << "This will create inputfile.uDst.root\n";
+    exit(0);
+  }
+
+  // Check that filename contains .f13 or .f14
+  TString oFileName( newName( argv[1] ) );
+
+  // Read input file and number of events to convert from the command line
+  urqmd2mc(argv[1], oFileName.Data(), atoi(argv[2]));
   return 0;
 }
+#endif // MCDST_CONVERTER_NO_MAIN
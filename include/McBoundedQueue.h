@@ -0,0 +1,89 @@
+/**
+ * \class McBoundedQueue
+ * \brief Thread-safe FIFO queue with a fixed capacity
+ *
+ * Producers block in push() while the queue is full and consumers
+ * block in pop() while it is empty. After close() is called push()
+ * is refused and pop() drains the remaining items and then returns
+ * false, which is the signal for the consumer threads to finish.
+ */
+
+#ifndef McBoundedQueue_h
+#define McBoundedQueue_h
+
+// C++ headers
+#include <cstddef>
+#include <deque>
+#include <mutex>
+#include <condition_variable>
+#include <utility>
+
+//_________________
+template <class T>
+class McBoundedQueue {
+
+ public:
+  /// Constructor that takes maximal number of queued items
+  explicit McBoundedQueue(std::size_t capacity) :
+    mCapacity( (capacity > 0) ? capacity : 1 ), mClosed(false) { /* empty */ }
+  /// Destructor
+  ~McBoundedQueue() { /* empty */ }
+
+  /// Add item to the queue. Return false if the queue was closed
+  bool push(T item) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mNotFull.wait(lock, [this] { return mClosed || mItems.size() < mCapacity; });
+    if (mClosed) return false;
+    mItems.push_back(std::move(item));
+    mNotEmpty.notify_one();
+    return true;
+  }
+
+  /// Take the oldest item from the queue. Return false when the
+  /// queue is closed and empty
+  bool pop(T& item) {
+    std::unique_lock<std::mutex> lock(mMutex);
+    mNotEmpty.wait(lock, [this] { return mClosed || !mItems.empty(); });
+    if (mItems.empty()) return false;
+    item = std::move(mItems.front());
+    mItems.pop_front();
+    mNotFull.notify_one();
+    return true;
+  }
+
+  /// Refuse new items and wake up all waiting threads
+  void close() {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mClosed = true;
+    mNotEmpty.notify_all();
+    mNotFull.notify_all();
+  }
+
+  /// Return number of queued items
+  std::size_t size() const {
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mItems.size();
+  }
+  /// Return maximal number of queued items
+  std::size_t capacity() const { return mCapacity; }
+
+ private:
+  /// Copying is not allowed
+  McBoundedQueue(const McBoundedQueue&) = delete;
+  McBoundedQueue& operator=(const McBoundedQueue&) = delete;
+
+  /// Maximal number of items
+  std::size_t mCapacity;
+  /// The queue is closed for new items
+  bool mClosed;
+  /// Queued items
+  std::deque<T> mItems;
+  /// Guards all members
+  mutable std::mutex mMutex;
+  /// Signalled when an item was added
+  std::condition_variable mNotEmpty;
+  /// Signalled when an item was taken
+  std::condition_variable mNotFull;
+};
+
+#endif // McBoundedQueue_h
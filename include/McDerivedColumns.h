@@ -0,0 +1,105 @@
+/**
+ * \class McDerivedColumns
+ * \brief Per-event cache of the quantities derived from particle momenta
+ *
+ * Every McDstReader has one cache that is invalidated by loadEntry().
+ * A column (pT, eta, rapidity, phi, momentum, charge, PDG mass) is
+ * computed for all particles of the event when it is requested for
+ * the first time, and is shared by all consumers of the event
+ * (e.g. tasks of McDstTrain), so the math is done once per event.
+ *
+ * The momenta are gathered from the particles into flat arrays once,
+ * then each column is computed in a branch-free loop over these
+ * arrays. Charge and PDG mass are looked up in TDatabasePDG once per
+ * PDG code. The values are the same as returned by the corresponding
+ * McParticle methods. The columns need fPx, fPy, fPz, fE and fPdg
+ * data members to be read.
+ */
+
+#ifndef McDerivedColumns_h
+#define McDerivedColumns_h
+
+// C++ headers
+#include <vector>
+#include <unordered_map>
+#include <utility>
+
+// ROOT headers
+#include "Rtypes.h"
+
+// Forward declarations
+class TClonesArray;
+
+//_________________
+class McDerivedColumns {
+
+ public:
+  /// Default constructor
+  McDerivedColumns();
+  /// Destructor
+  virtual ~McDerivedColumns();
+
+  /// Column types
+  enum { kPt = 0, kEta, kRapidity, kPhi, kPtot, kCharge, kPdgMass, kNColumns };
+
+  /// Set particles of a new event. All columns are invalidated
+  void reset(TClonesArray* particles) {
+    mParticles = particles;
+    mValid = 0;
+    mMomentaLoaded = kFALSE;
+  }
+
+  /// Return number of particles
+  Int_t size();
+  /// Return column, computed at the first call for the event
+  const Double_t* column(Int_t type) {
+    if ( !(mValid & (1u << type)) ) compute(type);
+    return mColumns[type].data();
+  }
+
+  /// Return transverse momenta
+  const Double_t* pt()        { return column(kPt); }
+  /// Return pseudorapidities
+  const Double_t* eta()       { return column(kEta); }
+  /// Return rapidities
+  const Double_t* rapidity()  { return column(kRapidity); }
+  /// Return azimuthal angles
+  const Double_t* phi()       { return column(kPhi); }
+  /// Return total momenta
+  const Double_t* ptot()      { return column(kPtot); }
+  /// Return charges (same units as McParticle::charge())
+  const Double_t* charge()    { return column(kCharge); }
+  /// Return PDG masses (-999 for unknown codes)
+  const Double_t* pdgMass()   { return column(kPdgMass); }
+
+ private:
+  McDerivedColumns(const McDerivedColumns&) = delete;
+  McDerivedColumns& operator=(const McDerivedColumns&) = delete;
+
+  /// Gather momenta and PDG codes of the particles
+  void loadMomenta();
+  /// Compute column
+  void compute(Int_t type);
+  /// Return charge and mass of the PDG code
+  const std::pair<Double_t, Double_t>& pdgProperties(Int_t pdg);
+
+  /// Particles of the current event
+  TClonesArray *mParticles;
+  /// Bit mask of the computed columns
+  UInt_t mValid;
+  /// Momenta and PDG codes are gathered
+  Bool_t mMomentaLoaded;
+
+  /// Momenta components, energy and PDG codes of the particles
+  std::vector<Double_t> mPx;
+  std::vector<Double_t> mPy;
+  std::vector<Double_t> mPz;
+  std::vector<Double_t> mE;
+  std::vector<Int_t> mPdg;
+  /// Computed columns
+  std::vector<Double_t> mColumns[kNColumns];
+  /// Charge and mass of the PDG codes found so far
+  std::unordered_map<Int_t, std::pair<Double_t, Double_t> > mPdgProperties;
+};
+
+#endif // McDerivedColumns_h
@@ -0,0 +1,31 @@
+/**
+ * \class McDstCacheDirectory
+ * \brief Least recently used eviction of the files of a cache directory
+ *
+ * Shared by the caches that keep their files in a directory common to
+ * all jobs of the node (McDstSharedCache, McDstStagingCache). Cache files
+ * are named mcdst_*<suffix>, their modification time marks the last use
+ * and every job that uses a file holds a shared lock (flock) of it.
+ * Files are removed starting with the least recently used one; the ones
+ * locked by any job are kept. Lock files <file>.lock that are not held
+ * and whose file does not exist, and temporary files <file>.<pid>.tmp
+ * of processes that are gone, are removed as well.
+ */
+
+#ifndef McDstCacheDirectory_h
+#define McDstCacheDirectory_h
+
+// ROOT headers
+#include "Rtypes.h"
+
+//_________________
+class McDstCacheDirectory {
+
+ public:
+  /// Remove least recently used files mcdst_*<suffix> of the directory
+  /// that are not in use until their total size is below maxBytes.
+  /// Return the total size
+  static Long64_t evict(const Char_t* directory, const Char_t* suffix, Long64_t maxBytes);
+};
+
+#endif // McDstCacheDirectory_h
@@ -0,0 +1,420 @@
+/**
+ * \class McDstColumns
+ * \brief Columnar (structure of arrays) storage of mcDst events
+ *
+ * Holds the data members of McEvent and McParticle of one or more
+ * events as flat arrays, one array per data member. Particles of
+ * event i are stored at [particleOffset()[i], particleOffset()[i+1]).
+ * Events are added from the TClonesArrays of a reader with append()
+ * and can be put back to McEvent/McParticle objects with fill().
+ * The columns can be written to a flat buffer with serialize(), and
+ * a storage can use such a buffer (e.g. shared memory) read-only
+ * without copying with attach().
+ *
+ * The data are accessed either directly through the column arrays,
+ * e.g. px() returns pointer to all px values, or with the views:
+ * ```
+ * for (const auto& ev : columns.events()) {
+ *   for (const auto& p : ev.particles()) {
+ *     h.fill(p.pt());
+ *   }
+ * }
+ * ```
+ * McEventView and McParticleView have the same getters as McEvent
+ * and McParticle, so code templated on the event type works with
+ * both storages.
+ *
+ * Only some of the particle columns can be stored (setParticleFields()),
+ * e.g. the data members read by McDstReader::setFields(). Columns that
+ * are not stored are empty and must not be used, also through views.
+ *
+ * A batch of consecutive entries is read with McDstReader::loadBatch().
+ * Kernels over particles can then run over all particles of the batch
+ * in one loop, using particleOffset() to find the event:
+ * ```
+ * while (reader->loadBatch(first, 1000, batch) > 0) {
+ *   const Float_t *px = batch.px();
+ *   const Float_t *py = batch.py();
+ *   for (Long64_t i = 0; i < batch.numberOfParticles(); ++i) {
+ *     pt[i] = std::sqrt(px[i] * px[i] + py[i] * py[i]);
+ *   }
+ *   first += 1000;
+ * }
+ * ```
+ */
+
+#ifndef McDstColumns_h
+#define McDstColumns_h
+
+// C++ headers
+#include <vector>
+#include <cmath>
+
+// ROOT headers
+#include "TString.h"
+#include "TLorentzVector.h"
+#include "TDatabasePDG.h"
+#include "TParticlePDG.h"
+
+// McDst headers
+#include "McDstRange.h"
+
+// Forward declarations
+class McEvent;
+class TClonesArray;
+class McDstColumns;
+
+//_________________
+class McParticleView {
+
+ public:
+  /// Constructor that takes storage and global particle index
+  McParticleView(const McDstColumns* columns, Long64_t i) : mC(columns), mI(i) { /* empty */ }
+
+  /// Return particle index
+  inline int index() const;
+  /// Return PDG code
+  inline int pdg() const;
+  /// Return status
+  inline int status() const;
+  /// Return parent index
+  inline int parent() const;
+  /// Return parent decay index
+  inline int parentDecay() const;
+  /// Return index of the last collision partner
+  inline int mate() const;
+  /// Return decay index (-1 if not decayed)
+  inline int decay() const;
+  /// Return index of the first child
+  inline int firstChild() const;
+  /// Return index of the last child
+  inline int lastChild() const;
+  /// Return px (GeV/c)
+  inline double px() const;
+  /// Return py (GeV/c)
+  inline double py() const;
+  /// Return pz (GeV/c)
+  inline double pz() const;
+  /// Return energy (GeV)
+  inline double energy() const;
+  /// Return energy (GeV)
+  double e() const              { return energy(); }
+  /// Return x position (fm)
+  inline double x() const;
+  /// Return y position (fm)
+  inline double y() const;
+  /// Return z position (fm)
+  inline double z() const;
+  /// Return t position (fm/c)
+  inline double t() const;
+
+  /// Return p (GeV/c)
+  double ptot() const           { return std::sqrt( px()*px() + py()*py() + pz()*pz() ); }
+  /// Return transverse momentum (pT)
+  double pt() const             { return std::sqrt( px()*px() + py()*py() ); }
+  /// Return azimuthal angle
+  double phi() const            { return std::atan2( py(), px() ); }
+  /// Return pseudorapidity (same convention as TVector3)
+  double eta() const {
+    const double p = ptot();
+    const double cosTheta = (p == 0.) ? 1. : pz() / p;
+    if (cosTheta * cosTheta < 1.) return -0.5 * std::log( (1. - cosTheta) / (1. + cosTheta) );
+    if (pz() == 0.) return 0.;
+    return (pz() > 0.) ? 10e10 : -10e10;
+  }
+  /// Return pseudorapidity
+  double pseudoRapidity() const { return eta(); }
+  /// Return rapidity
+  double rapidity() const       { return 0.5 * std::log( (energy() + pz()) / (energy() - pz()) ); }
+  /// Return mass according to the generator
+  double mass() const           { return momentum().M(); }
+  /// Return mass according to the PDG code (GeV/c^2)
+  double pdgMass() const {
+    TParticlePDG *p = TDatabasePDG::Instance()->GetParticle( pdg() );
+    return p ? p->Mass() : -999.; }
+  /// Return charge (same units as McParticle::charge())
+  double charge() const {
+    TParticlePDG *p = TDatabasePDG::Instance()->GetParticle( pdg() );
+    return p ? p->Charge() : 0.; }
+  /// Calculate particle energy using PDG mass
+  double pdgEnergy() const      { return std::sqrt( ptot()*ptot() + pdgMass()*pdgMass() ); }
+  /// Return energy (GeV)
+  double pdgE() const           { return pdgEnergy(); }
+  /// Return four-momentum (px,py,pz,E)
+  TLorentzVector momentum() const { return TLorentzVector( px(), py(), pz(), energy() ); }
+  /// Return four-coordinate (x,y,z,t)
+  TLorentzVector position() const { return TLorentzVector( x(), y(), z(), t() ); }
+  /// Return space-time rapidity
+  double etaS() const           { return 0.5 * std::log( (t() + z()) / (t() - z()) ); }
+  /// Return proper time (fm/c)
+  double tau() const            { return ( t()*t() > z()*z() ) ? std::sqrt( t()*t() - z()*z() ) : -0.5; }
+
+ private:
+  /// Storage
+  const McDstColumns *mC;
+  /// Global index of the particle
+  Long64_t mI;
+};
+
+typedef McIndexRange<McParticleView, McDstColumns> McParticleViewRange;
+
+//_________________
+class McEventView {
+
+ public:
+  /// Constructor that takes storage and event index
+  McEventView(const McDstColumns* columns, Long64_t i) : mC(columns), mI(i) { /* empty */ }
+
+  /// Return index of the event in the storage
+  Long64_t entry() const        { return mI; }
+  /// Return event number
+  inline int eventNr() const;
+  /// Return impact parameter
+  inline double b() const;
+  /// Return impact parameter
+  double impact() const         { return b(); }
+  /// Return reaction plane angle
+  inline double phi() const;
+  /// Return number of event steps
+  inline int numberOfSteps() const;
+  /// Return event step number
+  inline int stepNumber() const;
+  /// Return event step time
+  inline double stepT() const;
+  /// Return event step time
+  double stepTime() const       { return stepT(); }
+  /// Return number of participants
+  inline int npart() const;
+  /// Return number of binary collisions
+  inline int ncoll() const;
+  /// Return generator-specific information
+  inline void comment(TString& comment) const;
+
+  /// Return number of particles
+  inline Int_t numberOfParticles() const;
+  /// Return particles of the event
+  inline McParticleViewRange particles() const;
+  /// Return i-th particle of the event
+  inline McParticleView particle(Int_t i) const;
+
+ private:
+  /// Storage
+  const McDstColumns *mC;
+  /// Event index
+  Long64_t mI;
+};
+
+typedef McIndexRange<McEventView, McDstColumns> McEventViewRange;
+
+//_________________
+class McDstColumns {
+
+ public:
+  /// Default constructor
+  McDstColumns();
+  /// Destructor
+  virtual ~McDstColumns();
+
+  /// Particle columns
+  enum { kIndex = 0, kPdg, kStatus, kParent, kParentDecay, kMate, kDecay,
+         kFirstChild, kLastChild, kPx, kPy, kPz, kE, kX, kY, kZ, kT,
+         kNParticleColumns };
+
+  /// Store only particle columns of the given McParticle data members
+  /// (e.g. "fPx", "fChild"). All columns are stored if the list is
+  /// empty. Must be called when the storage is empty
+  void setParticleFields(const std::vector<TString>& fields);
+  /// Return true if the particle column is stored
+  Bool_t hasColumn(Int_t column) const { return (mParticleMask >> column) & 1u; }
+
+  /// Remove all events (and detach from the external buffer)
+  void clear();
+  /// Reserve memory for events and particles
+  void reserve(Long64_t nEvents, Long64_t nParticles);
+  /// Add event and its particles read from the given entry of the chain
+  void append(const McEvent* event, const TClonesArray* particles, Long64_t chainEntry = -1);
+  /// Add events [first, last) of another storage. Columns that are
+  /// not stored in the other storage are filled with zeros
+  void append(const McDstColumns& columns, Long64_t first, Long64_t last);
+  /// Fill event i to the McEvent and particles to the TClonesArray
+  void fill(Long64_t i, McEvent* event, TClonesArray* particles) const;
+  /// Return size of the stored data (bytes)
+  Long64_t bytes() const;
+  /// Release memory reserved above the current size
+  void shrink();
+
+  //
+  // Flat buffer representation, e.g. for shared memory
+  //
+
+  /// Return size of the buffer needed by serialize()
+  Long64_t serializedSize() const;
+  /// Write all columns to the buffer of serializedSize() bytes
+  void serialize(void* buffer) const;
+  /// Use columns of the serialized buffer without copying. The buffer
+  /// must stay valid while attached. The storage is read-only until
+  /// clear() is called. Return false if the buffer is not valid
+  Bool_t attach(const void* buffer, Long64_t size);
+  /// Return true if the columns are in an external buffer
+  Bool_t isAttached() const           { return mAttached; }
+
+  /// Return number of events
+  Long64_t numberOfEvents() const     { return mNEvents; }
+  /// Return total number of particles
+  Long64_t numberOfParticles() const  { return particleOffset()[mNEvents]; }
+
+  /// Return views of all events
+  McEventViewRange events() const     { return McEventViewRange(this, 0, numberOfEvents()); }
+  /// Return view of the event i
+  McEventView event(Long64_t i) const { return McEventView(this, i); }
+  /// Return views of all particles of all events
+  McParticleViewRange particles() const { return McParticleViewRange(this, 0, numberOfParticles()); }
+
+  //
+  // Event columns
+  //
+
+  const UInt_t* eventNr() const           { return (const UInt_t*)mBlock[kBlockEventNr]; }
+  const Float_t* b() const                { return (const Float_t*)mBlock[kBlockB]; }
+  const Float_t* phi() const              { return (const Float_t*)mBlock[kBlockPhi]; }
+  const UShort_t* nes() const             { return (const UShort_t*)mBlock[kBlockNes]; }
+  const UShort_t* stepNr() const          { return (const UShort_t*)mBlock[kBlockStepNr]; }
+  const Float_t* stepT() const            { return (const Float_t*)mBlock[kBlockStepT]; }
+  const Short_t* npart() const            { return (const Short_t*)mBlock[kBlockNpart]; }
+  const Short_t* ncoll() const            { return (const Short_t*)mBlock[kBlockNcoll]; }
+  /// Return comment of the event i
+  TString comment(Long64_t i) const;
+  /// Entry of the chain every event was read from (-1 if not known)
+  const Long64_t* chainEntry() const      { return (const Long64_t*)mBlock[kBlockChainEntry]; }
+  /// Index of the first particle of every event, numberOfEvents()+1 values
+  const Long64_t* particleOffset() const  { return (const Long64_t*)mBlock[kBlockParticleOffset]; }
+
+  //
+  // Particle columns (see hasColumn())
+  //
+
+  const UShort_t* index() const           { return (const UShort_t*)mBlock[kIndex]; }
+  const Int_t* pdg() const                { return (const Int_t*)mBlock[kPdg]; }
+  const Char_t* status() const            { return (const Char_t*)mBlock[kStatus]; }
+  const UShort_t* parent() const          { return (const UShort_t*)mBlock[kParent]; }
+  const UShort_t* parentDecay() const     { return (const UShort_t*)mBlock[kParentDecay]; }
+  const UShort_t* mate() const            { return (const UShort_t*)mBlock[kMate]; }
+  const Short_t* decay() const            { return (const Short_t*)mBlock[kDecay]; }
+  const UShort_t* firstChild() const      { return (const UShort_t*)mBlock[kFirstChild]; }
+  const UShort_t* lastChild() const       { return (const UShort_t*)mBlock[kLastChild]; }
+  const Float_t* px() const               { return (const Float_t*)mBlock[kPx]; }
+  const Float_t* py() const               { return (const Float_t*)mBlock[kPy]; }
+  const Float_t* pz() const               { return (const Float_t*)mBlock[kPz]; }
+  const Float_t* e() const                { return (const Float_t*)mBlock[kE]; }
+  const Float_t* x() const                { return (const Float_t*)mBlock[kX]; }
+  const Float_t* y() const                { return (const Float_t*)mBlock[kY]; }
+  const Float_t* z() const                { return (const Float_t*)mBlock[kZ]; }
+  const Float_t* t() const                { return (const Float_t*)mBlock[kT]; }
+
+ private:
+  McDstColumns(const McDstColumns&) = delete;
+  McDstColumns& operator=(const McDstColumns&) = delete;
+
+  /// Data blocks: particle columns, then event columns, particle
+  /// offsets, comment offsets and characters of the comments
+  enum { kBlockEventNr = kNParticleColumns, kBlockB, kBlockPhi, kBlockNes,
+         kBlockStepNr, kBlockStepT, kBlockNpart, kBlockNcoll, kBlockChainEntry,
+         kBlockParticleOffset, kBlockCommentOffset, kBlockComment, kNBlocks };
+
+  /// Resize stored particle columns
+  void resizeParticles(Long64_t nParticles);
+  /// Point blocks to the data of the vectors
+  void updateBlocks();
+  /// Return false (with a message) if the storage is attached
+  Bool_t isWritable(const Char_t* method) const;
+  /// Return size of the block in the serialized buffer
+  Long64_t blockBytes(Int_t block) const;
+
+  /// Header of the serialized buffer
+  struct Header;
+
+  // Event columns
+  std::vector<UInt_t> mEventNr;
+  std::vector<Float_t> mB;
+  std::vector<Float_t> mPhi;
+  std::vector<UShort_t> mNes;
+  std::vector<UShort_t> mStepNr;
+  std::vector<Float_t> mStepT;
+  std::vector<TString> mComment;
+  std::vector<Short_t> mNpart;
+  std::vector<Short_t> mNcoll;
+  std::vector<Long64_t> mChainEntry;
+  std::vector<Long64_t> mParticleOffset;
+
+  // Particle columns
+  std::vector<UShort_t> mIndex;
+  std::vector<Int_t> mPdg;
+  std::vector<Char_t> mStatus;
+  std::vector<UShort_t> mParent;
+  std::vector<UShort_t> mParentDecay;
+  std::vector<UShort_t> mMate;
+  std::vector<Short_t> mDecay;
+  std::vector<UShort_t> mFirstChild;
+  std::vector<UShort_t> mLastChild;
+  std::vector<Float_t> mPx;
+  std::vector<Float_t> mPy;
+  std::vector<Float_t> mPz;
+  std::vector<Float_t> mE;
+  std::vector<Float_t> mX;
+  std::vector<Float_t> mY;
+  std::vector<Float_t> mZ;
+  std::vector<Float_t> mT;
+
+  /// Bit mask of the stored particle columns
+  UInt_t mParticleMask;
+  /// Length of all comments
+  Long64_t mCommentBytes;
+  /// Number of events
+  Long64_t mNEvents;
+  /// Data of the blocks (vectors or external buffer)
+  const void *mBlock[kNBlocks];
+  /// Columns are in an external buffer
+  Bool_t mAttached;
+  /// Size of the external buffer
+  Long64_t mAttachedBytes;
+};
+
+//
+// Inline view getters, defined after McDstColumns
+//
+
+inline int McParticleView::index() const       { return (int)mC->index()[mI]; }
+inline int McParticleView::pdg() const         { return mC->pdg()[mI]; }
+inline int McParticleView::status() const      { return (int)mC->status()[mI]; }
+inline int McParticleView::parent() const      { return (int)mC->parent()[mI]; }
+inline int McParticleView::parentDecay() const { return (int)mC->parentDecay()[mI]; }
+inline int McParticleView::mate() const        { return (int)mC->mate()[mI]; }
+inline int McParticleView::decay() const       { return (int)mC->decay()[mI]; }
+inline int McParticleView::firstChild() const  { return (int)mC->firstChild()[mI]; }
+inline int McParticleView::lastChild() const   { return (int)mC->lastChild()[mI]; }
+inline double McParticleView::px() const       { return (double)mC->px()[mI]; }
+inline double McParticleView::py() const       { return (double)mC->py()[mI]; }
+inline double McParticleView::pz() const       { return (double)mC->pz()[mI]; }
+inline double McParticleView::energy() const   { return (double)mC->e()[mI]; }
+inline double McParticleView::x() const        { return (double)mC->x()[mI]; }
+inline double McParticleView::y() const        { return (double)mC->y()[mI]; }
+inline double McParticleView::z() const        { return (double)mC->z()[mI]; }
+inline double McParticleView::t() const        { return (double)mC->t()[mI]; }
+
+inline int McEventView::eventNr() const        { return (int)mC->eventNr()[mI]; }
+inline double McEventView::b() const           { return (double)mC->b()[mI]; }
+inline double McEventView::phi() const         { return (double)mC->phi()[mI]; }
+inline int McEventView::numberOfSteps() const  { return (int)mC->nes()[mI]; }
+inline int McEventView::stepNumber() const     { return (int)mC->stepNr()[mI]; }
+inline double McEventView::stepT() const       { return (double)mC->stepT()[mI]; }
+inline int McEventView::npart() const          { return (int)mC->npart()[mI]; }
+inline int McEventView::ncoll() const          { return (int)mC->ncoll()[mI]; }
+inline void McEventView::comment(TString& comment) const { comment = mC->comment(mI); }
+inline Int_t McEventView::numberOfParticles() const
+{ return (Int_t)(mC->particleOffset()[mI + 1] - mC->particleOffset()[mI]); }
+inline McParticleViewRange McEventView::particles() const
+{ return McParticleViewRange(mC, mC->particleOffset()[mI], mC->particleOffset()[mI + 1]); }
+inline McParticleView McEventView::particle(Int_t i) const
+{ return McParticleView(mC, mC->particleOffset()[mI] + i); }
+
+#endif // McDstColumns_h
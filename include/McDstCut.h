@@ -24,6 +24,8 @@ class McDstCut {
 
   /// Exclude particle from analysis
   void excludePdg(int pdg);
+  /// Accept only particles with the given PDG codes (all if none is given)
+  void includePdg(int pdg);
   /*
     lo -- low edge of the range.
     hi -- high edge of the range.
@@ -42,6 +44,7 @@ class McDstCut {
 
  private:
   std::vector<int> pdgExclude;
+  std::vector<int> pdgInclude;
   /*
     [0] -- low edge of the range.
     [1] -- high edge of the range.
@@ -50,6 +53,7 @@ class McDstCut {
   float ptCut[2];
 
   bool checkExcludePdg(int pdg);
+  bool checkIncludePdg(int pdg);
 };
 
 #endif // #ifndef McDstCut_h
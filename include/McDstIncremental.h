@@ -0,0 +1,127 @@
+/**
+ * \class McDstIncremental
+ * \brief Processes only new input files and merges the results
+ *
+ * The state of the processed input files (path, size, modification
+ * time and, optionally, MD5 checksum) together with the hash of the
+ * analysis configuration and the number of processed events is kept
+ * in the text file <output>.state next to the output file.
+ *
+ * prepare() compares the input with the state. If only new files were
+ * added, the analysis is run over the new files only and writes to a
+ * temporary output; finish() merges it into the previous output. The
+ * previous results are redone from scratch (full run) if there is no
+ * state or output, if the configuration has changed, or if one of the
+ * processed files has been changed or removed, since its contribution
+ * cannot be subtracted.
+ *
+ * Histograms are added bin by bin. Histograms normalized by the number
+ * of events (declared with addNormalized()) are averaged with the
+ * numbers of events as weights. Other objects are taken from the new
+ * output. Usage:
+ * ```
+ * McDstIncremental inc(inFileName, oFileName, configString);
+ * inc.addNormalized("hPtSpectra*");
+ * if (inc.prepare()) {
+ *   // run analysis of inc.inputFileName() to inc.outputFileName()
+ *   inc.finish(nEvents);
+ * }
+ * ```
+ */
+
+#ifndef McDstIncremental_h
+#define McDstIncremental_h
+
+// C++ headers
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+// Forward declarations
+class TDirectory;
+
+//_________________
+class McDstIncremental {
+
+ public:
+  /// Constructor that takes either mcDst file or file that contains
+  /// a list of mcDst.root files, the output file name and the string
+  /// that describes the analysis configuration
+  McDstIncremental(const Char_t* inFileName, const Char_t* oFileName,
+                   const Char_t* config = "");
+  /// Destructor
+  virtual ~McDstIncremental();
+
+  /// Compare MD5 checksums of the files in addition to size and
+  /// modification time (default: false, the files are read)
+  void setUseChecksum(Bool_t use)              { mUseChecksum = use; }
+  /// Histograms whose names match the wildcard are normalized per event
+  void addNormalized(const Char_t* nameWildcard) { mNormalized.push_back(nameWildcard); }
+
+  /// Find files to process. Return false if there is nothing to do
+  Bool_t prepare();
+  /// Merge output of this run with the previous one and write the
+  /// state. nEvents is the number of events processed in this run
+  Bool_t finish(Long64_t nEvents);
+
+  /// Return true if all files are processed
+  Bool_t isFullRun() const                     { return mFullRun; }
+  /// Return number of files to process in this run
+  Int_t numberOfFilesToProcess() const         { return mToProcess.size(); }
+  /// Return input (list of files) to be processed in this run
+  const Char_t* inputFileName() const          { return mRunInputFileName.Data(); }
+  /// Return output file to be written in this run
+  const Char_t* outputFileName() const         { return mRunOutputFileName.Data(); }
+  /// Return number of events in the output (after finish())
+  Long64_t numberOfEvents() const              { return mNEvents; }
+
+ private:
+  /// State of an input file
+  struct FileState {
+    TString path;
+    Long64_t size;
+    Long_t mtime;
+    TString checksum;
+  };
+
+  /// Read names of the input files
+  std::vector<TString> inputFiles() const;
+  /// Return state of the file on disk (size < 0 if it does not exist)
+  FileState fileState(const TString& path) const;
+  /// Read state file. Return false if it does not exist
+  Bool_t readState(TString& configHash, Long64_t& nEvents, std::vector<FileState>& files) const;
+  /// Write state file
+  Bool_t writeState() const;
+  /// Merge objects of the previous and new directories to the output
+  void mergeDirectory(TDirectory* previous, TDirectory* current, TDirectory* output,
+                      Long64_t nPrevious, Long64_t nCurrent) const;
+  /// Return true if the histogram is normalized per event
+  Bool_t isNormalized(const Char_t* name) const;
+
+  /// Name of the inputfile (or of the inputfiles.list)
+  TString mInputFileName;
+  /// Name of the output file
+  TString mOutputFileName;
+  /// Name of the state file
+  TString mStateFileName;
+  /// Hash of the analysis configuration
+  TString mConfigHash;
+  /// Input and output of this run
+  TString mRunInputFileName;
+  TString mRunOutputFileName;
+  /// Compare checksums
+  Bool_t mUseChecksum;
+  /// All files are processed
+  Bool_t mFullRun;
+  /// Number of events of the previous runs
+  Long64_t mNEvents;
+  /// Wildcards of the histograms normalized per event
+  std::vector<TString> mNormalized;
+  /// States of all input files
+  std::vector<FileState> mFiles;
+  /// Files to process in this run
+  std::vector<TString> mToProcess;
+};
+
+#endif // McDstIncremental_h
@@ -0,0 +1,144 @@
+/**
+ * \class McDstParallelReader
+ * \brief Reads mcDst file or a list of files in several threads
+ *
+ * Every thread (slot) opens the input with its own McDstReader.
+ * Entries are handed out to the threads in chunks of consecutive
+ * entries, so a thread that got a faster chunk simply takes the
+ * next one. For each entry the user function is called with the
+ * slot number and the reader of the slot. The event and particles
+ * must be accessed through McDstReader::event() and
+ * McDstReader::particle(), since the static McDst accessors point
+ * to the arrays of only one of the readers.
+ *
+ * The order in which entries are processed is not defined, so the
+ * user function should fill per-slot objects (e.g. replicas of
+ * McHistogramBank) that are merged after process() returns.
+ *
+ * Entries accepted with McDstReader::acceptEntry() in the slots are
+ * merged by writeSelection(), and readSelection() restricts later
+ * passes to these entries.
+ */
+
+#ifndef McDstParallelReader_h
+#define McDstParallelReader_h
+
+// C++ headers
+#include <functional>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+// McDst headers
+#include "McDstZoneMap.h"
+
+// Forward declarations
+class McDstReader;
+class McDstColumns;
+
+//_________________
+class McDstParallelReader {
+
+ public:
+  /// Constructor that takes either mcDst file or file that contains
+  /// a list of mcDst.root files and number of threads (0 - number
+  /// of hardware threads)
+  McDstParallelReader(const Char_t* inFileName, UInt_t nThreads = 0);
+  /// Destructor
+  virtual ~McDstParallelReader();
+
+  /// Set enable/disable branch matching when reading mcDst. Applied
+  /// to the readers of all slots
+  void setStatus(const Char_t* branchNameRegex, Int_t enable);
+  /// Read only the given data members of the array with McArrays
+  /// type (see McDstReader::setFields)
+  void setFields(Int_t arrayType, const std::vector<TString>& fields);
+  /// Read local copies of the input files staged in the directory
+  /// (see McDstReader::setStagingCache). Must be called before the
+  /// first call of process()
+  void setStagingCache(const Char_t* directory, Long64_t maxBytes = 0);
+  /// Set number of consecutive entries processed by a thread at once
+  /// (default: 1000)
+  void setChunkSize(Long64_t chunkSize) { mChunkSize = (chunkSize > 0) ? chunkSize : 1; }
+  /// Set number of entries after which the progress is printed
+  /// (0 - do not print, default: 10000)
+  void setClock(Long64_t clock)         { mClock = clock; }
+  /// Process only first nEntries entries (all if negative)
+  void setMaxEntries(Long64_t nEntries) { mMaxEntries = nEntries; }
+
+  /// Process only the entries of the selection file written by a
+  /// previous pass (see McDstReader::readSelection)
+  void readSelection(const Char_t* fileName, const Char_t* name = "mcDstSelection");
+  /// Read only the clusters where an event may pass the cut
+  /// (see McDstReader::skipClusters)
+  void skipClusters(const McDstZoneMap::Cut& cut);
+  /// Merge the entries accepted in all slots and write them to the file
+  Bool_t writeSelection(const Char_t* fileName, const Char_t* name = "mcDstSelection");
+
+  /// Read all entries to process into memory once, shared by the
+  /// readers of all slots (see McDstReader::loadToMemory). Further
+  /// calls of process() do not read the files
+  Bool_t loadToMemory(Long64_t maxBytes = 0);
+  /// Same as loadToMemory(), but the events are kept in the shared
+  /// memory cache (see McDstReader::loadToSharedMemory)
+  Bool_t loadToSharedMemory(Long64_t maxBytes = 0, const Char_t* directory = "/dev/shm");
+  /// Return events in memory (nullptr if not loaded)
+  const McDstColumns *memory();
+
+  /// Return number of threads
+  UInt_t numberOfThreads() const        { return mNThreads; }
+  /// Return number of entries to process (selected entries if the
+  /// selection is read)
+  Long64_t entries();
+
+  /// Call func(slot, reader) for every entry. Return number of
+  /// processed entries
+  Long64_t process(const std::function<void(UInt_t, McDstReader*)>& func);
+  /// Call func(slot, batch) for every chunk of entries read into one
+  /// columnar batch (see McDstReader::loadBatch). The batch is reused
+  /// by the slot after func returns. Return number of processed entries
+  Long64_t processBatches(const std::function<void(UInt_t, const McDstColumns&)>& func);
+
+ private:
+  McDstParallelReader(const McDstParallelReader&) = delete;
+  McDstParallelReader& operator=(const McDstParallelReader&) = delete;
+
+  /// Create and initialize the reader of every slot
+  void init();
+  /// Call chunk(slot, first, last) for chunks of entries in all threads.
+  /// Return sum of the values returned by chunk
+  Long64_t dispatch(const std::function<Long64_t(UInt_t, Long64_t, Long64_t)>& chunk);
+
+  /// Name of the inputfile (or of the inputfiles.list)
+  TString mInputFileName;
+  /// Number of threads
+  UInt_t mNThreads;
+  /// Number of entries in a chunk
+  Long64_t mChunkSize;
+  /// Progress print period
+  Long64_t mClock;
+  /// Maximal number of entries to process
+  Long64_t mMaxEntries;
+  /// Branch statuses to be applied to the readers
+  std::vector< std::pair<TString, Int_t> > mStatus;
+  /// Data member selections to be applied to the readers
+  std::vector< std::pair<Int_t, std::vector<TString> > > mFields;
+  /// Reader of every slot
+  std::vector<McDstReader*> mReaders;
+  /// File and name of the selection to read
+  TString mSelectionFileName;
+  TString mSelectionName;
+  /// Directory and size limit of the staging cache
+  TString mStagingDirectory;
+  Long64_t mStagingMaxBytes;
+  /// Cut on the clusters to read
+  McDstZoneMap::Cut mZoneCut;
+  Bool_t mSkipClusters;
+  /// Serializes printouts of the threads
+  std::mutex mPrintMutex;
+};
+
+#endif // McDstParallelReader_h
@@ -0,0 +1,118 @@
+/**
+ * \class McDstParallelWriter
+ * \brief Writes mcDst from several threads into a single file
+ *
+ * The class wraps ROOT's TBufferMerger. Every producer thread works
+ * with its own McDstParallelWriter::Slot: it fills McEvent and
+ * McParticle into the slot arrays and calls Slot::fill(). Each slot
+ * keeps a McDst TTree in memory, so serialization and compression of
+ * the baskets happen in the thread that fills the slot. Every
+ * flushSize() bytes the compressed baskets are handed over to the
+ * merger and appended to the output file without recompression.
+ *
+ * Entries in the output follow the order in which the slots were
+ * flushed, i.e. events of one flush are contiguous but blocks from
+ * different slots are interleaved. Slots must be destroyed before
+ * the writer that created them.
+ */
+
+#ifndef McDstParallelWriter_h
+#define McDstParallelWriter_h
+
+// C++ headers
+#include <memory>
+#include <mutex>
+
+// ROOT headers
+#include "RVersion.h"
+#include "TTree.h"
+#include "TClonesArray.h"
+#include "ROOT/TBufferMerger.hxx"
+
+// McDst headers
+#include "McArrays.h"
+
+#if ROOT_VERSION_CODE >= ROOT_VERSION(6,26,0)
+typedef ROOT::TBufferMerger McBufferMerger;
+typedef ROOT::TBufferMergerFile McBufferMergerFile;
+#else
+typedef ROOT::Experimental::TBufferMerger McBufferMerger;
+typedef ROOT::Experimental::TBufferMergerFile McBufferMergerFile;
+#endif
+
+//_________________
+class McDstParallelWriter {
+
+ public:
+
+  //_________________
+  class Slot {
+
+  public:
+    /// Constructor that takes in-memory file provided by the merger
+    Slot(std::shared_ptr<McBufferMergerFile> file, const Char_t* treeTitle,
+         Long64_t flushSize);
+    /// Destructor flushes the remaining entries
+    ~Slot();
+
+    /// Clear all TClonesArrays before a new event is added
+    void clear();
+    /// Return pointer to the TClonesArray of the given McArrays type
+    TClonesArray* array(Int_t type) const { return mArrays[type]; }
+    /// Fill the current event to the slot tree. Return number of bytes
+    Int_t fill();
+    /// Send compressed baskets to the merger
+    void flush();
+    /// Return number of events filled to this slot
+    Long64_t entries() const { return mEntries; }
+
+  private:
+    Slot(const Slot&) = delete;
+    Slot& operator=(const Slot&) = delete;
+
+    /// In-memory file that holds the slot tree
+    std::shared_ptr<McBufferMergerFile> mFile;
+    /// McDst tree of this slot (owned by mFile)
+    TTree *mTree;
+    /// Event and particle arrays
+    TClonesArray *mArrays[McArrays::NAllMcArrays];
+    /// Number of bytes after which baskets are sent to the merger
+    Long64_t mFlushSize;
+    /// Number of bytes filled since the last flush
+    Long64_t mBytes;
+    /// Number of events filled
+    Long64_t mEntries;
+  };
+
+  /// Constructor that takes output file name and compression settings
+  /// (algorithm * 100 + level, same as for TFile)
+  McDstParallelWriter(const Char_t* oFileName, Int_t compressionSettings,
+                      const Char_t* treeTitle = "McDst tree");
+  /// Destructor writes and closes the output file
+  virtual ~McDstParallelWriter();
+
+  /// Create a new slot (thread-safe). Each slot must be used
+  /// by one thread at a time
+  std::unique_ptr<Slot> createSlot();
+
+  /// Set number of bytes after which a slot sends its baskets
+  /// to the merger (default: 32 MB)
+  void setFlushSize(Long64_t bytes) { mFlushSize = bytes; }
+  /// Return number of bytes after which a slot sends its baskets
+  Long64_t flushSize() const        { return mFlushSize; }
+
+ private:
+  McDstParallelWriter(const McDstParallelWriter&) = delete;
+  McDstParallelWriter& operator=(const McDstParallelWriter&) = delete;
+
+  /// Buffer merger that writes the output file
+  std::unique_ptr<McBufferMerger> mMerger;
+  /// Title of the McDst trees
+  TString mTreeTitle;
+  /// Number of bytes after which a slot flushes
+  Long64_t mFlushSize;
+  /// Guards access to the merger from several threads
+  std::mutex mMutex;
+};
+
+#endif // McDstParallelWriter_h
@@ -0,0 +1,147 @@
+/**
+ * \class McDstQA
+ * \brief Produces quality assurance histograms for mcDst files
+ *
+ * All histograms are filled in one pass over the input, which is
+ * processed in several threads with McDstParallelReader. Every
+ * thread fills its own flat-array histograms (McHist1D/McHist2D),
+ * which are merged and converted to ROOT histograms at the end.
+ *
+ * The output file contains three directories:
+ *  - event: impact parameter, multiplicity of accepted particles,
+ *    number of participants and binary collisions and their
+ *    correlations with the impact parameter;
+ *  - particle: pT, eta, rapidity and phi of all accepted particles
+ *    and of every species found in the data, and PDG abundance;
+ *  - freezeout: x, y, z, t, tau and space-time rapidity of the
+ *    accepted particles.
+ * Particles are accepted by McDstCut if it is set.
+ */
+
+#ifndef McDstQA_h
+#define McDstQA_h
+
+// C++ headers
+#include <vector>
+#include <unordered_map>
+
+// ROOT headers
+#include "TString.h"
+
+// McDst headers
+#include "McDstCut.h"
+#include "McHist.h"
+
+// Forward declarations
+class McDstReader;
+class TDirectory;
+
+//_________________
+class McDstQA {
+
+ public:
+  /// Constructor that takes input (mcDst file or list of files) and
+  /// output file names, and number of threads (0 - number of hardware
+  /// threads)
+  McDstQA(const Char_t* iFileName, const Char_t* oFileName, UInt_t nThreads = 0);
+  /// Destructor
+  virtual ~McDstQA();
+
+  /// Set particle selection. The cut is copied
+  void setMcDstCut(McDstCut* cut);
+  /// Set number of threads (0 - number of hardware threads)
+  void setNumberOfThreads(UInt_t nThreads) { mNThreads = nThreads; }
+  /// Process only first nEvents events (all if negative)
+  void setMaxEvents(Long64_t nEvents)      { mMaxEvents = nEvents; }
+
+  /// Fill histograms and write them to the output file
+  void run();
+
+ private:
+  McDstQA(const McDstQA&) = delete;
+  McDstQA& operator=(const McDstQA&) = delete;
+
+  /// Codes with |pdg| below this value are looked up in the dense table
+  enum { kDenseRange = 10000 };
+
+  //_________________
+  /// Particle histograms of one species
+  struct Species {
+    Species();
+    void add(const Species& s);
+
+    McHist1D hPt;
+    McHist1D hEta;
+    McHist1D hRapidity;
+    McHist1D hPhi;
+  };
+
+  //_________________
+  /// Histograms filled by one thread
+  struct Histograms {
+    Histograms();
+    void add(const Histograms& h);
+    /// Return species histograms, created at the first call
+    Species& species(Int_t pdg);
+
+    // Event
+    McHist1D hImpactPar;
+    McHist1D hMult;
+    McHist1D hNpart;
+    McHist1D hNcoll;
+    McHist2D hMultVsImpactPar;
+    McHist2D hNpartVsImpactPar;
+    McHist2D hNcollVsImpactPar;
+
+    // Particle
+    McHist1D hPt;
+    McHist1D hEta;
+    McHist1D hRapidity;
+    McHist1D hPhi;
+    McHist2D hPtVsEta;
+    McHist2D hPtVsRapidity;
+
+    // Freeze-out
+    McHist1D hX;
+    McHist1D hY;
+    McHist1D hZ;
+    McHist1D hT;
+    McHist1D hTau;
+    McHist1D hEtaS;
+    McHist2D hXY;
+    McHist2D hTauVsEtaS;
+
+    /// Columns of the accepted particles of the current event
+    enum { kPt = 0, kEta, kRapidity, kPhi, kX, kY, kZ, kT, kTau, kEtaS, kNColumns };
+    std::vector<Float_t> mColumns[kNColumns];
+
+    /// Species index for |pdg| < kDenseRange
+    std::vector<Int_t> mDense;
+    /// Species index for other codes
+    std::unordered_map<Int_t, Int_t> mSparse;
+    /// PDG codes of the species
+    std::vector<Int_t> mPdg;
+    /// Species histograms
+    std::vector<Species> mSpecies;
+  };
+
+  /// Fill histograms with the current event of the reader
+  void fill(Histograms& h, McDstCut* cut, McDstReader* reader);
+  /// Write histograms to the output file
+  void write(const Histograms& h, Long64_t nEvents);
+  /// Write histogram to the directory and delete it
+  static void write(TDirectory* dir, TObject* h);
+
+  /// Input file name (mcDst file or list)
+  TString mInputFileName;
+  /// Output file name
+  TString mOutputFileName;
+  /// Number of threads
+  UInt_t mNThreads;
+  /// Maximal number of events to process
+  Long64_t mMaxEvents;
+  /// Particle selection (nullptr - accept all)
+  McDstCut *mCut;
+};
+
+#endif // McDstQA_h
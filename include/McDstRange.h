@@ -0,0 +1,102 @@
+/**
+ * \class McObjectRange, McIndexRange
+ * \brief Ranges for range-based for loops over mcDst data
+ *
+ * McObjectRange<T> iterates over the objects of a TClonesArray and
+ * yields T& (e.g. McParticle&). It walks the array of object
+ * pointers directly, so the loop body has no virtual calls.
+ *
+ * McIndexRange<View, Owner> yields View(owner, i) for consecutive
+ * indices i. It is used for the columnar storage (McDstColumns),
+ * where the views (McEventView, McParticleView) read the columns
+ * of the owner.
+ *
+ * Both are header-only and fully inlined.
+ */
+
+#ifndef McDstRange_h
+#define McDstRange_h
+
+// ROOT headers
+#include "TClonesArray.h"
+
+//_________________
+template <class T>
+class McObjectRange {
+
+ public:
+  //_________________
+  class iterator {
+  public:
+    explicit iterator(TObject** ptr) : mPtr(ptr) { /* empty */ }
+    T& operator*() const                   { return *static_cast<T*>(*mPtr); }
+    T* operator->() const                  { return static_cast<T*>(*mPtr); }
+    iterator& operator++()                 { ++mPtr; return *this; }
+    bool operator==(const iterator& it) const { return mPtr == it.mPtr; }
+    bool operator!=(const iterator& it) const { return mPtr != it.mPtr; }
+  private:
+    TObject **mPtr;
+  };
+
+  /// Constructor that takes the array (empty range if nullptr)
+  explicit McObjectRange(const TClonesArray* array) :
+    mBegin( array ? array->GetObjectRef() : nullptr ),
+    mSize( array ? array->GetEntriesFast() : 0 ) { /* empty */ }
+
+  iterator begin() const      { return iterator(mBegin); }
+  iterator end() const        { return iterator(mBegin + mSize); }
+  /// Return number of objects
+  Int_t size() const          { return mSize; }
+  /// Return true if there are no objects
+  bool empty() const          { return mSize == 0; }
+  /// Return i-th object
+  T& operator[](Int_t i) const { return *static_cast<T*>(mBegin[i]); }
+
+ private:
+  /// First object pointer of the array
+  TObject **mBegin;
+  /// Number of objects
+  Int_t mSize;
+};
+
+//_________________
+template <class View, class Owner>
+class McIndexRange {
+
+ public:
+  //_________________
+  class iterator {
+  public:
+    iterator(const Owner* owner, Long64_t i) : mOwner(owner), mIndex(i) { /* empty */ }
+    View operator*() const                 { return View(mOwner, mIndex); }
+    iterator& operator++()                 { ++mIndex; return *this; }
+    bool operator==(const iterator& it) const { return mIndex == it.mIndex; }
+    bool operator!=(const iterator& it) const { return mIndex != it.mIndex; }
+  private:
+    const Owner *mOwner;
+    Long64_t mIndex;
+  };
+
+  /// Constructor that takes owner and range of indices [first, last)
+  McIndexRange(const Owner* owner, Long64_t first, Long64_t last) :
+    mOwner(owner), mFirst(first), mLast(last) { /* empty */ }
+
+  iterator begin() const      { return iterator(mOwner, mFirst); }
+  iterator end() const        { return iterator(mOwner, mLast); }
+  /// Return number of elements
+  Long64_t size() const       { return mLast - mFirst; }
+  /// Return true if there are no elements
+  bool empty() const          { return mLast == mFirst; }
+  /// Return i-th element of the range
+  View operator[](Long64_t i) const { return View(mOwner, mFirst + i); }
+
+ private:
+  /// Owner of the data
+  const Owner *mOwner;
+  /// First index
+  Long64_t mFirst;
+  /// Index after the last one
+  Long64_t mLast;
+};
+
+#endif // McDstRange_h
@@ -0,0 +1,59 @@
+/**
+ * \class McDstReadAhead
+ * \brief Warms up the next file of the chain in the background
+ *
+ * When the chain enters a new file, McDstReader asks for the next one
+ * to be warmed up in a background thread: the file is opened (header,
+ * keys and streamer info are read), the tree metadata is loaded and
+ * the baskets of the first cluster of the branches being read are
+ * fetched with one vectored read. The file is then closed, so the
+ * chain opens it as usual, but the data come from the file system
+ * (or network client) cache instead of stalling the event loop.
+ *
+ * Only one file is warmed at a time: if the previous one is not done
+ * yet, the request is skipped rather than blocking the reader.
+ */
+
+#ifndef McDstReadAhead_h
+#define McDstReadAhead_h
+
+// C++ headers
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+//_________________
+class McDstReadAhead {
+
+ public:
+  /// Default constructor
+  McDstReadAhead();
+  /// Destructor (waits for the file being warmed)
+  virtual ~McDstReadAhead();
+
+  /// Warm up the tree of the file and the first cluster of the
+  /// branches. Return false if the previous file is still being warmed
+  Bool_t warm(const TString& fileName, const TString& treeName,
+              const std::vector<TString>& branches);
+  /// Return number of files warmed up
+  Long64_t numberOfFiles() const           { return mNFiles; }
+
+ private:
+  McDstReadAhead(const McDstReadAhead&) = delete;
+  McDstReadAhead& operator=(const McDstReadAhead&) = delete;
+
+  /// Body of the background thread
+  void run(TString fileName, TString treeName, std::vector<TString> branches);
+
+  /// Background thread
+  std::thread mThread;
+  /// Thread is warming a file
+  std::atomic<Bool_t> mBusy;
+  /// Number of files warmed up
+  std::atomic<Long64_t> mNFiles;
+};
+
+#endif // McDstReadAhead_h
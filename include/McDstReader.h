@@ -12,17 +12,33 @@
 #ifndef McDstReader_h
 #define McDstReader_h
 
+// C++ headers
+#include <vector>
+
 // ROOT headers
 #include "TChain.h"
 #include "TTree.h"
 #include "TFile.h"
 #include "TString.h"
 #include "TClonesArray.h"
+#include "TEntryList.h"
 
 // McDst headers
 #include "McDst.h"
+#include "McEvent.h"
+#include "McParticle.h"
 #include "McRun.h"
 #include "McArrays.h"
+#include "McDerivedColumns.h"
+#include "McDstRange.h"
+#include "McDstZoneMap.h"
+
+// Forward declarations
+class McDstEntryRange;
+class McDstColumns;
+class McDstSharedCache;
+class McDstStagingCache;
+class McDstReadAhead;
 
 //_________________
 class McDstReader : public TObject {
@@ -44,13 +60,129 @@ class McDstReader : public TObject {
   /// Return Run information
   McRun *run() const { return mMcRun; }
 
+  /// Return event of the current entry. Unlike McDst::event() it uses
+  /// the arrays of this reader, so several readers can be used in parallel
+  McEvent *event() const
+  { return (McEvent*)mMcArrays[McArrays::Event]->UncheckedAt(0); }
+  /// Return i-th particle of the current entry
+  McParticle *particle(Int_t i) const
+  { return (McParticle*)mMcArrays[McArrays::Particle]->UncheckedAt(i); }
+  /// Return number of particles in the current entry
+  UInt_t numberOfParticles() const
+  { return mMcArrays[McArrays::Particle]->GetEntriesFast(); }
+
+  /// Return particles of the current entry for range-based loops:
+  /// for (const McParticle& p : reader->particles()) { ... }
+  McObjectRange<McParticle> particles() const
+  { return McObjectRange<McParticle>(mMcArrays[McArrays::Particle]); }
+  /// Return TClonesArray with McArrays type of this reader
+  TClonesArray *array(Int_t type) const { return mMcArrays[type]; }
+  /// Return entries [first, last) for range-based loops. Every step
+  /// loads the next entry; the loop stops at the first failed read.
+  /// Indices are positions in the imported selection if there is one
+  /// (see entryNumber()). All entries are used if last is negative:
+  /// for (McDstReader& ev : reader->events()) { ev.event()->b(); }
+  inline McDstEntryRange events(Long64_t first = 0, Long64_t last = -1);
+
+  /// Return cache of the derived particle quantities of the current
+  /// entry (pT, eta, rapidity, ...), shared by all users of the reader
+  McDerivedColumns &derived() { return *mDerived; }
+
   /// Set enable/disable branch matching when reading uDst
   void setStatus(const Char_t* branchNameRegex, Int_t enable);
+  /// Read only the given data members (e.g. "fPx", "fPdg") of the
+  /// array with McArrays type. All members are read if the list is empty
+  void setFields(Int_t arrayType, const std::vector<TString>& fields);
+
+  //
+  // Selections (entry lists)
+  //
+
+  /// Return number of entries to process: number of events in memory
+  /// (see loadToMemory()), size of the selection imported with
+  /// readSelection(), or all entries of the chain
+  Long64_t numberOfEntries() const;
+  /// Return entry number of the i-th entry to process
+  Long64_t entryNumber(Long64_t i) const
+  { return (mSelectionIn && !mMemory) ? mChain->GetEntryNumber(i) : i; }
+  /// Add the current entry to the selection of this pass
+  void acceptEntry();
+  /// Return selection of this pass (nullptr if no entry was accepted)
+  TEntryList *selection() const { return mSelectionOut; }
+  /// Remove all entries from the selection of this pass
+  void clearSelection();
+  /// Write selection of this pass to the file. The entry list keeps
+  /// tree and file names, so it can be used with any chain that
+  /// contains the same files
+  Bool_t writeSelection(const Char_t* fileName, const Char_t* name = "mcDstSelection") const;
+  /// Read only the entries of the selection written by a previous pass.
+  /// The tree cache prefetches only clusters with selected entries.
+  /// Must be called after Init()
+  Bool_t readSelection(const Char_t* fileName, const Char_t* name = "mcDstSelection");
+  /// Read only the clusters where an event may pass the cut, according
+  /// to the zone maps of the files (see McDstZoneMap). Files without
+  /// zone map are read completely. Restricts the selection imported
+  /// with readSelection() if called after it. Must be called after Init()
+  Bool_t skipClusters(const McDstZoneMap::Cut& cut);
+
+  //
+  // In-memory dataset
+  //
+
+  /// Read all entries to process (e.g. the selected ones) into memory,
+  /// only the enabled arrays and data members are stored. Then the
+  /// entries are taken from memory: loadEntry(i) and loadBatch() use
+  /// the i-th event in memory, nothing is read from the files. Fails if
+  /// the data need more than maxBytes (no limit if not positive)
+  Bool_t loadToMemory(Long64_t maxBytes = 0);
+  /// Return events in memory (nullptr if not loaded). Passes that
+  /// iterate over memory()->events() run without copying
+  const McDstColumns *memory() const { return mMemory; }
+  /// Use events in memory loaded by another reader (not owned)
+  void setMemory(const McDstColumns* memory);
+  /// Release events in memory, entries are read from the files again
+  void releaseMemory();
+  /// Same as loadToMemory(), but the events are kept in a shared memory
+  /// cache (see McDstSharedCache) in the directory. The cache is filled
+  /// by the first process and used without copying by all processes
+  /// reading the same files, arrays, data members and selection
+  Bool_t loadToSharedMemory(Long64_t maxBytes = 0, const Char_t* directory = "/dev/shm");
+
+  /// Copy the input files to the local directory (e.g. on a SSD) in
+  /// the background and read the local copies once they are staged
+  /// (see McDstStagingCache). The copies are shared by the jobs on the
+  /// node. Must be called before Init()
+  void setStagingCache(const Char_t* directory, Long64_t maxBytes = 0);
+
+  /// Decompress the cached baskets of the upcoming entries in parallel
+  /// (TTreeCacheUnzip with the ROOT implicit multi-threading pool of
+  /// nThreads threads, default: number of cores). Only the branches
+  /// that are read are cached, so nothing else is decompressed. The
+  /// setting is global for all trees of the process. Is also enabled
+  /// in Init() by the environment variable MCDST_UNZIP_THREADS=<n>
+  void setParallelUnzip(Bool_t enable, UInt_t nThreads = 0);
+
+  /// Warm up the next file of the chain (metadata and the first
+  /// cluster of the branches being read) in the background while the
+  /// current one is processed (see McDstReadAhead). Not used with the
+  /// staging cache, which copies the next files anyway
+  void setReadAhead(Bool_t readAhead);
+
+  /// Add mcDst file or the files from the .list/.lis file to the chain.
+  /// Return number of added files
+  static Int_t addFiles(TChain* chain, const Char_t* inFileName);
 
   /// Calls openRead()
   void Init();
-  /// Read next event in the chain
+  /// Read entry iEntry of the chain (invalid entries are skipped),
+  /// or restore event iEntry from memory
   Bool_t loadEntry(Long64_t iEntry);
+  /// Read up to nEntries consecutive entries starting from first into
+  /// the columnar batch (previous content is removed). Indices are
+  /// positions in the selection if it is imported. Entries are read
+  /// branch by branch without TChain::GetEntry bookkeeping. Return number
+  /// of events in the batch. The current entry is the last one read
+  Long64_t loadBatch(Long64_t first, Long64_t nEntries, McDstColumns& batch);
   /// Close files and finilize
   void Finish();
 
@@ -68,6 +200,17 @@ class McDstReader : public TObject {
   void clearArrays();
   /// Set adresses of mcArrays and their statuses (enable/disable) to chain
   void setBranchAddresses(TChain *chain);
+  /// Return hash of the input files, of the data to read and of the selection
+  TString sharedCacheKey() const;
+  /// Return number of the tree of the chain that contains the entry
+  Int_t treeNumber(Long64_t iEntry) const;
+  /// Open the local copy of the file that contains the entry when the
+  /// chain moves to another file
+  void useStagedFile(Long64_t iEntry);
+  /// Warm up the file after the current one
+  void readAhead();
+  /// Put only the enabled branches (and data members) into the tree cache
+  void updateCache();
 
   /// Pointer to the input/output McDst structure
   McDst *mMcDst;
@@ -79,14 +222,90 @@ class McDstReader : public TObject {
   TTree *mTree;
 
   /// Event counter
-  Int_t mEventCounter;
+  Long64_t mEventCounter;
 
   /// Pointer to the TClonesArray with the data
   TClonesArray *mMcArrays[McArrays::NAllMcArrays];
+  /// Branches of the arrays in the current tree
+  TBranch *mBranches[McArrays::NAllMcArrays]; //!
   /// Status of the TClonesArray
   Char_t mStatusArrays[McArrays::NAllMcArrays];
+  /// Data members to read for every array (all if empty)
+  std::vector<TString> mFields[McArrays::NAllMcArrays]; //!
+  /// Derived quantities of the current entry
+  McDerivedColumns *mDerived; //!
+  /// Entries accepted in this pass
+  TEntryList *mSelectionOut; //!
+  /// Entries to read (imported from a previous pass)
+  TEntryList *mSelectionIn; //!
+  /// Events in memory
+  const McDstColumns *mMemory; //!
+  /// Events in memory are owned by the reader
+  Bool_t mOwnMemory; //!
+  /// Shared memory cache with the events in memory
+  McDstSharedCache *mSharedCache; //!
+  /// Local copies of the input files
+  McDstStagingCache *mStaging; //!
+  /// Input files of the chain
+  std::vector<TString> mStagingFiles; //!
+  /// Entries [first, last) of the file opened last
+  Long64_t mStagedEntries[2]; //!
+  /// Warms up the next file
+  McDstReadAhead *mReadAhead; //!
+  /// Number of the tree for which the next file has been requested
+  Int_t mReadAheadTree; //!
 
   ClassDef(McDstReader, 0)
 };
 
+//_________________
+class McDstEntryRange {
+
+ public:
+  //_________________
+  class iterator {
+  public:
+    iterator(McDstReader* reader, Long64_t i, Long64_t last) :
+      mReader(reader), mEntry(i), mLast(last) { load(); }
+    McDstReader& operator*() const         { return *mReader; }
+    McDstReader* operator->() const        { return mReader; }
+    iterator& operator++()                 { ++mEntry; load(); return *this; }
+    bool operator==(const iterator& it) const { return mEntry == it.mEntry; }
+    bool operator!=(const iterator& it) const { return mEntry != it.mEntry; }
+    /// Return current position in the range
+    Long64_t entry() const                 { return mEntry; }
+  private:
+    void load() {
+      if (mEntry < mLast && !mReader->loadEntry( mReader->entryNumber(mEntry) )) mEntry = mLast;
+    }
+    McDstReader *mReader;
+    Long64_t mEntry;
+    Long64_t mLast;
+  };
+
+  /// Constructor that takes reader and range of entries [first, last)
+  McDstEntryRange(McDstReader* reader, Long64_t first, Long64_t last) :
+    mReader(reader), mFirst(first), mLast(last) { /* empty */ }
+
+  /// Loads the first entry
+  iterator begin() const      { return iterator(mReader, mFirst, mLast); }
+  iterator end() const        { return iterator(mReader, mLast, mLast); }
+  /// Return number of entries
+  Long64_t size() const       { return mLast - mFirst; }
+
+ private:
+  McDstReader *mReader;
+  Long64_t mFirst;
+  Long64_t mLast;
+};
+
+//_________________
+inline McDstEntryRange McDstReader::events(Long64_t first, Long64_t last) {
+  const Long64_t nEntries = numberOfEntries();
+  if (last < 0 || last > nEntries) last = nEntries;
+  if (first < 0) first = 0;
+  if (first > last) first = last;
+  return McDstEntryRange(this, first, last);
+}
+
 #endif // McDstReader_h
@@ -0,0 +1,92 @@
+/**
+ * \class McDstSharedCache
+ * \brief Decoded mcDst events shared between processes via shared memory
+ *
+ * Keeps serialized McDstColumns in the file <directory>/mcdst_<key>.cache,
+ * by default on the tmpfs /dev/shm, so no service is needed. The key is
+ * a hash of the input files and of the data to read (see
+ * McDstReader::loadToSharedMemory()). The first process fills the
+ * cache: it holds the exclusive lock of <cache>.lock, writes the
+ * columns to a temporary file and renames it, so the cache file
+ * is always complete. Other processes wait for the lock, then map
+ * the file read-only and use the columns without copying.
+ *
+ * Every attached process holds a shared lock (flock) of the cache file,
+ * which serves as the reference count. When the total size of the
+ * caches in the directory exceeds the limit, the least recently used
+ * ones (by modification time, updated when attached) are removed,
+ * skipping the caches in use. Lock files of removed caches and temporary
+ * files of crashed writers are removed too. Cache and lock files are
+ * writable by all users, so jobs of different users share the caches;
+ * in a directory with the sticky bit, such as /dev/shm, only the caches
+ * of the same user can be removed.
+ */
+
+#ifndef McDstSharedCache_h
+#define McDstSharedCache_h
+
+// ROOT headers
+#include "TString.h"
+
+// McDst headers
+#include "McDstColumns.h"
+
+//_________________
+class McDstSharedCache {
+
+ public:
+  /// Constructor that takes the key of the data and the directory
+  McDstSharedCache(const Char_t* key, const Char_t* directory = "/dev/shm");
+  /// Destructor (detaches)
+  virtual ~McDstSharedCache();
+
+  /// Set limit on the total size of the caches in the directory
+  /// (default: half of the file system)
+  void setMaxTotalBytes(Long64_t bytes)     { mMaxTotalBytes = bytes; }
+
+  /// Take the exclusive lock to fill the cache (waits for the process
+  /// that fills it)
+  Bool_t lock();
+  /// Release the lock
+  void unlock();
+
+  /// Map the existing cache. Return false if it does not exist
+  Bool_t attach();
+  /// Write the columns to the cache (should be locked) and attach
+  Bool_t store(const McDstColumns& columns);
+  /// Unmap the cache
+  void detach();
+
+  /// Return true if the cache is mapped
+  Bool_t isAttached() const                 { return mColumns.isAttached(); }
+  /// Return columns of the cache
+  const McDstColumns *columns() const       { return isAttached() ? &mColumns : nullptr; }
+  /// Return name of the cache file
+  const Char_t *fileName() const            { return mFileName.Data(); }
+
+  /// Remove least recently used caches that are not in use until
+  /// their total size is below maxBytes. Return the total size
+  static Long64_t evict(const Char_t* directory, Long64_t maxBytes);
+
+ private:
+  McDstSharedCache(const McDstSharedCache&) = delete;
+  McDstSharedCache& operator=(const McDstSharedCache&) = delete;
+
+  /// Directory of the caches
+  TString mDirectory;
+  /// Cache and lock files
+  TString mFileName;
+  TString mLockFileName;
+  /// Limit on the total size of the caches
+  Long64_t mMaxTotalBytes;
+  /// Descriptors of the cache (shared lock) and lock files
+  Int_t mFd;
+  Int_t mLockFd;
+  /// Mapped file
+  void *mAddress;
+  Long64_t mSize;
+  /// Columns of the mapped file
+  McDstColumns mColumns;
+};
+
+#endif // McDstSharedCache_h
@@ -0,0 +1,99 @@
+/**
+ * \class McDstStagingCache
+ * \brief Local copies of the input files staged in the background
+ *
+ * Copies mcDst files from a slow (e.g. network) file system to a local
+ * directory, e.g. on a SSD, in a background thread ahead of the event
+ * loop. The copy of <path> is <directory>/mcdst_<hash>_<name>, where
+ * the hash depends on the path, size and modification time of the
+ * original, so a changed file is copied again. Copies are shared by
+ * all jobs on the node: the job that copies a file holds the exclusive
+ * lock of <copy>.lock, the others wait and reuse the copy. Files are
+ * written to a temporary name and renamed when complete.
+ *
+ * Jobs hold a shared lock (flock) of the copy they read. When the
+ * total size of the copies exceeds the limit, the least recently used
+ * ones (by modification time, updated when used) that are not being
+ * read are removed. Only a few files ahead of the one being read are
+ * staged (setFilesAhead()), so the job does not evict its own copies.
+ * Copies and lock files are writable by all users, so jobs of different
+ * users share them and keep their modification times up to date.
+ *
+ * The originals can be any files readable by TFile::Cp, so the cache
+ * can be tried with a local directory standing in for the remote one.
+ * Usually it is enabled with McDstReader::setStagingCache().
+ */
+
+#ifndef McDstStagingCache_h
+#define McDstStagingCache_h
+
+// C++ headers
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+//_________________
+class McDstStagingCache {
+
+ public:
+  /// Constructor that takes the local directory and the limit on the
+  /// total size of the copies (default: half of the file system)
+  McDstStagingCache(const Char_t* directory, Long64_t maxBytes = 0);
+  /// Destructor (waits for the copy in progress)
+  virtual ~McDstStagingCache();
+
+  /// Set number of files staged ahead of the one being read (default: 2)
+  void setFilesAhead(Int_t nFiles)            { mFilesAhead = nFiles; }
+
+  /// Start copying the files in the given order in the background
+  void prefetch(const std::vector<TString>& files);
+  /// Return the local copy of the file if it is staged, otherwise the
+  /// file itself. Waits if the file is being copied. The copy is kept
+  /// locked until the next call
+  TString localFile(const TString& file);
+
+  /// Remove least recently used copies that are not being read until
+  /// their total size is below maxBytes. Return the total size
+  Long64_t evict(Long64_t maxBytes) const;
+
+ private:
+  McDstStagingCache(const McDstStagingCache&) = delete;
+  McDstStagingCache& operator=(const McDstStagingCache&) = delete;
+
+  /// Status of the files
+  enum { kQueued, kCopying, kStaged, kFailed };
+
+  /// Return name of the local copy
+  TString stagedName(const TString& file) const;
+  /// Copy the file unless another job did it. Return true on success
+  Bool_t stage(const TString& file);
+  /// Body of the background thread
+  void run();
+
+  /// Local directory
+  TString mDirectory;
+  /// Limit on the total size of the copies
+  Long64_t mMaxBytes;
+  /// Number of files staged ahead
+  Int_t mFilesAhead;
+  /// Files to stage, the next one and the one being read
+  std::vector<TString> mFiles;
+  size_t mNext;
+  size_t mCurrent;
+  /// Status of every file
+  std::map<TString, Int_t> mStatus;
+  /// Descriptor of the copy being read (shared lock)
+  Int_t mFd;
+  /// Background thread
+  std::thread mThread;
+  std::mutex mMutex;
+  std::condition_variable mCondition;
+  Bool_t mStop;
+};
+
+#endif // McDstStagingCache_h
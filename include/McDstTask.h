@@ -0,0 +1,100 @@
+/**
+ * \class McDstTask
+ * \brief Base class of analysis tasks run by McDstTrain
+ *
+ * A task declares the data members of McEvent and McParticle it
+ * reads (e.g. "fB", "fPx", "fPy", "fPdg") in its constructor or in
+ * init(). The train reads only the union of the members declared
+ * by all tasks. Arrays for which a task declares nothing are not
+ * read for it, unless the task declares nothing at all, then it
+ * gets everything.
+ *
+ * process() is called for every event from several threads at the
+ * same time, each thread with its own slot number and reader, so
+ * the task must keep per-slot results (e.g. McHistReplicas) and
+ * merge them in finish().
+ *
+ * Example:
+ * ```
+ * class PtTask : public McDstTask {
+ *  public:
+ *   PtTask() : McDstTask("pt") {
+ *     addField(McArrays::Particle, "fPx");
+ *     addField(McArrays::Particle, "fPy");
+ *     addField(McArrays::Particle, "fPz");
+ *     addField(McArrays::Particle, "fE");
+ *     addField(McArrays::Particle, "fPdg");
+ *   }
+ *   void init(UInt_t nSlots) { mPt = new McHistReplicas<McHist1D>(McHist1D(100, 0., 5.), nSlots); }
+ *   void process(UInt_t slot, McDstReader* reader) {
+ *     // pT is computed once per event for all tasks
+ *     (*mPt)[slot].fill(reader->derived().pt(), reader->derived().size());
+ *   }
+ *   void finish() { mPt->merge().toTH1("hPt", "p_{T}")->Write(); }
+ *  private:
+ *   McHistReplicas<McHist1D> *mPt;
+ * };
+ * ```
+ */
+
+#ifndef McDstTask_h
+#define McDstTask_h
+
+// C++ headers
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+// McDst headers
+#include "McArrays.h"
+
+// Forward declarations
+class McDstReader;
+
+//_________________
+class McDstTask {
+
+ public:
+  /// Constructor that takes name of the task
+  McDstTask(const Char_t* name);
+  /// Destructor
+  virtual ~McDstTask();
+
+  /// Return name of the task
+  const Char_t* name() const  { return mName.Data(); }
+
+  /// Declare data member of the array with McArrays type that is read by the task
+  void addField(Int_t arrayType, const Char_t* field);
+  /// Declare that the task reads all data members of the array
+  void addAllFields(Int_t arrayType);
+  /// Declare that the task does not read the array
+  void skipArray(Int_t arrayType);
+
+  /// Return true if the task reads the array
+  Bool_t usesArray(Int_t arrayType) const;
+  /// Return true if the task reads all members of the array
+  Bool_t usesAllFields(Int_t arrayType) const;
+  /// Return members of the array declared by the task
+  const std::vector<TString>& fields(Int_t arrayType) const { return mFields[arrayType]; }
+
+  /// Called before the event loop with the number of slots (threads)
+  virtual void init(UInt_t nSlots);
+  /// Called for every event. Calls with different slots run concurrently
+  virtual void process(UInt_t slot, McDstReader* reader) = 0;
+  /// Called after the event loop
+  virtual void finish();
+
+ private:
+  /// Usage of an array
+  enum { kUndeclared = 0, kSkip, kFields, kAllFields };
+
+  /// Name of the task
+  TString mName;
+  /// Usage of the arrays
+  Int_t mUsage[McArrays::NAllMcArrays];
+  /// Declared members of the arrays
+  std::vector<TString> mFields[McArrays::NAllMcArrays];
+};
+
+#endif // McDstTask_h
@@ -0,0 +1,69 @@
+/**
+ * \class McDstTrain
+ * \brief Runs several analysis tasks in one pass over mcDst files
+ *
+ * Tasks (classes derived from McDstTask) are added with addTask().
+ * The train enables only the arrays and data members that are
+ * declared by at least one task, reads every event once and calls
+ * all tasks with it. Events are processed by several threads
+ * (see McDstParallelReader): each thread runs the tasks one after
+ * another on its event, while the other threads run the tasks on
+ * other events, so all tasks and events are processed in parallel.
+ */
+
+#ifndef McDstTrain_h
+#define McDstTrain_h
+
+// C++ headers
+#include <vector>
+
+// ROOT headers
+#include "TString.h"
+
+// Forward declarations
+class McDstTask;
+
+//_________________
+class McDstTrain {
+
+ public:
+  /// Constructor that takes either mcDst file or file that contains
+  /// a list of mcDst.root files and number of threads (0 - number
+  /// of hardware threads)
+  McDstTrain(const Char_t* inFileName, UInt_t nThreads = 0);
+  /// Destructor. Tasks are not deleted
+  virtual ~McDstTrain();
+
+  /// Add task. Tasks are called in the order they were added
+  void addTask(McDstTask* task);
+  /// Return number of tasks
+  UInt_t numberOfTasks() const          { return mTasks.size(); }
+  /// Process only first nEvents events (all if negative)
+  void setMaxEvents(Long64_t nEvents)   { mMaxEvents = nEvents; }
+  /// Process only the entries of the selection file of a previous pass
+  void readSelection(const Char_t* fileName) { mSelectionInput = fileName; }
+  /// Write entries accepted by the tasks (McDstReader::acceptEntry)
+  /// to the selection file after the run
+  void writeSelection(const Char_t* fileName) { mSelectionOutput = fileName; }
+
+  /// Run all tasks over the input. Return number of processed events
+  Long64_t run();
+
+ private:
+  McDstTrain(const McDstTrain&) = delete;
+  McDstTrain& operator=(const McDstTrain&) = delete;
+
+  /// Name of the inputfile (or of the inputfiles.list)
+  TString mInputFileName;
+  /// Number of threads
+  UInt_t mNThreads;
+  /// Maximal number of events to process
+  Long64_t mMaxEvents;
+  /// Tasks
+  std::vector<McDstTask*> mTasks;
+  /// Selection files to read and to write
+  TString mSelectionInput;
+  TString mSelectionOutput;
+};
+
+#endif // McDstTrain_h
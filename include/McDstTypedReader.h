@@ -0,0 +1,282 @@
+/**
+ * \class McDstTypedReader
+ * \brief Reads only the data members selected at compile time
+ *
+ * The data members to read are given as template arguments,
+ * e.g. McDstTypedReader<McField::Pdg, McField::Px, McField::Py>.
+ * Like the code generated by TTree::MakeClass, the reader works in
+ * the MakeClass mode: only the branches of the selected members
+ * (e.g. "Particle.fPx") and the sizes of their arrays are enabled,
+ * and they are read directly into flat arrays, one per member, without
+ * creating McParticle/McEvent objects. Branch names are built from the
+ * field types once in the constructor, there is no string matching
+ * when entries are read.
+ *
+ * Values are accessed by field type, so a field that is not read is
+ * a compile-time error:
+ * ```
+ * typedef McDstTypedReader<McField::Pdg, McField::Px, McField::Py, McField::B> Reader;
+ * Reader reader("list.lis");
+ * for (Long64_t i = 0; i < reader.entries(); ++i) {
+ *   if (!reader.loadEntry(i)) break;
+ *   Float_t b = reader.get<McField::B>();
+ *   for (const auto& p : reader.particles()) {
+ *     if (p.get<McField::Pdg>() == 211) h.fill( p.get<McField::Px>() );
+ *   }
+ * }
+ * ```
+ * Whole arrays of the entry are returned by column<F>().
+ * The arrays are resized when a file with larger events is opened.
+ */
+
+#ifndef McDstTypedReader_h
+#define McDstTypedReader_h
+
+// C++ headers
+#include <iostream>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+// ROOT headers
+#include "TChain.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TString.h"
+
+// McDst headers
+#include "McArrays.h"
+#include "McDstRange.h"
+#include "McDstReader.h"
+
+//
+// Data members that can be read by McDstTypedReader
+//
+namespace McField {
+
+  /// Type, array (McArrays) and number of values per object of the member
+  template <class T, Int_t A, Int_t W = 1>
+  struct Base {
+    typedef T type;
+    enum { array = A, width = W };
+  };
+
+  // McEvent members
+  struct EventNr : Base<UInt_t, McArrays::Event>   { static const Char_t* name() { return "fEventNr"; } };
+  struct B : Base<Float_t, McArrays::Event>         { static const Char_t* name() { return "fB"; } };
+  struct Phi : Base<Float_t, McArrays::Event>       { static const Char_t* name() { return "fPhi"; } };
+  struct Nes : Base<UShort_t, McArrays::Event>      { static const Char_t* name() { return "fNes"; } };
+  struct StepNr : Base<UShort_t, McArrays::Event>   { static const Char_t* name() { return "fStepNr"; } };
+  struct StepT : Base<Float_t, McArrays::Event>     { static const Char_t* name() { return "fStepT"; } };
+  struct Npart : Base<Short_t, McArrays::Event>     { static const Char_t* name() { return "fNpart"; } };
+  struct Ncoll : Base<Short_t, McArrays::Event>     { static const Char_t* name() { return "fNcoll"; } };
+
+  // McParticle members
+  struct Index : Base<UShort_t, McArrays::Particle>       { static const Char_t* name() { return "fIndex"; } };
+  struct Pdg : Base<Int_t, McArrays::Particle>            { static const Char_t* name() { return "fPdg"; } };
+  struct Status : Base<Char_t, McArrays::Particle>        { static const Char_t* name() { return "fStatus"; } };
+  struct Parent : Base<UShort_t, McArrays::Particle>      { static const Char_t* name() { return "fParent"; } };
+  struct ParentDecay : Base<UShort_t, McArrays::Particle> { static const Char_t* name() { return "fParentDecay"; } };
+  struct Mate : Base<UShort_t, McArrays::Particle>        { static const Char_t* name() { return "fMate"; } };
+  struct Decay : Base<Short_t, McArrays::Particle>        { static const Char_t* name() { return "fDecay"; } };
+  /// First and last child, two values per particle
+  struct Child : Base<UShort_t, McArrays::Particle, 2>    { static const Char_t* name() { return "fChild[2]"; } };
+  struct Px : Base<Float_t, McArrays::Particle>           { static const Char_t* name() { return "fPx"; } };
+  struct Py : Base<Float_t, McArrays::Particle>           { static const Char_t* name() { return "fPy"; } };
+  struct Pz : Base<Float_t, McArrays::Particle>           { static const Char_t* name() { return "fPz"; } };
+  struct E : Base<Float_t, McArrays::Particle>            { static const Char_t* name() { return "fE"; } };
+  struct X : Base<Float_t, McArrays::Particle>            { static const Char_t* name() { return "fX"; } };
+  struct Y : Base<Float_t, McArrays::Particle>            { static const Char_t* name() { return "fY"; } };
+  struct Z : Base<Float_t, McArrays::Particle>            { static const Char_t* name() { return "fZ"; } };
+  struct T : Base<Float_t, McArrays::Particle>            { static const Char_t* name() { return "fT"; } };
+
+  /// Position of the field F in the list of fields
+  template <class F, class... Fields>
+  struct IndexOf {
+    static_assert(sizeof(F) == 0, "The field is not read by McDstTypedReader");
+  };
+  template <class F, class... Rest>
+  struct IndexOf<F, F, Rest...> {
+    enum { value = 0 };
+  };
+  template <class F, class G, class... Rest>
+  struct IndexOf<F, G, Rest...> {
+    enum { value = 1 + IndexOf<F, Rest...>::value };
+  };
+
+} // namespace McField
+
+//_________________
+template <class Reader>
+class McTypedParticle {
+
+ public:
+  /// Constructor that takes reader and particle index
+  McTypedParticle(const Reader* reader, Long64_t i) : mReader(reader), mI((Int_t)i) { /* empty */ }
+
+  /// Return value of the field (the first one for McField::Child)
+  template <class F>
+  typename F::type get() const { return mReader->template get<F>(mI); }
+  /// Return index of the particle in the event
+  Int_t entry() const { return mI; }
+
+ private:
+  const Reader *mReader;
+  Int_t mI;
+};
+
+//_________________
+template <class... Fields>
+class McDstTypedReader {
+
+ public:
+  typedef McTypedParticle< McDstTypedReader<Fields...> > Particle;
+  typedef McIndexRange<Particle, McDstTypedReader<Fields...> > ParticleRange;
+
+  /// Constructor that takes either mcDst file or file that
+  /// contains a list of mcDst.root files
+  McDstTypedReader(const Char_t* inFileName);
+  /// Destructor
+  ~McDstTypedReader() { delete mChain; }
+
+  /// Return pointer to the chain
+  TChain *chain() const { return mChain; }
+  /// Return number of entries in the chain
+  Long64_t entries() const { return mChain->GetEntries(); }
+  /// Read selected members of the entry iEntry
+  Bool_t loadEntry(Long64_t iEntry);
+
+  /// Return number of particles in the current entry
+  Int_t numberOfParticles() const { return mCount[McArrays::Particle]; }
+  /// Return particles of the current entry for range-based loops
+  ParticleRange particles() const { return ParticleRange(this, 0, numberOfParticles()); }
+
+  /// Return values of the field for all objects of the current entry
+  template <class F>
+  const typename F::type* column() const
+  { return std::get< McField::IndexOf<F, Fields...>::value >(mColumns).data(); }
+  /// Return value of the field of the i-th object (event fields: i = 0)
+  template <class F>
+  typename F::type get(Int_t i = 0) const { return column<F>()[i * F::width]; }
+
+  /// Return true if one of the fields is in the array
+  static constexpr bool usesArray(Int_t type) { return ( (Fields::array == type) || ... ); }
+
+ private:
+  McDstTypedReader(const McDstTypedReader&) = delete;
+  McDstTypedReader& operator=(const McDstTypedReader&) = delete;
+
+  /// Name of the branch of the field
+  template <class F>
+  static TString branchName() { return Form("%s.%s", McArrays::mcArrayNames[F::array], F::name()); }
+
+  /// Resize arrays and set branch addresses of all fields
+  template <size_t... I>
+  void setAddresses(std::index_sequence<I...>) { (setAddress<I>(), ...); }
+  /// Resize array of the I-th field and set its branch address
+  template <size_t I>
+  void setAddress() {
+    typedef typename std::tuple_element< I, std::tuple<Fields...> >::type F;
+    std::vector<typename F::type> &values = std::get<I>(mColumns);
+    values.resize(mCapacity[F::array] * F::width);
+    mChain->SetBranchAddress(branchName<F>(), values.data(), mBranches + I);
+  }
+  /// Update array sizes to the largest event of the new tree
+  void updateCapacity();
+
+  /// Chain in the MakeClass mode
+  TChain *mChain;
+  /// Number of the current tree of the chain
+  Int_t mTreeNumber;
+  /// Number of objects of every array in the current entry
+  Int_t mCount[McArrays::NAllMcArrays];
+  /// Number of objects the arrays can hold
+  Int_t mCapacity[McArrays::NAllMcArrays];
+  /// Branches with the array sizes
+  TBranch *mCountBranches[McArrays::NAllMcArrays];
+  /// Branches of the fields
+  TBranch *mBranches[sizeof...(Fields)];
+  /// Values of the fields
+  std::tuple< std::vector<typename Fields::type>... > mColumns;
+};
+
+//_________________
+template <class... Fields>
+McDstTypedReader<Fields...>::McDstTypedReader(const Char_t* inFileName) :
+  mChain(new TChain("McDst")), mTreeNumber(-1), mCount{}, mCapacity{},
+  mCountBranches{}, mBranches{}, mColumns() {
+  // Constructor
+  static_assert(sizeof...(Fields) > 0, "McDstTypedReader needs at least one field");
+
+  McDstReader::addFiles(mChain, inFileName);
+  mChain->SetMakeClass(1);
+  mChain->SetBranchStatus("*", 0);
+  mChain->SetCacheSize(50e6);
+
+  for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+    mCapacity[iArr] = McArrays::mcArraySizes[iArr];
+    if (!usesArray(iArr)) continue;
+    const Char_t *bname = McArrays::mcArrayNames[iArr];
+    mChain->SetBranchStatus(bname, 1);
+    mChain->SetBranchAddress(bname, mCount + iArr, mCountBranches + iArr);
+    mChain->AddBranchToCache(bname);
+  }
+
+  const TString names[] = { branchName<Fields>()... };
+  for (size_t i = 0; i < sizeof...(Fields); ++i) {
+    mChain->SetBranchStatus(names[i], 1);
+    mChain->AddBranchToCache(names[i]);
+  }
+  setAddresses(std::index_sequence_for<Fields...>());
+}
+
+//_________________
+template <class... Fields>
+void McDstTypedReader<Fields...>::updateCapacity() {
+  // Arrays must hold the largest event of the tree
+  Bool_t resize = kFALSE;
+  for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+    if (!usesArray(iArr)) continue;
+    TBranchElement *branch =
+      dynamic_cast<TBranchElement*>( mChain->GetTree()->GetBranch(McArrays::mcArrayNames[iArr]) );
+    if (!branch) continue;
+    const Int_t maximum = branch->GetMaximum();
+    if (maximum > mCapacity[iArr]) {
+      mCapacity[iArr] = maximum;
+      resize = kTRUE;
+    }
+  }
+  if (resize) setAddresses(std::index_sequence_for<Fields...>());
+}
+
+//_________________
+template <class... Fields>
+Bool_t McDstTypedReader<Fields...>::loadEntry(Long64_t iEntry) {
+  // Read selected branches of the entry
+  const Long64_t localEntry = mChain->LoadTree(iEntry);
+  if (localEntry < 0) {
+    std::cout << "[WARNING] McDstTypedReader::loadEntry: cannot load entry "
+              << iEntry << std::endl;
+    return kFALSE;
+  }
+  if (mChain->GetTreeNumber() != mTreeNumber) {
+    mTreeNumber = mChain->GetTreeNumber();
+    updateCapacity();
+  }
+
+  Int_t bytes = 0;
+  for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+    if (mCountBranches[iArr]) bytes += mCountBranches[iArr]->GetEntry(localEntry);
+  }
+  for (size_t i = 0; i < sizeof...(Fields); ++i) {
+    if (mBranches[i]) bytes += mBranches[i]->GetEntry(localEntry);
+  }
+  if (bytes <= 0) {
+    std::cout << "[WARNING] McDstTypedReader::loadEntry: I/O error while reading entry "
+              << iEntry << std::endl;
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+#endif // McDstTypedReader_h
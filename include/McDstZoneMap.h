@@ -0,0 +1,115 @@
+/**
+ * \class McDstZoneMap
+ * \brief Per-cluster statistics (zone map) of the McEvent fields
+ *
+ * For every cluster of entries of the McDst tree keeps the minimal and
+ * maximal values of the impact parameter, of the number of particles
+ * (multiplicity), of the event number and of the time step number.
+ * The zone map is stored as a small TTree "McDstZoneMap" (one entry
+ * per cluster) next to the McDst tree, e.g. by the mcdst-zonemap tool:
+ * ```
+ * TFile *file = TFile::Open("file.mcDst.root", "update");
+ * McDstZoneMap zones;
+ * zones.build( (TTree*)file->Get("McDst") );
+ * zones.write(file);
+ * ```
+ * McDstReader::skipClusters() uses the zone maps to read only the
+ * clusters where an event may pass the cut, the baskets of the other
+ * clusters are neither read nor decompressed. Events of the read
+ * clusters must still be checked by the analysis.
+ */
+
+#ifndef McDstZoneMap_h
+#define McDstZoneMap_h
+
+// C++ headers
+#include <vector>
+#include <limits>
+
+// ROOT headers
+#include "Rtypes.h"
+
+// Forward declarations
+class TTree;
+class TDirectory;
+
+//_________________
+class McDstZoneMap {
+
+ public:
+  /// Statistics of the entries [firstEntry, lastEntry) of one cluster
+  struct Zone {
+    Long64_t firstEntry;
+    Long64_t lastEntry;
+    Float_t bMin, bMax;
+    Int_t multMin, multMax;
+    UInt_t eventNrMin, eventNrMax;
+    UShort_t stepNrMin, stepNrMax;
+  };
+
+  /// Ranges (inclusive) of the McEvent fields to select
+  class Cut {
+   public:
+    /// Constructor, all events are accepted
+    Cut() : mB{ -std::numeric_limits<Float_t>::max(), std::numeric_limits<Float_t>::max() },
+            mMult{ 0, std::numeric_limits<Int_t>::max() },
+            mEventNr{ 0, std::numeric_limits<UInt_t>::max() },
+            mStepNr{ 0, std::numeric_limits<UShort_t>::max() } { /* empty */ }
+
+    void setB(Float_t lo, Float_t hi)               { mB[0] = lo; mB[1] = hi; }
+    void setMultiplicity(Int_t lo, Int_t hi)        { mMult[0] = lo; mMult[1] = hi; }
+    void setEventNr(UInt_t lo, UInt_t hi)           { mEventNr[0] = lo; mEventNr[1] = hi; }
+    void setStepNr(UShort_t lo, UShort_t hi)        { mStepNr[0] = lo; mStepNr[1] = hi; }
+
+    /// Return true if an event of the zone may pass the cut
+    Bool_t mayMatch(const Zone& zone) const {
+      return zone.bMax >= mB[0] && zone.bMin <= mB[1] &&
+        zone.multMax >= mMult[0] && zone.multMin <= mMult[1] &&
+        zone.eventNrMax >= mEventNr[0] && zone.eventNrMin <= mEventNr[1] &&
+        zone.stepNrMax >= mStepNr[0] && zone.stepNrMin <= mStepNr[1];
+    }
+    /// Return true if the event passes the cut
+    Bool_t isGoodEvent(Float_t b, Int_t mult, UInt_t eventNr, UShort_t stepNr) const {
+      return b >= mB[0] && b <= mB[1] && mult >= mMult[0] && mult <= mMult[1] &&
+        eventNr >= mEventNr[0] && eventNr <= mEventNr[1] &&
+        stepNr >= mStepNr[0] && stepNr <= mStepNr[1];
+    }
+
+   private:
+    Float_t mB[2];
+    Int_t mMult[2];
+    UInt_t mEventNr[2];
+    UShort_t mStepNr[2];
+  };
+
+  /// Default constructor
+  McDstZoneMap() : mZones() { /* empty */ }
+  /// Destructor
+  virtual ~McDstZoneMap() { /* empty */ }
+
+  /// Compute statistics of all clusters of the McDst tree. Only the
+  /// needed McEvent members and the array sizes are read
+  Bool_t build(TTree* tree);
+  /// Write the zone map to the directory (replaces the old one)
+  Bool_t write(TDirectory* dir) const;
+  /// Read the zone map from the directory. Return false if there is none
+  Bool_t read(TDirectory* dir);
+
+  /// Return true if the zones are contiguous and cover exactly the
+  /// entries [0, nEntries) of the tree, e.g. not after hadd
+  Bool_t covers(Long64_t nEntries) const;
+
+  /// Return number of zones (clusters)
+  Int_t numberOfZones() const                  { return mZones.size(); }
+  /// Return all zones
+  const std::vector<Zone>& zones() const       { return mZones; }
+
+  /// Name of the zone map tree
+  static const Char_t *treeName()              { return "McDstZoneMap"; }
+
+ private:
+  /// Statistics of the clusters
+  std::vector<Zone> mZones;
+};
+
+#endif // McDstZoneMap_h
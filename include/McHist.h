@@ -0,0 +1,330 @@
+/**
+ * \class McHist1D, McHist2D, McHist3D
+ * \brief Fixed-binning histograms over flat arrays
+ *
+ * Light-weight accumulators for hot analysis loops. Bin contents
+ * (and sums of squared weights, once a weighted fill happens) are
+ * kept in flat arrays with the same layout as in ROOT, i.e. with
+ * underflow and overflow bins, so the conversion to TH1D/TH2D/TH3D
+ * is a plain copy. Fills are not virtual and take no locks: each
+ * thread fills its own copy (see McHistReplicas) and the copies are
+ * added up at the end.
+ *
+ * The batch fill methods take arrays of coordinates (e.g. columns
+ * of the particle properties of an event). Bin indices of a block
+ * of values are computed first in a branch-free loop that the
+ * compiler vectorizes, then the block is accumulated.
+ */
+
+#ifndef McHist_h
+#define McHist_h
+
+// C++ headers
+#include <vector>
+#include <thread>
+#include <algorithm>
+
+// ROOT headers
+#include "Rtypes.h"
+
+// Forward declarations
+class TH1;
+class TH1D;
+class TH2D;
+class TH3D;
+
+//_________________
+class McHistAxis {
+
+ public:
+  /// Constructor that takes number of bins and axis range
+  McHistAxis(Int_t nBins = 1, Double_t min = 0., Double_t max = 1.) :
+    mNBins( (nBins > 0) ? nBins : 1 ), mMin(min), mMax(max),
+    mInvWidth( mNBins / (max - min) ) { /* empty */ }
+
+  /// Return number of bins
+  Int_t nBins() const   { return mNBins; }
+  /// Return lower edge of the axis
+  Double_t min() const  { return mMin; }
+  /// Return upper edge of the axis
+  Double_t max() const  { return mMax; }
+
+  /// Return bin number: 0 - underflow, nBins()+1 - overflow (also for NaN)
+  Int_t bin(Double_t x) const {
+    // Clamp before the conversion, so it is defined and branch-free
+    Double_t t = (x - mMin) * mInvWidth;
+    t = (t < 0.) ? -1. : t;
+    t = (t < mNBins) ? t : mNBins;
+    return 1 + (Int_t)t;
+  }
+
+  /// Return true if axes have the same binning
+  Bool_t operator==(const McHistAxis& axis) const
+  { return mNBins == axis.mNBins && mMin == axis.mMin && mMax == axis.mMax; }
+
+ private:
+  /// Number of bins
+  Int_t mNBins;
+  /// Lower edge
+  Double_t mMin;
+  /// Upper edge
+  Double_t mMax;
+  /// Number of bins per unit
+  Double_t mInvWidth;
+};
+
+//_________________
+class McHistBase {
+
+ public:
+  /// Size of the blocks in batch fills
+  enum { kBlockSize = 256 };
+
+  /// Return number of cells (including underflow and overflow bins)
+  Int_t nCells() const                     { return mSumw.size(); }
+  /// Return content of the cell with the global bin number
+  Double_t content(Int_t bin) const        { return mSumw[bin]; }
+  /// Return sum of squared weights of the cell
+  Double_t sumw2(Int_t bin) const          { return mSumw2.empty() ? mSumw[bin] : mSumw2[bin]; }
+  /// Return number of entries
+  Long64_t entries() const                 { return mEntries; }
+  /// Return true if weighted fills were made
+  Bool_t isWeighted() const                { return !mSumw2.empty(); }
+
+  /// Reset contents
+  void reset();
+
+ protected:
+  /// Constructor that takes number of cells
+  McHistBase(Int_t nCells) : mSumw(nCells, 0.), mSumw2(), mEntries(0) { /* empty */ }
+
+  /// Add weight to the cell
+  void addBin(Int_t bin, Double_t w) {
+    if (w != 1. && mSumw2.empty()) setWeighted();
+    mSumw[bin] += w;
+    if (!mSumw2.empty()) mSumw2[bin] += w * w;
+    ++mEntries;
+  }
+  /// Add weights (unit weights if w is nullptr) to the cells
+  void addBins(const Int_t* bins, Int_t n, const Double_t* w) {
+    if (w) {
+      if (mSumw2.empty()) setWeighted();
+      for (Int_t i = 0; i < n; ++i) {
+        mSumw[bins[i]] += w[i];
+        mSumw2[bins[i]] += w[i] * w[i];
+      }
+    }
+    else {
+      for (Int_t i = 0; i < n; ++i) {
+        mSumw[bins[i]] += 1.;
+      }
+      if (!mSumw2.empty()) {
+        for (Int_t i = 0; i < n; ++i) {
+          mSumw2[bins[i]] += 1.;
+        }
+      }
+    }
+    mEntries += n;
+  }
+  /// Add contents of a histogram with the same binning
+  void addBase(const McHistBase& hist);
+  /// Copy contents to ROOT histogram with the same binning
+  void copyTo(TH1* h, Double_t* array) const;
+
+ private:
+  /// Start keeping sums of squared weights. All previous fills had unit weights
+  void setWeighted() { mSumw2 = mSumw; }
+
+  /// Sums of weights
+  std::vector<Double_t> mSumw;
+  /// Sums of squared weights (empty while all weights are 1)
+  std::vector<Double_t> mSumw2;
+  /// Number of entries
+  Long64_t mEntries;
+};
+
+//_________________
+class McHist1D : public McHistBase {
+
+ public:
+  /// Constructor that takes binning
+  McHist1D(Int_t nBins = 1, Double_t min = 0., Double_t max = 1.) :
+    McHistBase(nBins + 2), mX(nBins, min, max) { /* empty */ }
+
+  /// Return axis
+  const McHistAxis& xAxis() const { return mX; }
+
+  /// Fill value with weight
+  void fill(Double_t x, Double_t w = 1.) { addBin(mX.bin(x), w); }
+
+  /// Fill n values with weights (unit weights if w is nullptr)
+  template <class T>
+  void fill(const T* x, Long64_t n, const Double_t* w = nullptr) {
+    Int_t bins[kBlockSize];
+    for (Long64_t first = 0; first < n; first += kBlockSize) {
+      const Int_t nBlock = (Int_t)std::min<Long64_t>(kBlockSize, n - first);
+      const T *xb = x + first;
+      for (Int_t i = 0; i < nBlock; ++i) {
+        bins[i] = mX.bin(xb[i]);
+      }
+      addBins(bins, nBlock, w ? w + first : nullptr);
+    }
+  }
+
+  /// Add histogram with the same binning
+  void add(const McHist1D& hist);
+  /// Create ROOT histogram with the contents
+  TH1D* toTH1(const Char_t* name, const Char_t* title) const;
+
+ private:
+  /// X axis
+  McHistAxis mX;
+};
+
+//_________________
+class McHist2D : public McHistBase {
+
+ public:
+  /// Constructor that takes binning
+  McHist2D(Int_t nBinsX = 1, Double_t xMin = 0., Double_t xMax = 1.,
+           Int_t nBinsY = 1, Double_t yMin = 0., Double_t yMax = 1.) :
+    McHistBase( (nBinsX + 2) * (nBinsY + 2) ),
+    mX(nBinsX, xMin, xMax), mY(nBinsY, yMin, yMax) { /* empty */ }
+
+  /// Return X axis
+  const McHistAxis& xAxis() const { return mX; }
+  /// Return Y axis
+  const McHistAxis& yAxis() const { return mY; }
+
+  /// Fill value with weight
+  void fill(Double_t x, Double_t y, Double_t w = 1.)
+  { addBin(mX.bin(x) + (mX.nBins() + 2) * mY.bin(y), w); }
+
+  /// Fill n pairs of values with weights (unit weights if w is nullptr)
+  template <class T>
+  void fill(const T* x, const T* y, Long64_t n, const Double_t* w = nullptr) {
+    Int_t bins[kBlockSize];
+    const Int_t strideY = mX.nBins() + 2;
+    for (Long64_t first = 0; first < n; first += kBlockSize) {
+      const Int_t nBlock = (Int_t)std::min<Long64_t>(kBlockSize, n - first);
+      const T *xb = x + first;
+      const T *yb = y + first;
+      for (Int_t i = 0; i < nBlock; ++i) {
+        bins[i] = mX.bin(xb[i]) + strideY * mY.bin(yb[i]);
+      }
+      addBins(bins, nBlock, w ? w + first : nullptr);
+    }
+  }
+
+  /// Add histogram with the same binning
+  void add(const McHist2D& hist);
+  /// Create ROOT histogram with the contents
+  TH2D* toTH2(const Char_t* name, const Char_t* title) const;
+
+ private:
+  /// X axis
+  McHistAxis mX;
+  /// Y axis
+  McHistAxis mY;
+};
+
+//_________________
+class McHist3D : public McHistBase {
+
+ public:
+  /// Constructor that takes binning
+  McHist3D(Int_t nBinsX = 1, Double_t xMin = 0., Double_t xMax = 1.,
+           Int_t nBinsY = 1, Double_t yMin = 0., Double_t yMax = 1.,
+           Int_t nBinsZ = 1, Double_t zMin = 0., Double_t zMax = 1.) :
+    McHistBase( (nBinsX + 2) * (nBinsY + 2) * (nBinsZ + 2) ),
+    mX(nBinsX, xMin, xMax), mY(nBinsY, yMin, yMax), mZ(nBinsZ, zMin, zMax) { /* empty */ }
+
+  /// Return X axis
+  const McHistAxis& xAxis() const { return mX; }
+  /// Return Y axis
+  const McHistAxis& yAxis() const { return mY; }
+  /// Return Z axis
+  const McHistAxis& zAxis() const { return mZ; }
+
+  /// Fill value with weight
+  void fill(Double_t x, Double_t y, Double_t z, Double_t w = 1.) {
+    const Int_t strideY = mX.nBins() + 2;
+    const Int_t strideZ = strideY * (mY.nBins() + 2);
+    addBin(mX.bin(x) + strideY * mY.bin(y) + strideZ * mZ.bin(z), w);
+  }
+
+  /// Fill n triples of values with weights (unit weights if w is nullptr)
+  template <class T>
+  void fill(const T* x, const T* y, const T* z, Long64_t n, const Double_t* w = nullptr) {
+    Int_t bins[kBlockSize];
+    const Int_t strideY = mX.nBins() + 2;
+    const Int_t strideZ = strideY * (mY.nBins() + 2);
+    for (Long64_t first = 0; first < n; first += kBlockSize) {
+      const Int_t nBlock = (Int_t)std::min<Long64_t>(kBlockSize, n - first);
+      const T *xb = x + first;
+      const T *yb = y + first;
+      const T *zb = z + first;
+      for (Int_t i = 0; i < nBlock; ++i) {
+        bins[i] = mX.bin(xb[i]) + strideY * mY.bin(yb[i]) + strideZ * mZ.bin(zb[i]);
+      }
+      addBins(bins, nBlock, w ? w + first : nullptr);
+    }
+  }
+
+  /// Add histogram with the same binning
+  void add(const McHist3D& hist);
+  /// Create ROOT histogram with the contents
+  TH3D* toTH3(const Char_t* name, const Char_t* title) const;
+
+ private:
+  /// X axis
+  McHistAxis mX;
+  /// Y axis
+  McHistAxis mY;
+  /// Z axis
+  McHistAxis mZ;
+};
+
+/**
+ * \class McHistReplicas
+ * \brief Per-thread copies of a histogram (or of any copyable
+ * type with an add() method, e.g. a struct of histograms)
+ *
+ * Every thread fills replicas[slot]. merge() adds the replicas
+ * pairwise in log2(N) steps, the pairs of one step are added in
+ * parallel, and returns the first replica that holds the sum.
+ */
+//_________________
+template <class H>
+class McHistReplicas {
+
+ public:
+  /// Constructor that makes nSlots copies of the prototype
+  McHistReplicas(const H& prototype, UInt_t nSlots) :
+    mSlots( (nSlots > 0) ? nSlots : 1, prototype ) { /* empty */ }
+
+  /// Return replica of the slot
+  H& operator[](UInt_t slot)       { return mSlots[slot]; }
+  /// Return number of replicas
+  UInt_t size() const              { return mSlots.size(); }
+
+  /// Add all replicas to the first one and return it
+  H& merge() {
+    for (size_t step = 1; step < mSlots.size(); step *= 2) {
+      std::vector<std::thread> threads;
+      for (size_t i = 0; i + step < mSlots.size(); i += 2 * step) {
+        threads.emplace_back([this, i, step] { mSlots[i].add(mSlots[i + step]); });
+      }
+      for (size_t i = 0; i < threads.size(); ++i) {
+        threads[i].join();
+      }
+    }
+    return mSlots[0];
+  }
+
+ private:
+  /// Replicas
+  std::vector<H> mSlots;
+};
+
+#endif // McHist_h
@@ -0,0 +1,126 @@
+/**
+ * \class McHistogramBank
+ * \brief Set of histograms booked for every particle species
+ *
+ * The bank holds a list of species (PDG code and label) and a list
+ * of histogram templates. Histograms of a species are cloned from
+ * the templates only when the species is requested for the first
+ * time, so species that never appear in the data cost no memory.
+ * The name of a clone is the template name followed by "_<index>",
+ * where index is the position of the species in the bank, and the
+ * "%s" in the template title is replaced by the species label.
+ *
+ * The PDG code is converted to the species index with a dense
+ * table for |pdg| < kDenseRange and with a hash map for the rest
+ * (nuclei, excited states), so the lookup does not depend on the
+ * number of species.
+ *
+ * For multi-threaded processing each thread fills its own replica
+ * made with the copy constructor (species and templates are shared,
+ * histograms are not) and the replicas are added up with merge().
+ */
+
+#ifndef McHistogramBank_h
+#define McHistogramBank_h
+
+// C++ headers
+#include <vector>
+#include <unordered_map>
+
+// ROOT headers
+#include "TH1.h"
+#include "TString.h"
+
+// Forward declarations
+class TDirectory;
+
+//_________________
+class McHistogramBank {
+
+ public:
+  /// Default constructor
+  McHistogramBank();
+  /// Create an empty replica with the same species and templates
+  McHistogramBank(const McHistogramBank& bank);
+  /// Destructor
+  virtual ~McHistogramBank();
+
+  /// Codes with |pdg| below this value are looked up in the dense table
+  enum { kDenseRange = 10000 };
+
+  /// Add species and return its index. Species and templates
+  /// must be added before any histogram is booked or replicated
+  Int_t addSpecies(Int_t pdg, const Char_t* label);
+  /// Add histogram template and return its index. The bank takes
+  /// ownership of the template
+  Int_t addHistogram(TH1* hTemplate);
+
+  /// Return index of the species with the given PDG code or -1
+  Int_t index(Int_t pdg) const {
+    if (pdg > -kDenseRange && pdg < kDenseRange) {
+      return mDense[pdg + kDenseRange];
+    }
+    std::unordered_map<Int_t, Int_t>::const_iterator it = mSparse.find(pdg);
+    return (it != mSparse.end()) ? it->second : -1;
+  }
+  /// Return histograms of the species with the given index.
+  /// Histograms are booked at the first call
+  TH1** histograms(Int_t index) {
+    TH1 **h = &mHistograms[index * mTemplates.size()];
+    if (!h[0]) book(index);
+    return h;
+  }
+  /// Return histograms of the species with the given PDG code
+  /// or nullptr if the species is not in the bank
+  TH1** find(Int_t pdg) {
+    Int_t i = index(pdg);
+    return (i < 0) ? nullptr : histograms(i);
+  }
+
+  /// Return number of species
+  Int_t numberOfSpecies() const       { return mPdg.size(); }
+  /// Return number of histogram templates
+  Int_t numberOfHistograms() const    { return mTemplates.size(); }
+  /// Return PDG code of the species
+  Int_t pdg(Int_t index) const        { return mPdg[index]; }
+  /// Return label of the species
+  const Char_t* label(Int_t index) const { return mLabels[index].Data(); }
+  /// Return true if histograms of the species are booked
+  Bool_t isBooked(Int_t index) const
+  { return !mTemplates.empty() && mHistograms[index * mTemplates.size()] != nullptr; }
+  /// Return histogram template
+  TH1* histogramTemplate(Int_t iHist) const { return mTemplates[iHist]; }
+
+  /// Add histograms of another bank with the same species and templates
+  void merge(const McHistogramBank& bank);
+  /// Scale histogram iHist of all booked species
+  void scale(Int_t iHist, Double_t factor);
+  /// Write booked histograms to the directory (current one if nullptr).
+  /// Histograms are grouped by template
+  void write(TDirectory* dir = nullptr) const;
+
+ private:
+  McHistogramBank& operator=(const McHistogramBank&) = delete;
+
+  /// Clone templates for the species
+  void book(Int_t index);
+  /// Delete booked histograms
+  void clear();
+
+  /// Species index for |pdg| < kDenseRange
+  std::vector<Short_t> mDense;
+  /// Species index for other codes
+  std::unordered_map<Int_t, Int_t> mSparse;
+  /// PDG codes of the species
+  std::vector<Int_t> mPdg;
+  /// Labels of the species
+  std::vector<TString> mLabels;
+  /// Histogram templates
+  std::vector<TH1*> mTemplates;
+  /// True if templates are owned by this bank
+  Bool_t mOwnTemplates;
+  /// Booked histograms: species index * number of templates + template index
+  std::vector<TH1*> mHistograms;
+};
+
+#endif // McHistogramBank_h
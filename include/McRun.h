@@ -16,6 +16,9 @@
 #include "TNamed.h"
 #include "TString.h"
 
+// Forward declarations
+class TCollection;
+
 //_________________
 class McRun : public TNamed {
 
@@ -34,6 +37,12 @@ class McRun : public TNamed {
   void print() const;
   /// Print run info
   void Print(Option_t* option = "") const;
+  /// Merge run headers of other files (called by TFileMerger and hadd).
+  /// Numbers of events are summed up, cross section is averaged with
+  /// the number of events as weight. Returns total number of events
+  Long64_t Merge(TCollection* list);
+  /// Return true if the other header describes the same collision setup
+  Bool_t isCompatible(const McRun& other) const;
 
   /// Proton mass (GeV/c^2)
   static Double_t mProtMass;
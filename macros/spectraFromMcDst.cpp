@@ -10,16 +10,25 @@
  *
  * To run the code simply run next commands from the terminal:
  * ```
- * spectraFromMcDst inputFile outputFile.root
+ * spectraFromMcDst inputFile outputFile.root [nThreads] [incremental]
  * '''
  * For the input file one can use either fname.mcDst.root file or
  * a list of mcDst files with the .list or .lis extention.
+ * Events are processed in nThreads threads (default: number of
+ * hardware threads). Histograms of a particle species are booked
+ * only if the species is found in the data.
+ *
+ * With the "incremental" option only the files that have been added
+ * to the list since the previous run are processed, and the results
+ * are merged into the existing output (see McDstIncremental).
  */
 
 // C++ headers
 #include <iostream>
 #include <cmath>
 #include <vector>
+#include <cstdlib>
+#include <cstring>
 
 // ROOT headers
 #include "TROOT.h"
@@ -36,12 +45,34 @@
 
 // McDst headers
 #include "McDstReader.h"
+#include "McDstParallelReader.h"
+#include "McDstIncremental.h"
+#include "McHistogramBank.h"
 #include "McDst.h"
 #include "McEvent.h"
 #include "McParticle.h"
 #include "McRun.h"
 #include "McUtils.h"
 
+// Indices of the per-species histograms in the bank
+enum {
+    kAccCMS = 0, kEnergyImbalanceCMS, kMassImbalanceCMS, kPtSpectra, kEnergyCMS,
+    kFreezeOutXYCMS, kFreezeOutZXCMS, kFreezeOutZTCMS, kProperTimeVsSpaceTimeRapidityCMS,
+    kFreezeOutTimeCMS, kProperTimeCMS, kEtaCMS,
+    kAccLab, kEnergyImbalanceLab, kMassImbalanceLab, kEnergyLab,
+    kFreezeOutXYLab, kFreezeOutZXLab, kFreezeOutZTLab, kProperTimeVsSpaceTimeRapidityLab,
+    kFreezeOutTimeLab, kProperTimeLab, kEtaLab
+};
+
+// Histograms filled by one thread
+struct SlotHistograms {
+    TH1D *hImpactParameter;
+    TH1D *hRefMult;
+    TH2D *hImpactParVsRefMult;
+    TH1D *hAbundance;
+    McHistogramBank *bank;
+};
+
 //________________
 int main(int argc, char *argv[]) {
 
@@ -49,6 +80,8 @@ int main(int argc, char *argv[]) {
 
     const char *fileName;
     const char *oFileName;
+    unsigned int nThreads = 0;
+    bool incrementalMode = false;
 
     int ABeam = 124;
     int ZBeam = 54;
@@ -56,7 +89,6 @@ int main(int argc, char *argv[]) {
     int ZTarget = 74;
     double beamEkin = 3.0;
     double sNN = 3.02; // GeV
-    double y_beam = TMath::
 
     double betaCM = McUtils::beta_from_Ekin(beamEkin, ABeam, ATarget);
     double yCM = McUtils::yCM_from_Ekin(beamEkin);
@@ -66,19 +98,45 @@ int main(int argc, char *argv[]) {
     double rapidityCut = 0.1;
 
     switch (argc) {
+    case 5:
+        incrementalMode = (std::strcmp(argv[4], "incremental") == 0);
+        // fall through
+    case 4:
+        nThreads = std::atoi(argv[3]);
+        // fall through
     case 3:
         fileName = argv[1];
         oFileName = argv[2];
         break;
     default:
-        std::cout << "Usage: processMcDstStandalone inputFileName outputFileName.root" << std::endl;
+        std::cout << "Usage: spectraFromMcDst inputFileName outputFileName.root [nThreads] [incremental]" << std::endl;
         return -1;
     }
     std::cout << " inputFileName : " << fileName << std::endl;
     std::cout << " outputFileName: " << oFileName << std::endl;
 
-    McDstReader *myReader = new McDstReader(fileName);
-    myReader->Init();
+    // Histograms are owned by the code, not by the current directory
+    TH1::AddDirectory(kFALSE);
+
+    // Only new files are processed in the incremental mode. The analysis
+    // parameters are part of the state, a change triggers a full run
+    McDstIncremental *incremental = nullptr;
+    if (incrementalMode) {
+        incremental = new McDstIncremental(fileName, oFileName,
+                                           Form("spectraFromMcDst %d %d %d %d %g %g %g",
+                                                ABeam, ZBeam, ATarget, ZTarget,
+                                                beamEkin, sNN, rapidityCut));
+        incremental->addNormalized("hPtSpectra*");
+        incremental->addNormalized("hAbundance");
+        if (!incremental->prepare()) {
+            delete incremental;
+            return 0;
+        }
+        fileName = incremental->inputFileName();
+        oFileName = incremental->outputFileName();
+    }
+
+    McDstParallelReader *myReader = new McDstParallelReader(fileName, nThreads);
 
     // This is a way if you want to spead up IO
     std::cout << "Explicit read status for some branches" << std::endl;
@@ -89,14 +147,14 @@ int main(int argc, char *argv[]) {
 
     std::cout << "Now I know what to read, Master!" << std::endl;
 
-    if (!myReader->chain()) {
-        std::cout << "No chain has been found." << std::endl;
+    Long64_t events2read = myReader->entries();
+    if (events2read <= 0) {
+        std::cout << "No events have been found." << std::endl;
+        return -1;
     }
-    Long64_t eventsInTree = myReader->tree()->GetEntries();
-    std::cout << "eventsInTree: " << eventsInTree << std::endl;
-    Long64_t events2read = myReader->chain()->GetEntries();
 
-    std::cout << "Number of events to read: " << events2read << std::endl;
+    std::cout << "Number of events to read: " << events2read
+              << " in " << myReader->numberOfThreads() << " threads" << std::endl;
 
     /////////////////////
     //  Histogramming  //
@@ -107,22 +165,19 @@ int main(int argc, char *argv[]) {
     //
 
     TH1D *hImpactParameter = new TH1D("hImpactParameter", "Impact parameter;b (bm);Entries", 75, 0., 15.);
-    hImpactParameter->Sumw2();
     TH1D *hRefMult = new TH1D("hRefMult", "Reference multiplicity (|#eta|<1, p_{T}>0.3 GeV/c); Reference multiplicity;Entries",
                               300, -0.5, 599.5);
-    hRefMult->Sumw2();
     TH2D *hImpactParVsRefMult = new TH2D("hImpactParVsRefMult",
                                          "Impact parameter vs. refMult (|#eta|<1, p_{T}>0.3 GeV/c);Reference multiplicity;Impact parameter (fm)",
                                          500, -0.5, 499.5, 75, 0., 15.);
-    hImpactParVsRefMult->Sumw2();
 
     // PDG codes and names
     std::vector<int> pdgCodes = {
         211, -211, 111, 321, -321, 311, 310, 130,
-        3122, -3122, 
-        3212, 3112, 3222, 
-        3322, -3322, 3312, 
-        -3312, 3334, 
+        3122, -3122,
+        3212, 3112, 3222,
+        3322, -3322, 3312,
+        -3312, 3334,
         333, 2112, -2112,
         2212, -2212, 443, 411, -411, 421, -421,
         431, -431, 22, 11, -11
@@ -130,9 +185,9 @@ int main(int argc, char *argv[]) {
 
     std::vector<TString> particleNames = {
         "#pi^{+}", "#pi^{-}", "#pi^{0}", "K^{+}", "K^{-}", "K^{0}", "K^{0}_{S}", "K^{0}_{L}",
-        "#Lambda", "#bar{#Lambda}", 
-        "#Sigma^{0}", "#Sigma^{-}", "#Sigma^{+}", 
-        "#Xi^{0}", "#bar{#Xi}^{0}", "#Xi^{-}", "#bar{#Xi}^{+}", 
+        "#Lambda", "#bar{#Lambda}",
+        "#Sigma^{0}", "#Sigma^{-}", "#Sigma^{+}",
+        "#Xi^{0}", "#bar{#Xi}^{0}", "#Xi^{-}", "#bar{#Xi}^{+}",
         "#Omega^{-}", "#phi(1020)",
         "n", "#bar{n}", "p", "#bar{p}", "J/#psi",
         "D^{+}", "D^{-}", "D^{0}", "#bar{D}^{0}", "D_{s}^{+}", "D_{s}^{-}",
@@ -169,203 +224,115 @@ int main(int argc, char *argv[]) {
         4.0, 4.5, 5.0, 5.5, 6.0, 6.5, 7.0, 7.5, 8.0, 8.5, 9.0
     };
 
-    std::vector<TH2D*> hAcceptanceCMS;
-    std::vector<TH2D*> hEnergyImbalanceCMS;
-    std::vector<TH2D*> hMassImbalanceCMS;
-    std::vector<TH1D*> hPtSpectra;
-    std::vector<TH1D*> hEnergyCMS;
-    std::vector<TH2D*> hFreezeOutXYCMS;
-    std::vector<TH2D*> hFreezeOutZXCMS;
-    std::vector<TH2D*> hFreezeOutZTCMS;
-    std::vector<TH2D*> hProperTimeVsSpaceTimeRapidityCMS;
-    std::vector<TH1D*> hFreezeOutTimeCMS;
-    std::vector<TH1D*> hProperTimeCMS;
-    std::vector<TH1D*> hEtaCMS;
-
-    std::vector<TH2D*> hAcceptanceLab;
-    std::vector<TH2D*> hEnergyImbalanceLab;
-    std::vector<TH2D*> hMassImbalanceLab;
-    std::vector<TH1D*> hEnergyLab;
-    std::vector<TH2D*> hFreezeOutXYLab;
-    std::vector<TH2D*> hFreezeOutZXLab;
-    std::vector<TH2D*> hFreezeOutZTLab;
-    std::vector<TH2D*> hProperTimeVsSpaceTimeRapidityLab;
-    std::vector<TH1D*> hFreezeOutTimeLab;
-    std::vector<TH1D*> hProperTimeLab;
-    std::vector<TH1D*> hEtaLab;
-
     TH1D* hAbundance = new TH1D("hAbundance", "Particle Abundance;Particle;Entries", pdgCodes.size(), 0, pdgCodes.size());
-    // hAbundance->Sumw2();
+
+    // Species and histogram templates. Histograms of a species are cloned
+    // from the templates when the species is found for the first time.
+    // Only the spectra are weighted, so only they need Sumw2
+    McHistogramBank *bank = new McHistogramBank();
     for (size_t i = 0; i < pdgCodes.size(); ++i) {
         hAbundance->GetXaxis()->SetBinLabel(i + 1, particleNames[i]);
+        bank->addSpecies(pdgCodes[i], particleNames[i]);
+    }
 
-        // Center of mass frame histograms
-
-        TString hAccCMSName = Form("hAccCMS_%zu", i);
-        TString hAccCMSTitle = Form("Acceptance in the CMS frame: %s;#eta;p_{T} (GeV/c)", particleNames[i].Data());
-        hAcceptanceCMS.push_back(new TH2D(hAccCMSName, hAccCMSTitle, nEtaBins, etaMin, etaMax, nPtBins, ptMin, ptMax));
-        hAcceptanceCMS.back()->Sumw2();
-
-        TString hEnergyImbalanceCMSName = Form("hEnergyImbalanceCMS_%zu", i);
-        TString hEnergyImbalanceCMSTitle = Form("Energy imbalance in the CMS frame: %s;#eta;E_{model}-E_{calc}", particleNames[i].Data());
-        hEnergyImbalanceCMS.push_back(new TH2D(hEnergyImbalanceCMSName, hEnergyImbalanceCMSTitle, nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
-        hEnergyImbalanceCMS.back()->Sumw2();
-
-        TString hMassCMSName = Form("hMassImbalanceCMS_%zu", i);
-        TString hMassCMSTitle = Form("Mass imbalance in the CMS frame: %s;#eta;M_{model}-M_{PDG}", particleNames[i].Data());
-        hMassImbalanceCMS.push_back(new TH2D(hMassCMSName, hMassCMSTitle, nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
-        hMassImbalanceCMS.back()->Sumw2();
-
-        TString hSpecName = Form("hPtSpectra_%zu", i);
-        TString hSpecTitle = Form("p_{T} spectra: %s;p_{T} (GeV/c);#frac{1}{2#pi} #frac{d^{2}N}{p_{T} dy dp_{T}}", particleNames[i].Data());
-        hPtSpectra.push_back(new TH1D(hSpecName, hSpecTitle, nBinsPtSpectra, ptBinEdges));
-        hPtSpectra.back()->Sumw2();
-
-        TString hEnergyCMSName = Form("hEnergyCMS_%zu", i);
-        TString hEnergyCMSTitle = Form("Energy in the CMS frame: %s;E (GeV);Entries", particleNames[i].Data());
-        hEnergyCMS.push_back(new TH1D(hEnergyCMSName, hEnergyCMSTitle, nEnergyBins, energyMin, energyMax));
-        hEnergyCMS.back()->Sumw2();
-
-        TString hFreezeOutXYCMSName = Form("hFreezeOutXYCMS_%zu", i);
-        TString hFreezeOutXYCMSTitle = Form("Freeze-out in the CMS frame: %s;x (fm);y (fm)", particleNames[i].Data());
-        hFreezeOutXYCMS.push_back(new TH2D(hFreezeOutXYCMSName, hFreezeOutXYCMSTitle, nXBins, xmin, xmax, nYBins, ymin, ymax));
-        hFreezeOutXYCMS.back()->Sumw2();
-
-        TString hFreezeOutZXCMSName = Form("hFreezeOutZXCMS_%zu", i);
-        TString hFreezeOutZXCMSTitle = Form("Freeze-out in the CMS frame: %s;x (fm);z (fm)", particleNames[i].Data());
-        hFreezeOutZXCMS.push_back(new TH2D(hFreezeOutZXCMSName, hFreezeOutZXCMSTitle, nXBins, xmin, xmax, nZBins, zmin, zmax));
-        hFreezeOutZXCMS.back()->Sumw2();
-
-        TString hFreezeOutZTCMSName = Form("hFreezeOutZTCMS_%zu", i);
-        TString hFreezeOutZTCMSTitle = Form("Freeze-out in the CMS frame: %s;z (fm);t (fm/c)", particleNames[i].Data());
-        hFreezeOutZTCMS.push_back(new TH2D(hFreezeOutZTCMSName, hFreezeOutZTCMSTitle, nXBins, xmin, xmax, nTBins, tmin, tmax));
-        hFreezeOutZTCMS.back()->Sumw2();
-
-        TString hProperTimeVsSpaceTimeRapidityCMSName = Form("hProperTimeVsSpaceTimeRapidityCMS_%zu", i);
-        TString hProperTimeVsSpaceTimeRapidityCMSTitle = Form("Proper time vs. space-time rapidity in the CMS frame: %s;#eta_{s};#tau (fm/c)", particleNames[i].Data());
-        hProperTimeVsSpaceTimeRapidityCMS.push_back(new TH2D(hProperTimeVsSpaceTimeRapidityCMSName, hProperTimeVsSpaceTimeRapidityCMSTitle, nSpaceTimeRapidityBins, spaceTimeRapidityMin, spaceTimeRapidityMax, nTauBins, tauMin, tauMax));
-        hProperTimeVsSpaceTimeRapidityCMS.back()->Sumw2();
-
-        TString hFreezeOutTimeCMSName = Form("hFreezeOutTimeCMS_%zu", i);
-        TString hFreezeOutTimeCMSTitle = Form("Freeze-out time in the CMS frame: %s;t (fm/c);Entries", particleNames[i].Data());
-        hFreezeOutTimeCMS.push_back(new TH1D(hFreezeOutTimeCMSName, hFreezeOutTimeCMSTitle, nTBins, tmin, tmax));
-        hFreezeOutTimeCMS.back()->Sumw2();
-
-        TString hProperTimeCMSName = Form("hProperTimeCMS_%zu", i);
-        TString hProperTimeCMSTitle = Form("Proper time in the CMS frame: %s;#tau (fm/c);Entries", particleNames[i].Data());
-        hProperTimeCMS.push_back(new TH1D(hProperTimeCMSName, hProperTimeCMSTitle, nTBins, tauMin, tauMax));
-        hProperTimeCMS.back()->Sumw2();
-
-        TString hEtaCMSName = Form("hEtaCMS_%zu", i);
-        TString hEtaCMSTitle = Form("Pseudorapidity (#eta) in the CMS frame: %s;#eta;dN/d#eta", particleNames[i].Data());
-        hEtaCMS.push_back(new TH1D(hEtaCMSName, hEtaCMSTitle, nEtaBins, etaMin, etaMax));
-        hEtaCMS.back()->Sumw2();
-
-        // Laboratory frame histograms
-
-        TString hAccLabName = Form("hAccLab_%zu", i);
-        TString hAccLabTitle = Form("Acceptance in the Lab frame: %s;#eta;p_{T} (GeV/c)", particleNames[i].Data());
-        hAcceptanceLab.push_back(new TH2D(hAccLabName, hAccLabTitle, nEtaBins, etaMin, etaMax, nPtBins, ptMin, ptMax));
-        hAcceptanceLab.back()->Sumw2();
-
-        TString hEnergyImbalanceLabName = Form("hEnergyImbalanceLab_%zu", i);
-        TString hEnergyImbalanceLabTitle = Form("Energy imbalance in the Lab frame: %s;#eta;E_{model}-E_{calc}", particleNames[i].Data());
-        hEnergyImbalanceLab.push_back(new TH2D(hEnergyImbalanceLabName, hEnergyImbalanceLabTitle, nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
-        hEnergyImbalanceLab.back()->Sumw2();
-
-        TString hMassLabName = Form("hMassImbalanceLab_%zu", i);
-        TString hMassLabTitle = Form("Mass imbalance in the Lab frame: %s;#eta;M_{model}-M_{PDG}", particleNames[i].Data());
-        hMassImbalanceLab.push_back(new TH2D(hMassLabName, hMassLabTitle, nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
-        hMassImbalanceLab.back()->Sumw2();
-
-        TString hEnergyLabName = Form("hEnergyLab_%zu", i);
-        TString hEnergyLabTitle = Form("Energy in the Lab frame: %s;E (GeV);Entries", particleNames[i].Data());
-        hEnergyLab.push_back(new TH1D(hEnergyLabName, hEnergyLabTitle, nEnergyBins, energyMin, energyMax));
-        hEnergyLab.back()->Sumw2();
-
-        TString hFreezeOutXYLabName = Form("hFreezeOutXYLab_%zu", i);
-        TString hFreezeOutXYLabTitle = Form("Freeze-out in the Lab frame: %s;x (fm);y (fm)", particleNames[i].Data());
-        hFreezeOutXYLab.push_back(new TH2D(hFreezeOutXYLabName, hFreezeOutXYLabTitle, nXBins, xmin, xmax, nYBins, ymin, ymax));
-        hFreezeOutXYLab.back()->Sumw2();
-
-        TString hFreezeOutZXLabName = Form("hFreezeOutZXLab_%zu", i);
-        TString hFreezeOutZXLabTitle = Form("Freeze-out in the Lab frame: %s;x (fm);z (fm)", particleNames[i].Data());
-        hFreezeOutZXLab.push_back(new TH2D(hFreezeOutZXLabName, hFreezeOutZXLabTitle, nXBins, xmin, xmax, nZBins, zmin, zmax));
-        hFreezeOutZXLab.back()->Sumw2();
-
-        TString hFreezeOutZTLabName = Form("hFreezeOutZTLab_%zu", i);
-        TString hFreezeOutZTLabTitle = Form("Freeze-out in the Lab frame: %s;z (fm);t (fm/c)", particleNames[i].Data());
-        hFreezeOutZTLab.push_back(new TH2D(hFreezeOutZTLabName, hFreezeOutZTLabTitle, nXBins, xmin, xmax, nTBins, tmin, tmax));
-        hFreezeOutZTLab.back()->Sumw2();
-
-        TString hProperTimeVsSpaceTimeRapidityLabName = Form("hProperTimeVsSpaceTimeRapidityLab_%zu", i);
-        TString hProperTimeVsSpaceTimeRapidityLabTitle = Form("Proper time vs. space-time rapidity in the Lab frame: %s;#eta_{s};#tau (fm/c)", particleNames[i].Data());
-        hProperTimeVsSpaceTimeRapidityLab.push_back(new TH2D(hProperTimeVsSpaceTimeRapidityLabName, hProperTimeVsSpaceTimeRapidityLabTitle, nSpaceTimeRapidityBins, spaceTimeRapidityMin, spaceTimeRapidityMax, nTauBins, tauMin, tauMax));
-        hProperTimeVsSpaceTimeRapidityLab.back()->Sumw2();
-
-        TString hFreezeOutTimeLabName = Form("hFreezeOutTimeLab_%zu", i);
-        TString hFreezeOutTimeLabTitle = Form("Freeze-out time in the Lab frame: %s;t (fm/c);Entries", particleNames[i].Data());
-        hFreezeOutTimeLab.push_back(new TH1D(hFreezeOutTimeLabName, hFreezeOutTimeLabTitle, nTBins, tmin, tmax));
-        hFreezeOutTimeLab.back()->Sumw2();
-
-        TString hProperTimeLabName = Form("hProperTimeLab_%zu", i);
-        TString hProperTimeLabTitle = Form("Proper time in the Lab frame: %s;#tau (fm/c);Entries", particleNames[i].Data());
-        hProperTimeLab.push_back(new TH1D(hProperTimeLabName, hProperTimeLabTitle, nTBins, tauMin, tauMax));
-        hProperTimeLab.back()->Sumw2();
-
-        TString hEtaLabName = Form("hEtaLab_%zu", i);
-        TString hEtaLabTitle = Form("Pseudorapidity (#eta) in the Lab frame: %s;#eta;dN/d#eta", particleNames[i].Data());
-        hEtaLab.push_back(new TH1D(hEtaLabName, hEtaLabTitle, nEtaBins, etaMin, etaMax));
-        hEtaLab.back()->Sumw2();
-    } // for (size_t i = 0; i < pdgCodes.size(); ++i)
+    // Center of mass frame histograms
+    bank->addHistogram(new TH2D("hAccCMS", "Acceptance in the CMS frame: %s;#eta;p_{T} (GeV/c)",
+                                nEtaBins, etaMin, etaMax, nPtBins, ptMin, ptMax));
+    bank->addHistogram(new TH2D("hEnergyImbalanceCMS", "Energy imbalance in the CMS frame: %s;#eta;E_{model}-E_{calc}",
+                                nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
+    bank->addHistogram(new TH2D("hMassImbalanceCMS", "Mass imbalance in the CMS frame: %s;#eta;M_{model}-M_{PDG}",
+                                nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
+    TH1D *hPtSpectraTemplate = new TH1D("hPtSpectra", "p_{T} spectra: %s;p_{T} (GeV/c);#frac{1}{2#pi} #frac{d^{2}N}{p_{T} dy dp_{T}}",
+                                        nBinsPtSpectra, ptBinEdges);
+    hPtSpectraTemplate->Sumw2();
+    bank->addHistogram(hPtSpectraTemplate);
+    bank->addHistogram(new TH1D("hEnergyCMS", "Energy in the CMS frame: %s;E (GeV);Entries",
+                                nEnergyBins, energyMin, energyMax));
+    bank->addHistogram(new TH2D("hFreezeOutXYCMS", "Freeze-out in the CMS frame: %s;x (fm);y (fm)",
+                                nXBins, xmin, xmax, nYBins, ymin, ymax));
+    bank->addHistogram(new TH2D("hFreezeOutZXCMS", "Freeze-out in the CMS frame: %s;x (fm);z (fm)",
+                                nXBins, xmin, xmax, nZBins, zmin, zmax));
+    bank->addHistogram(new TH2D("hFreezeOutZTCMS", "Freeze-out in the CMS frame: %s;z (fm);t (fm/c)",
+                                nXBins, xmin, xmax, nTBins, tmin, tmax));
+    bank->addHistogram(new TH2D("hProperTimeVsSpaceTimeRapidityCMS", "Proper time vs. space-time rapidity in the CMS frame: %s;#eta_{s};#tau (fm/c)",
+                                nSpaceTimeRapidityBins, spaceTimeRapidityMin, spaceTimeRapidityMax, nTauBins, tauMin, tauMax));
+    bank->addHistogram(new TH1D("hFreezeOutTimeCMS", "Freeze-out time in the CMS frame: %s;t (fm/c);Entries",
+                                nTBins, tmin, tmax));
+    bank->addHistogram(new TH1D("hProperTimeCMS", "Proper time in the CMS frame: %s;#tau (fm/c);Entries",
+                                nTBins, tauMin, tauMax));
+    bank->addHistogram(new TH1D("hEtaCMS", "Pseudorapidity (#eta) in the CMS frame: %s;#eta;dN/d#eta",
+                                nEtaBins, etaMin, etaMax));
+
+    // Laboratory frame histograms
+    bank->addHistogram(new TH2D("hAccLab", "Acceptance in the Lab frame: %s;#eta;p_{T} (GeV/c)",
+                                nEtaBins, etaMin, etaMax, nPtBins, ptMin, ptMax));
+    bank->addHistogram(new TH2D("hEnergyImbalanceLab", "Energy imbalance in the Lab frame: %s;#eta;E_{model}-E_{calc}",
+                                nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
+    bank->addHistogram(new TH2D("hMassImbalanceLab", "Mass imbalance in the Lab frame: %s;#eta;M_{model}-M_{PDG}",
+                                nEtaBins, etaMin, etaMax, nEnergyImbalanceBins, energyImbalanceMin, energyImbalanceMax));
+    bank->addHistogram(new TH1D("hEnergyLab", "Energy in the Lab frame: %s;E (GeV);Entries",
+                                nEnergyBins, energyMin, energyMax));
+    bank->addHistogram(new TH2D("hFreezeOutXYLab", "Freeze-out in the Lab frame: %s;x (fm);y (fm)",
+                                nXBins, xmin, xmax, nYBins, ymin, ymax));
+    bank->addHistogram(new TH2D("hFreezeOutZXLab", "Freeze-out in the Lab frame: %s;x (fm);z (fm)",
+                                nXBins, xmin, xmax, nZBins, zmin, zmax));
+    bank->addHistogram(new TH2D("hFreezeOutZTLab", "Freeze-out in the Lab frame: %s;z (fm);t (fm/c)",
+                                nXBins, xmin, xmax, nTBins, tmin, tmax));
+    bank->addHistogram(new TH2D("hProperTimeVsSpaceTimeRapidityLab", "Proper time vs. space-time rapidity in the Lab frame: %s;#eta_{s};#tau (fm/c)",
+                                nSpaceTimeRapidityBins, spaceTimeRapidityMin, spaceTimeRapidityMax, nTauBins, tauMin, tauMax));
+    bank->addHistogram(new TH1D("hFreezeOutTimeLab", "Freeze-out time in the Lab frame: %s;t (fm/c);Entries",
+                                nTBins, tmin, tmax));
+    bank->addHistogram(new TH1D("hProperTimeLab", "Proper time in the Lab frame: %s;#tau (fm/c);Entries",
+                                nTBins, tauMin, tauMax));
+    bank->addHistogram(new TH1D("hEtaLab", "Pseudorapidity (#eta) in the Lab frame: %s;#eta;dN/d#eta",
+                                nEtaBins, etaMin, etaMax));
+
+    // Every thread fills its own copy of the histograms. The first
+    // thread uses the original ones
+    std::vector<SlotHistograms> slots(myReader->numberOfThreads());
+    for (size_t iSlot = 0; iSlot < slots.size(); ++iSlot) {
+        SlotHistograms &s = slots[iSlot];
+        if (iSlot == 0) {
+            s.hImpactParameter = hImpactParameter;
+            s.hRefMult = hRefMult;
+            s.hImpactParVsRefMult = hImpactParVsRefMult;
+            s.hAbundance = hAbundance;
+        }
+        else {
+            s.hImpactParameter = (TH1D*)hImpactParameter->Clone(Form("%s_slot%zu", hImpactParameter->GetName(), iSlot));
+            s.hRefMult = (TH1D*)hRefMult->Clone(Form("%s_slot%zu", hRefMult->GetName(), iSlot));
+            s.hImpactParVsRefMult = (TH2D*)hImpactParVsRefMult->Clone(Form("%s_slot%zu", hImpactParVsRefMult->GetName(), iSlot));
+            s.hAbundance = (TH1D*)hAbundance->Clone(Form("%s_slot%zu", hAbundance->GetName(), iSlot));
+        }
+        s.bank = new McHistogramBank(*bank);
+    }
 
 
     /////////////////////
     //     Analysis    //
     /////////////////////
 
-    Int_t eventCounter = 0;
-    Int_t clock = 10000;
-    Int_t clockIter = 0;
-
-    // Loop over events
-    for (Long64_t iEvent = 0; iEvent < events2read; iEvent++) {
+    Long64_t eventsRead = myReader->process([&](UInt_t iSlot, McDstReader *reader) {
 
-        eventCounter++;
-        if (eventCounter >= clock) {
-            eventCounter = 0;
-            clockIter++;
-            std::cout << "Working on event #[" << (clockIter * clock)
-                      << "/" << events2read << "]" << std::endl;
-        }
-
-        Bool_t readEvent = myReader->loadEntry(iEvent);
-        if (!readEvent) {
-            std::cout << "Something went wrong, Master! Nothing to analyze..."
-                      << std::endl;
-            break;
-        }
-
-        // Retrieve femtoDst
-        McDst *dst = myReader->mcDst();
+        SlotHistograms &s = slots[iSlot];
 
         // Retrieve event information
-        McEvent *event = dst->event();
+        McEvent *event = reader->event();
         if (!event) {
             std::cout << "Something went wrong, Master! Event is hiding from me..."
                       << std::endl;
-            break;
+            return;
         }
 
         Double_t b = event->b();
-        hImpactParameter->Fill(b);
+        s.hImpactParameter->Fill(b);
 
         //
         // Particle analysis
         //
 
         // Retrieve number of particles in the event
-        Int_t nParticles = dst->numberOfParticles();
+        Int_t nParticles = reader->numberOfParticles();
         // Number of charged particles with |eta|<0.5 and pT>0.15 GeV/c
         Int_t refMult{0};
 
@@ -373,32 +340,28 @@ int main(int argc, char *argv[]) {
         for (Int_t iTrk = 0; iTrk < nParticles; iTrk++) {
 
             // Retrieve i-th femto track
-            McParticle *particle = (McParticle *)dst->particle(iTrk);
+            McParticle *particle = reader->particle(iTrk);
 
             if (!particle)
                 continue;
 
-            // std::cout << "Track #[" << (iTrk+1) << "/" << nParticles << "]"
-            // 		<< std::endl;
-
-            /*
-            std::cout << "pdgId: " << particle->pdg()
-                          << " status: " << particle->status()
-                        << " px/py/pz/E/m/pt/y: "
-                        << particle->px() << " / "
-                        << particle->py() << " / "
-                        << particle->pz() << " / "
-                        << particle->e() << " / "
-                        << particle->mass() << " / "
-                      << particle->pt() << " / "
-                      << particle->momentum().Rapidity() << " / "
-                      << std::endl;
-                  */
-
             int pdgCode = particle->pdg();
             double pt = particle->pt();
             double eta = particle->eta();
             int charge = particle->charge();
+
+            // Calculate reference multiplicity
+            if (charge != 0 && pt > 0.3 && TMath::Abs(eta) < 1.0) {
+                refMult++;
+            } // if ( charge != 0 && pt>0.15 && TMath::Abs(eta) < 0.5 )
+
+            // Fill distributions for the selected species
+            int i = s.bank->index(pdgCode);
+            if (i < 0)
+                continue;
+
+            TH1 **h = s.bank->histograms(i);
+
             double rapidity = particle->momentum().Rapidity();
             double rapidityIntervalWidth = 2 * rapidityCut;
             double x = particle->x();
@@ -408,121 +371,110 @@ int main(int argc, char *argv[]) {
             double tau = particle->tau();
             double spaceTimeRapidity = particle->etaS();
 
-
-            // Calculate reference multiplicity
-            if (charge != 0 && pt > 0.3 && TMath::Abs(eta) < 1.0) {
-                refMult++;
-            } // if ( charge != 0 && pt>0.15 && TMath::Abs(eta) < 0.5 )
-
-            // Fill distributions for all particles
-            auto it = std::find(pdgCodes.begin(), pdgCodes.end(), pdgCode);
-            if (it != pdgCodes.end()) {
-                size_t i = std::distance(pdgCodes.begin(), it);
-
-                // Fill abundance histogram
-                hAbundance->Fill(i);
-
-                // Center-of-mass frame histograms
-            
-                // Fill acceptance histogram
-                hAcceptanceCMS[i]->Fill(eta, pt);
-                double pdgEnergy = particle->ptot() * particle->ptot() + particle->pdgMass() * particle->pdgMass();
-                pdgEnergy = TMath::Sqrt(pdgEnergy);
-                hEnergyImbalanceCMS[i]->Fill(eta, particle->e() - pdgEnergy);
-                hMassImbalanceCMS[i]->Fill(eta, particle->mass() - particle->pdgMass());
-                hEnergyCMS[i]->Fill(particle->e());
-                hFreezeOutXYCMS[i]->Fill(x, y);
-                hFreezeOutZXCMS[i]->Fill(z, x);
-                hFreezeOutZTCMS[i]->Fill(z, t);
-                hProperTimeVsSpaceTimeRapidityCMS[i]->Fill(spaceTimeRapidity, tau);
-                hFreezeOutTimeCMS[i]->Fill(t);
-                hProperTimeCMS[i]->Fill(tau);
-                hEtaCMS[i]->Fill(eta);
-
-                // Fill spectrum if |rapidity| < 0.1
-                if (std::abs(rapidity) < rapidityCut) {
-                    int bin = hPtSpectra[i]->FindBin(pt);
-                    double binWidth = hPtSpectra[i]->GetBinWidth(bin);
-                    double weight = 1.0 / (2. * TMath::Pi() * pt * rapidityIntervalWidth * binWidth);
-            
-                    hPtSpectra[i]->Fill(pt, weight);
-                }
-
-                // Laboratory frame histograms
-                TLorentzVector pCMS = particle->momentum();
-                TLorentzVector pLab = McUtils::boostToLabFrame(pCMS, -betaCM); // sign shifts to positive rapidity
-                TLorentzVector rCMS = particle->position();
-                TLorentzVector rLab = McUtils::boostToLabFrame(rCMS, -betaCM); // sign shifts to positive rapidity
-                particle->setMomentum(pLab);
-                particle->setPosition(rLab);
-
-
-                eta = particle->eta();
-                z = particle->z();
-                t = particle->t();
-                tau = particle->tau();
-                spaceTimeRapidity = particle->etaS();
-                pdgEnergy = TMath::Sqrt(particle->ptot() * particle->ptot() + particle->pdgMass() * particle->pdgMass());
-            
-                hAcceptanceLab[i]->Fill(eta, pt);
-                hEnergyImbalanceLab[i]->Fill(eta, particle->e() - pdgEnergy);
-                hMassImbalanceLab[i]->Fill(eta, particle->mass() - particle->pdgMass());
-                hEnergyLab[i]->Fill(particle->e());
-                hFreezeOutXYLab[i]->Fill(x, y);
-                hFreezeOutZXLab[i]->Fill(z, x);
-                hFreezeOutZTLab[i]->Fill(z, t);
-                hProperTimeVsSpaceTimeRapidityLab[i]->Fill(spaceTimeRapidity, tau);
-                hFreezeOutTimeLab[i]->Fill(t);
-                hProperTimeLab[i]->Fill(tau);
-                hEtaLab[i]->Fill(eta);
-
-            } // if (it != pdgCodes.end())
-
+            // Fill abundance histogram
+            s.hAbundance->Fill(i);
+
+            // Center-of-mass frame histograms
+
+            // Fill acceptance histogram
+            h[kAccCMS]->Fill(eta, pt);
+            double pdgEnergy = particle->ptot() * particle->ptot() + particle->pdgMass() * particle->pdgMass();
+            pdgEnergy = TMath::Sqrt(pdgEnergy);
+            h[kEnergyImbalanceCMS]->Fill(eta, particle->e() - pdgEnergy);
+            h[kMassImbalanceCMS]->Fill(eta, particle->mass() - particle->pdgMass());
+            h[kEnergyCMS]->Fill(particle->e());
+            h[kFreezeOutXYCMS]->Fill(x, y);
+            h[kFreezeOutZXCMS]->Fill(z, x);
+            h[kFreezeOutZTCMS]->Fill(z, t);
+            h[kProperTimeVsSpaceTimeRapidityCMS]->Fill(spaceTimeRapidity, tau);
+            h[kFreezeOutTimeCMS]->Fill(t);
+            h[kProperTimeCMS]->Fill(tau);
+            h[kEtaCMS]->Fill(eta);
+
+            // Fill spectrum if |rapidity| < 0.1
+            if (std::abs(rapidity) < rapidityCut) {
+                int bin = h[kPtSpectra]->FindBin(pt);
+                double binWidth = h[kPtSpectra]->GetBinWidth(bin);
+                double weight = 1.0 / (2. * TMath::Pi() * pt * rapidityIntervalWidth * binWidth);
+
+                h[kPtSpectra]->Fill(pt, weight);
+            }
+
+            // Laboratory frame histograms
+            TLorentzVector pCMS = particle->momentum();
+            TLorentzVector pLab = McUtils::boostToLabFrame(pCMS, -betaCM); // sign shifts to positive rapidity
+            TLorentzVector rCMS = particle->position();
+            TLorentzVector rLab = McUtils::boostToLabFrame(rCMS, -betaCM); // sign shifts to positive rapidity
+            particle->setMomentum(pLab);
+            particle->setPosition(rLab);
+
+            eta = particle->eta();
+            z = particle->z();
+            t = particle->t();
+            tau = particle->tau();
+            spaceTimeRapidity = particle->etaS();
+            pdgEnergy = TMath::Sqrt(particle->ptot() * particle->ptot() + particle->pdgMass() * particle->pdgMass());
+
+            h[kAccLab]->Fill(eta, pt);
+            h[kEnergyImbalanceLab]->Fill(eta, particle->e() - pdgEnergy);
+            h[kMassImbalanceLab]->Fill(eta, particle->mass() - particle->pdgMass());
+            h[kEnergyLab]->Fill(particle->e());
+            h[kFreezeOutXYLab]->Fill(x, y);
+            h[kFreezeOutZXLab]->Fill(z, x);
+            h[kFreezeOutZTLab]->Fill(z, t);
+            h[kProperTimeVsSpaceTimeRapidityLab]->Fill(spaceTimeRapidity, tau);
+            h[kFreezeOutTimeLab]->Fill(t);
+            h[kProperTimeLab]->Fill(tau);
+            h[kEtaLab]->Fill(eta);
 
         } // for(Int_t iTrk=0; iTrk<nParticles; iTrk++)
 
-        hRefMult->Fill(refMult);
-        hImpactParVsRefMult->Fill(refMult, b);
-
-    } // for(Long64_t iEvent=0; iEvent<events2read; iEvent++)
+        s.hRefMult->Fill(refMult);
+        s.hImpactParVsRefMult->Fill(refMult, b);
+    });
+
+    std::cout << "Events processed: " << eventsRead << std::endl;
+
+    // Merge thread copies to the first one
+    for (size_t iSlot = 1; iSlot < slots.size(); ++iSlot) {
+        hImpactParameter->Add(slots[iSlot].hImpactParameter);
+        hRefMult->Add(slots[iSlot].hRefMult);
+        hImpactParVsRefMult->Add(slots[iSlot].hImpactParVsRefMult);
+        hAbundance->Add(slots[iSlot].hAbundance);
+        slots[0].bank->merge(*slots[iSlot].bank);
+        delete slots[iSlot].hImpactParameter;
+        delete slots[iSlot].hRefMult;
+        delete slots[iSlot].hImpactParVsRefMult;
+        delete slots[iSlot].hAbundance;
+        delete slots[iSlot].bank;
+    }
+    McHistogramBank *result = slots[0].bank;
 
+    for (int i = 0; i < result->numberOfSpecies(); ++i) {
+        if (!result->isBooked(i)) {
+            std::cout << "Species " << result->pdg(i) << " has not been found" << std::endl;
+        }
+    }
 
     // Write histograms to the output file
     TFile *oFile = new TFile(oFileName, "recreate");
     hImpactParameter->Write();
     hRefMult->Write();
     hImpactParVsRefMult->Write();
-    // Center-of-mass frame histograms
-    for (auto* h : hAcceptanceCMS) h->Write();
-    for (auto* h : hEnergyImbalanceCMS) h->Write();
-    for (auto* h : hMassImbalanceCMS) h->Write();
-    for (auto* h : hPtSpectra) { h->Scale(1./events2read); h->Write(); }
-    for (auto* h : hEnergyCMS) { h->Write(); }
-    for (auto* h : hFreezeOutXYCMS) h->Write();
-    for (auto* h : hFreezeOutZXCMS) h->Write();
-    for (auto* h : hFreezeOutZTCMS) h->Write();
-    for (auto* h : hProperTimeVsSpaceTimeRapidityCMS) h->Write();
-    for (auto* h : hFreezeOutTimeCMS) h->Write();
-    for (auto* h : hProperTimeCMS) h->Write();
-    for (auto* h : hEtaCMS) h->Write();
-
-    // Laboratory frame histograms
-    for (auto* h : hAcceptanceLab) h->Write();
-    for (auto* h : hEnergyImbalanceLab) h->Write();
-    for (auto* h : hMassImbalanceLab) h->Write();
-    for (auto* h : hEnergyLab) { h->Write(); }
-    for (auto* h : hFreezeOutXYLab) h->Write();
-    for (auto* h : hFreezeOutZXLab) h->Write();
-    for (auto* h : hFreezeOutZTLab) h->Write();
-    for (auto* h : hProperTimeVsSpaceTimeRapidityLab) h->Write();
-    for (auto* h : hFreezeOutTimeLab) h->Write();
-    for (auto* h : hProperTimeLab) h->Write();
-    for (auto* h : hEtaLab) h->Write();
+    result->scale(kPtSpectra, 1. / events2read);
+    result->write(oFile);
 
     hAbundance->Scale(1./events2read); hAbundance->Write();
     oFile->Close();
 
-    myReader->Finish();
+    if (incremental) {
+        incremental->finish(events2read);
+        delete incremental;
+    }
+
+    delete result;
+    delete bank;
+    delete myReader;
 
     std::cout << "Acceptance and spectra processing is finished" << std::endl;
 
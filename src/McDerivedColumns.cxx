@@ -0,0 +1,128 @@
+//
+// Per-event cache of the quantities derived from particle momenta
+//
+
+// C++ headers
+#include <cmath>
+
+// ROOT headers
+#include "TClonesArray.h"
+#include "TDatabasePDG.h"
+#include "TParticlePDG.h"
+
+// McDst headers
+#include "McDerivedColumns.h"
+#include "McParticle.h"
+
+//_________________
+McDerivedColumns::McDerivedColumns() :
+  mParticles(nullptr), mValid(0), mMomentaLoaded(kFALSE),
+  mPx(), mPy(), mPz(), mE(), mPdg(), mColumns(), mPdgProperties() {
+  // Default constructor
+}
+
+//_________________
+McDerivedColumns::~McDerivedColumns() {
+  // Destructor
+}
+
+//_________________
+Int_t McDerivedColumns::size() {
+  // Number of particles in the event
+  return mParticles ? mParticles->GetEntriesFast() : 0;
+}
+
+//_________________
+void McDerivedColumns::loadMomenta() {
+  // Gather momenta into flat arrays
+  const Int_t n = size();
+  mPx.resize(n);
+  mPy.resize(n);
+  mPz.resize(n);
+  mE.resize(n);
+  mPdg.resize(n);
+  for (Int_t i = 0; i < n; ++i) {
+    const McParticle *p = (const McParticle*)mParticles->UncheckedAt(i);
+    mPx[i] = p->px();
+    mPy[i] = p->py();
+    mPz[i] = p->pz();
+    mE[i] = p->e();
+    mPdg[i] = p->pdg();
+  }
+  mMomentaLoaded = kTRUE;
+}
+
+//_________________
+const std::pair<Double_t, Double_t>& McDerivedColumns::pdgProperties(Int_t pdg) {
+  // Charge and mass of the PDG code
+  std::unordered_map<Int_t, std::pair<Double_t, Double_t> >::iterator it =
+    mPdgProperties.find(pdg);
+  if (it == mPdgProperties.end()) {
+    TParticlePDG *particle = TDatabasePDG::Instance()->GetParticle(pdg);
+    std::pair<Double_t, Double_t> value = particle ?
+      std::make_pair(particle->Charge(), particle->Mass()) : std::make_pair(0., -999.);
+    it = mPdgProperties.insert(std::make_pair(pdg, value)).first;
+  }
+  return it->second;
+}
+
+//_________________
+void McDerivedColumns::compute(Int_t type) {
+  // Compute column for all particles of the event
+  if (!mMomentaLoaded) loadMomenta();
+  const Int_t n = mPx.size();
+  std::vector<Double_t> &values = mColumns[type];
+  values.resize(n);
+  Double_t *c = values.data();
+  const Double_t *px = mPx.data();
+  const Double_t *py = mPy.data();
+  const Double_t *pz = mPz.data();
+  const Double_t *e = mE.data();
+
+  switch (type) {
+  case kPt:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = std::sqrt(px[i] * px[i] + py[i] * py[i]);
+    }
+    break;
+  case kPtot:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = std::sqrt(px[i] * px[i] + py[i] * py[i] + pz[i] * pz[i]);
+    }
+    break;
+  case kEta: {
+    // Same as TVector3::PseudoRapidity, +-10e10 along the beam
+    const Double_t *ptot = column(kPtot);
+    for (Int_t i = 0; i < n; ++i) {
+      const Double_t cosTheta = (ptot[i] == 0.) ? 1. : pz[i] / ptot[i];
+      const Double_t eta = -0.5 * std::log((1. - cosTheta) / (1. + cosTheta));
+      const Double_t beam = (pz[i] == 0.) ? 0. : ( (pz[i] > 0.) ? 10e10 : -10e10 );
+      c[i] = (cosTheta * cosTheta < 1.) ? eta : beam;
+    }
+    break;
+  }
+  case kRapidity:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = 0.5 * std::log((e[i] + pz[i]) / (e[i] - pz[i]));
+    }
+    break;
+  case kPhi:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = std::atan2(py[i], px[i]);
+    }
+    break;
+  case kCharge:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = pdgProperties(mPdg[i]).first;
+    }
+    break;
+  case kPdgMass:
+    for (Int_t i = 0; i < n; ++i) {
+      c[i] = pdgProperties(mPdg[i]).second;
+    }
+    break;
+  default:
+    break;
+  }
+  mValid |= (1u << type);
+}
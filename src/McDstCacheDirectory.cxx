@@ -0,0 +1,109 @@
+//
+// Least recently used eviction of the files of a cache directory
+//
+
+// C++ headers
+#include <iostream>
+#include <vector>
+#include <algorithm>
+#include <cerrno>
+
+// POSIX headers
+#include <dirent.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// ROOT headers
+#include "TString.h"
+
+// McDst headers
+#include "McDstCacheDirectory.h"
+
+//_________________
+static Bool_t isUnusedLock(const TString& name, const TString& suffix) {
+  // Lock file <file>.lock of a file that does not exist and is not locked.
+  // A job that locks it right after the check may fill the file twice,
+  // which is harmless since files are renamed into place
+  if (!name.EndsWith(suffix + ".lock")) return kFALSE;
+  const TString file = name(0, name.Length() - 5);
+  if (access(file.Data(), F_OK) == 0) return kFALSE;
+  Int_t fd = open(name.Data(), O_RDONLY);
+  if (fd < 0) return kFALSE;
+  const Bool_t unused = (flock(fd, LOCK_EX | LOCK_NB) == 0);
+  close(fd);
+  return unused;
+}
+
+//_________________
+static Bool_t isStaleTemporary(const TString& name, const TString& suffix) {
+  // Temporary file <file>.<pid>.tmp of a process that does not run anymore
+  if (!name.EndsWith(".tmp")) return kFALSE;
+  const TString base = name(0, name.Length() - 4);
+  const Ssiz_t dot = base.Last('.');
+  if (dot < 0 || !TString(base(0, dot)).EndsWith(suffix)) return kFALSE;
+  const TString pid = base(dot + 1, base.Length() - dot - 1);
+  if (!pid.IsDigit()) return kFALSE;
+  // Directories are local to the node, so the writer would be seen here
+  return kill((pid_t)pid.Atoi(), 0) != 0 && errno == ESRCH;
+}
+
+//_________________
+Long64_t McDstCacheDirectory::evict(const Char_t* directory, const Char_t* suffix,
+                                    Long64_t maxBytes) {
+  // Remove least recently used files
+  struct CacheFile {
+    TString name;
+    Long64_t size;
+    time_t mtime;
+  };
+  std::vector<CacheFile> files;
+  std::vector<TString> auxiliary;
+  Long64_t total = 0;
+  DIR *dir = opendir(directory);
+  if (!dir) return 0;
+  while (struct dirent *entry = readdir(dir)) {
+    TString name(entry->d_name);
+    if (!name.BeginsWith("mcdst_")) continue;
+    if (!name.EndsWith(suffix)) {
+      auxiliary.push_back( Form("%s/%s", directory, entry->d_name) );
+      continue;
+    }
+    CacheFile file;
+    file.name = Form("%s/%s", directory, entry->d_name);
+    struct stat st;
+    if (stat(file.name.Data(), &st) != 0) continue;
+    file.size = st.st_size;
+    file.mtime = st.st_mtime;
+    files.push_back(file);
+    total += file.size;
+  }
+  closedir(dir);
+
+  std::sort(files.begin(), files.end(),
+            [](const CacheFile& a, const CacheFile& b) { return a.mtime < b.mtime; });
+  for (size_t i = 0; i < files.size() && total > maxBytes; ++i) {
+    Int_t fd = open(files[i].name.Data(), O_RDONLY);
+    if (fd < 0) continue;
+    // Files in use are kept. In a sticky directory (e.g. /dev/shm)
+    // files of other users cannot be removed
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+      if (unlink(files[i].name.Data()) == 0) {
+        std::cout << "McDstCacheDirectory: " << files[i].name << " removed" << std::endl;
+        total -= files[i].size;
+      }
+    }
+    close(fd);
+  }
+
+  // Lock files of the removed files and leftovers of crashed writers
+  for (size_t i = 0; i < auxiliary.size(); ++i) {
+    if (!isUnusedLock(auxiliary[i], suffix) && !isStaleTemporary(auxiliary[i], suffix)) continue;
+    if (unlink(auxiliary[i].Data()) == 0) {
+      std::cout << "McDstCacheDirectory: " << auxiliary[i] << " removed" << std::endl;
+    }
+  }
+  return total;
+}
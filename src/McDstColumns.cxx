@@ -0,0 +1,651 @@
+//
+// Columnar (structure of arrays) storage of mcDst events
+//
+
+// C++ headers
+#include <iostream>
+#include <cstring>
+
+// ROOT headers
+#include "TClonesArray.h"
+
+// McDst headers
+#include "McDstColumns.h"
+#include "McEvent.h"
+#include "McParticle.h"
+
+//_________________
+McDstColumns::McDstColumns() :
+  mEventNr(), mB(), mPhi(), mNes(), mStepNr(), mStepT(), mComment(),
+  mNpart(), mNcoll(), mChainEntry(), mParticleOffset(1, 0),
+  mIndex(), mPdg(), mStatus(), mParent(), mParentDecay(), mMate(),
+  mDecay(), mFirstChild(), mLastChild(), mPx(), mPy(), mPz(), mE(),
+  mX(), mY(), mZ(), mT(), mParticleMask( (1u << kNParticleColumns) - 1 ),
+  mCommentBytes(0), mNEvents(0), mBlock{}, mAttached(kFALSE), mAttachedBytes(0) {
+  // Default constructor
+  updateBlocks();
+}
+
+//_________________
+McDstColumns::~McDstColumns() {
+  // Destructor
+}
+
+//_________________
+static inline const McParticle* particleAt(TObject** objects, Int_t i) {
+  // Particle from the object array of TClonesArray
+  return static_cast<const McParticle*>(objects[i]);
+}
+
+//_________________
+template <class T>
+static void appendRange(std::vector<T>& to, const T* from,
+                        Long64_t first, Long64_t last) {
+  // Copy values [first, last), zeros if the source column is not stored
+  if (!from) to.resize(to.size() + (last - first));
+  else to.insert(to.end(), from + first, from + last);
+}
+
+//_________________
+template <class T>
+static inline const T* stored(const McDstColumns& columns, Int_t column, const T* values) {
+  // Values of the column, nullptr if it is not stored
+  return columns.hasColumn(column) ? values : nullptr;
+}
+
+//_________________
+template <class T>
+static Long64_t columnBytes(const std::vector<T>& column) {
+  // Size of the column data
+  return column.size() * sizeof(T);
+}
+
+//_________________
+void McDstColumns::setParticleFields(const std::vector<TString>& fields) {
+  // Select particle columns by the McParticle data member names
+  if (numberOfEvents() > 0 || mAttached) {
+    std::cout << "[WARNING] McDstColumns::setParticleFields: storage is not empty"
+              << std::endl;
+    return;
+  }
+  if (fields.empty()) {
+    mParticleMask = (1u << kNParticleColumns) - 1;
+    return;
+  }
+
+  static const Char_t *names[kNParticleColumns] = {
+    "fIndex", "fPdg", "fStatus", "fParent", "fParentDecay", "fMate", "fDecay",
+    "fChild", "fChild", "fPx", "fPy", "fPz", "fE", "fX", "fY", "fZ", "fT"
+  };
+  mParticleMask = 0;
+  for (size_t i = 0; i < fields.size(); ++i) {
+    Bool_t found = kFALSE;
+    for (Int_t iCol = 0; iCol < kNParticleColumns; ++iCol) {
+      if (fields[i] != names[iCol]) continue;
+      mParticleMask |= (1u << iCol);
+      found = kTRUE;
+    }
+    if (!found) {
+      std::cout << "[WARNING] McDstColumns::setParticleFields: unknown data member "
+                << fields[i] << std::endl;
+    }
+  }
+}
+
+//_________________
+void McDstColumns::updateBlocks() {
+  // Vectors may have been reallocated
+  mBlock[kIndex] = mIndex.data();
+  mBlock[kPdg] = mPdg.data();
+  mBlock[kStatus] = mStatus.data();
+  mBlock[kParent] = mParent.data();
+  mBlock[kParentDecay] = mParentDecay.data();
+  mBlock[kMate] = mMate.data();
+  mBlock[kDecay] = mDecay.data();
+  mBlock[kFirstChild] = mFirstChild.data();
+  mBlock[kLastChild] = mLastChild.data();
+  mBlock[kPx] = mPx.data();
+  mBlock[kPy] = mPy.data();
+  mBlock[kPz] = mPz.data();
+  mBlock[kE] = mE.data();
+  mBlock[kX] = mX.data();
+  mBlock[kY] = mY.data();
+  mBlock[kZ] = mZ.data();
+  mBlock[kT] = mT.data();
+  mBlock[kBlockEventNr] = mEventNr.data();
+  mBlock[kBlockB] = mB.data();
+  mBlock[kBlockPhi] = mPhi.data();
+  mBlock[kBlockNes] = mNes.data();
+  mBlock[kBlockStepNr] = mStepNr.data();
+  mBlock[kBlockStepT] = mStepT.data();
+  mBlock[kBlockNpart] = mNpart.data();
+  mBlock[kBlockNcoll] = mNcoll.data();
+  mBlock[kBlockChainEntry] = mChainEntry.data();
+  mBlock[kBlockParticleOffset] = mParticleOffset.data();
+  mBlock[kBlockCommentOffset] = nullptr;
+  mBlock[kBlockComment] = nullptr;
+}
+
+//_________________
+Bool_t McDstColumns::isWritable(const Char_t* method) const {
+  // Attached storage is read-only
+  if (!mAttached) return kTRUE;
+  std::cout << "[WARNING] McDstColumns::" << method
+            << ": storage is attached to an external buffer" << std::endl;
+  return kFALSE;
+}
+
+//_________________
+TString McDstColumns::comment(Long64_t i) const {
+  // Comment of the event
+  if (!mAttached) return mComment[i];
+  const Long64_t *offset = (const Long64_t*)mBlock[kBlockCommentOffset];
+  if (!offset || offset[i + 1] == offset[i]) return TString();
+  return TString((const Char_t*)mBlock[kBlockComment] + offset[i],
+                 (Ssiz_t)(offset[i + 1] - offset[i]));
+}
+
+//_________________
+void McDstColumns::clear() {
+  // Remove all events, memory is kept for reuse
+  mAttached = kFALSE;
+  mAttachedBytes = 0;
+  mNEvents = 0;
+  mEventNr.clear();
+  mB.clear();
+  mPhi.clear();
+  mNes.clear();
+  mStepNr.clear();
+  mStepT.clear();
+  mComment.clear();
+  mNpart.clear();
+  mNcoll.clear();
+  mChainEntry.clear();
+  mParticleOffset.assign(1, 0);
+  mCommentBytes = 0;
+
+  mIndex.clear();
+  mPdg.clear();
+  mStatus.clear();
+  mParent.clear();
+  mParentDecay.clear();
+  mMate.clear();
+  mDecay.clear();
+  mFirstChild.clear();
+  mLastChild.clear();
+  mPx.clear();
+  mPy.clear();
+  mPz.clear();
+  mE.clear();
+  mX.clear();
+  mY.clear();
+  mZ.clear();
+  mT.clear();
+  updateBlocks();
+}
+
+//_________________
+void McDstColumns::reserve(Long64_t nEvents, Long64_t nParticles) {
+  // Reserve memory
+  if (!isWritable("reserve")) return;
+  mEventNr.reserve(nEvents);
+  mB.reserve(nEvents);
+  mPhi.reserve(nEvents);
+  mNes.reserve(nEvents);
+  mStepNr.reserve(nEvents);
+  mStepT.reserve(nEvents);
+  mComment.reserve(nEvents);
+  mNpart.reserve(nEvents);
+  mNcoll.reserve(nEvents);
+  mChainEntry.reserve(nEvents);
+  mParticleOffset.reserve(nEvents + 1);
+
+  if (hasColumn(kIndex)) mIndex.reserve(nParticles);
+  if (hasColumn(kPdg)) mPdg.reserve(nParticles);
+  if (hasColumn(kStatus)) mStatus.reserve(nParticles);
+  if (hasColumn(kParent)) mParent.reserve(nParticles);
+  if (hasColumn(kParentDecay)) mParentDecay.reserve(nParticles);
+  if (hasColumn(kMate)) mMate.reserve(nParticles);
+  if (hasColumn(kDecay)) mDecay.reserve(nParticles);
+  if (hasColumn(kFirstChild)) mFirstChild.reserve(nParticles);
+  if (hasColumn(kLastChild)) mLastChild.reserve(nParticles);
+  if (hasColumn(kPx)) mPx.reserve(nParticles);
+  if (hasColumn(kPy)) mPy.reserve(nParticles);
+  if (hasColumn(kPz)) mPz.reserve(nParticles);
+  if (hasColumn(kE)) mE.reserve(nParticles);
+  if (hasColumn(kX)) mX.reserve(nParticles);
+  if (hasColumn(kY)) mY.reserve(nParticles);
+  if (hasColumn(kZ)) mZ.reserve(nParticles);
+  if (hasColumn(kT)) mT.reserve(nParticles);
+  updateBlocks();
+}
+
+//_________________
+void McDstColumns::resizeParticles(Long64_t nParticles) {
+  // Resize stored particle columns
+  if (hasColumn(kIndex)) mIndex.resize(nParticles);
+  if (hasColumn(kPdg)) mPdg.resize(nParticles);
+  if (hasColumn(kStatus)) mStatus.resize(nParticles);
+  if (hasColumn(kParent)) mParent.resize(nParticles);
+  if (hasColumn(kParentDecay)) mParentDecay.resize(nParticles);
+  if (hasColumn(kMate)) mMate.resize(nParticles);
+  if (hasColumn(kDecay)) mDecay.resize(nParticles);
+  if (hasColumn(kFirstChild)) mFirstChild.resize(nParticles);
+  if (hasColumn(kLastChild)) mLastChild.resize(nParticles);
+  if (hasColumn(kPx)) mPx.resize(nParticles);
+  if (hasColumn(kPy)) mPy.resize(nParticles);
+  if (hasColumn(kPz)) mPz.resize(nParticles);
+  if (hasColumn(kE)) mE.resize(nParticles);
+  if (hasColumn(kX)) mX.resize(nParticles);
+  if (hasColumn(kY)) mY.resize(nParticles);
+  if (hasColumn(kZ)) mZ.resize(nParticles);
+  if (hasColumn(kT)) mT.resize(nParticles);
+}
+
+//_________________
+void McDstColumns::append(const McEvent* event, const TClonesArray* particles, Long64_t chainEntry) {
+  // Add event and its particles
+  if (!isWritable("append")) return;
+
+  // Event header (default values if the event branch is not read)
+  McEvent empty;
+  const McEvent *ev = event ? event : &empty;
+  TString comment;
+  ev->comment(comment);
+  mEventNr.push_back(ev->eventNr());
+  mB.push_back(ev->b());
+  mPhi.push_back(ev->phi());
+  mNes.push_back(ev->numberOfSteps());
+  mStepNr.push_back(ev->stepNumber());
+  mStepT.push_back(ev->stepT());
+  mComment.push_back(comment);
+  mCommentBytes += comment.Length();
+  mNpart.push_back(ev->npart());
+  mNcoll.push_back(ev->ncoll());
+  mChainEntry.push_back(chainEntry);
+
+  // Particles. Columns are resized once, then filled column by column
+  const Int_t nParticles = particles ? particles->GetEntriesFast() : 0;
+  const Long64_t offset = mParticleOffset.back();
+  resizeParticles(offset + nParticles);
+  TObject **objects = particles ? particles->GetObjectRef() : nullptr;
+  if (hasColumn(kIndex)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mIndex[offset + i] = particleAt(objects, i)->index();
+    }
+  }
+  if (hasColumn(kPdg)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mPdg[offset + i] = particleAt(objects, i)->pdg();
+    }
+  }
+  if (hasColumn(kStatus)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mStatus[offset + i] = particleAt(objects, i)->status();
+    }
+  }
+  if (hasColumn(kParent)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mParent[offset + i] = particleAt(objects, i)->parent();
+    }
+  }
+  if (hasColumn(kParentDecay)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mParentDecay[offset + i] = particleAt(objects, i)->parentDecay();
+    }
+  }
+  if (hasColumn(kMate)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mMate[offset + i] = particleAt(objects, i)->mate();
+    }
+  }
+  if (hasColumn(kDecay)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mDecay[offset + i] = particleAt(objects, i)->decay();
+    }
+  }
+  if (hasColumn(kFirstChild)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mFirstChild[offset + i] = particleAt(objects, i)->firstChild();
+    }
+  }
+  if (hasColumn(kLastChild)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mLastChild[offset + i] = particleAt(objects, i)->lastChild();
+    }
+  }
+  if (hasColumn(kPx)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mPx[offset + i] = particleAt(objects, i)->px();
+    }
+  }
+  if (hasColumn(kPy)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mPy[offset + i] = particleAt(objects, i)->py();
+    }
+  }
+  if (hasColumn(kPz)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mPz[offset + i] = particleAt(objects, i)->pz();
+    }
+  }
+  if (hasColumn(kE)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mE[offset + i] = particleAt(objects, i)->e();
+    }
+  }
+  if (hasColumn(kX)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mX[offset + i] = particleAt(objects, i)->x();
+    }
+  }
+  if (hasColumn(kY)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mY[offset + i] = particleAt(objects, i)->y();
+    }
+  }
+  if (hasColumn(kZ)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mZ[offset + i] = particleAt(objects, i)->z();
+    }
+  }
+  if (hasColumn(kT)) {
+    for (Int_t i = 0; i < nParticles; ++i) {
+      mT[offset + i] = particleAt(objects, i)->t();
+    }
+  }
+  mParticleOffset.push_back(mParticleOffset.back() + nParticles);
+  ++mNEvents;
+  updateBlocks();
+}
+
+//_________________
+void McDstColumns::append(const McDstColumns& columns, Long64_t first, Long64_t last) {
+  // Add events [first, last) of another storage
+  if (!isWritable("append")) return;
+  if (first < 0) first = 0;
+  if (last > columns.numberOfEvents()) last = columns.numberOfEvents();
+  if (first >= last) return;
+
+  appendRange(mEventNr, columns.eventNr(), first, last);
+  appendRange(mB, columns.b(), first, last);
+  appendRange(mPhi, columns.phi(), first, last);
+  appendRange(mNes, columns.nes(), first, last);
+  appendRange(mStepNr, columns.stepNr(), first, last);
+  appendRange(mStepT, columns.stepT(), first, last);
+  appendRange(mNpart, columns.npart(), first, last);
+  appendRange(mNcoll, columns.ncoll(), first, last);
+  appendRange(mChainEntry, columns.chainEntry(), first, last);
+  for (Long64_t i = first; i < last; ++i) {
+    mComment.push_back( columns.comment(i) );
+    mCommentBytes += mComment.back().Length();
+  }
+
+  // Particle offsets are shifted to this storage
+  const Long64_t *offset = columns.particleOffset();
+  const Long64_t pFirst = offset[first];
+  const Long64_t pLast = offset[last];
+  const Long64_t shift = mParticleOffset.back() - pFirst;
+  for (Long64_t i = first + 1; i <= last; ++i) {
+    mParticleOffset.push_back(offset[i] + shift);
+  }
+
+  if (hasColumn(kIndex)) appendRange(mIndex, stored(columns, kIndex, columns.index()), pFirst, pLast);
+  if (hasColumn(kPdg)) appendRange(mPdg, stored(columns, kPdg, columns.pdg()), pFirst, pLast);
+  if (hasColumn(kStatus)) appendRange(mStatus, stored(columns, kStatus, columns.status()), pFirst, pLast);
+  if (hasColumn(kParent)) appendRange(mParent, stored(columns, kParent, columns.parent()), pFirst, pLast);
+  if (hasColumn(kParentDecay)) appendRange(mParentDecay, stored(columns, kParentDecay, columns.parentDecay()), pFirst, pLast);
+  if (hasColumn(kMate)) appendRange(mMate, stored(columns, kMate, columns.mate()), pFirst, pLast);
+  if (hasColumn(kDecay)) appendRange(mDecay, stored(columns, kDecay, columns.decay()), pFirst, pLast);
+  if (hasColumn(kFirstChild)) appendRange(mFirstChild, stored(columns, kFirstChild, columns.firstChild()), pFirst, pLast);
+  if (hasColumn(kLastChild)) appendRange(mLastChild, stored(columns, kLastChild, columns.lastChild()), pFirst, pLast);
+  if (hasColumn(kPx)) appendRange(mPx, stored(columns, kPx, columns.px()), pFirst, pLast);
+  if (hasColumn(kPy)) appendRange(mPy, stored(columns, kPy, columns.py()), pFirst, pLast);
+  if (hasColumn(kPz)) appendRange(mPz, stored(columns, kPz, columns.pz()), pFirst, pLast);
+  if (hasColumn(kE)) appendRange(mE, stored(columns, kE, columns.e()), pFirst, pLast);
+  if (hasColumn(kX)) appendRange(mX, stored(columns, kX, columns.x()), pFirst, pLast);
+  if (hasColumn(kY)) appendRange(mY, stored(columns, kY, columns.y()), pFirst, pLast);
+  if (hasColumn(kZ)) appendRange(mZ, stored(columns, kZ, columns.z()), pFirst, pLast);
+  if (hasColumn(kT)) appendRange(mT, stored(columns, kT, columns.t()), pFirst, pLast);
+  mNEvents += last - first;
+  updateBlocks();
+}
+
+//_________________
+void McDstColumns::fill(Long64_t i, McEvent* event, TClonesArray* particles) const {
+  // Fill event i to the McEvent and particles to the TClonesArray
+  if (i < 0 || i >= numberOfEvents()) return;
+
+  if (event) {
+    event->setEventNr(eventNr()[i]);
+    event->setB(b()[i]);
+    event->setPhi(phi()[i]);
+    event->setNes(nes()[i]);
+    event->setStepNr(stepNr()[i]);
+    event->setStepT(stepT()[i]);
+    event->setComment(comment(i).Data());
+    event->setNpart(npart()[i]);
+    event->setNcoll(ncoll()[i]);
+  }
+
+  if (!particles) return;
+  particles->Clear();
+  const Long64_t first = particleOffset()[i];
+  const Long64_t last = particleOffset()[i + 1];
+  for (Long64_t j = first; j < last; ++j) {
+    McParticle *p = new ((*particles)[(Int_t)(j - first)]) McParticle();
+    if (hasColumn(kIndex)) p->setIndex(index()[j]);
+    if (hasColumn(kPdg)) p->setPdg(pdg()[j]);
+    if (hasColumn(kStatus)) p->setStatus(status()[j]);
+    if (hasColumn(kParent)) p->setParent(parent()[j]);
+    if (hasColumn(kParentDecay)) p->setParentDecay(parentDecay()[j]);
+    if (hasColumn(kMate)) p->setMate(mate()[j]);
+    if (hasColumn(kDecay)) p->setDecay(decay()[j]);
+    if (hasColumn(kFirstChild)) p->setFirstChild(firstChild()[j]);
+    if (hasColumn(kLastChild)) p->setLastChild(lastChild()[j]);
+    p->setMomentum(hasColumn(kPx) ? px()[j] : 0., hasColumn(kPy) ? py()[j] : 0.,
+                   hasColumn(kPz) ? pz()[j] : 0., hasColumn(kE) ? e()[j] : 0.);
+    p->setPosition(hasColumn(kX) ? x()[j] : 0., hasColumn(kY) ? y()[j] : 0.,
+                   hasColumn(kZ) ? z()[j] : 0., hasColumn(kT) ? t()[j] : 0.);
+  }
+}
+
+//_________________
+Long64_t McDstColumns::bytes() const {
+  // Size of the stored data
+  if (mAttached) return mAttachedBytes;
+  Long64_t nBytes = mCommentBytes;
+  nBytes += columnBytes(mEventNr);
+  nBytes += columnBytes(mB);
+  nBytes += columnBytes(mPhi);
+  nBytes += columnBytes(mNes);
+  nBytes += columnBytes(mStepNr);
+  nBytes += columnBytes(mStepT);
+  nBytes += columnBytes(mComment);
+  nBytes += columnBytes(mNpart);
+  nBytes += columnBytes(mNcoll);
+  nBytes += columnBytes(mChainEntry);
+  nBytes += columnBytes(mParticleOffset);
+  nBytes += columnBytes(mIndex);
+  nBytes += columnBytes(mPdg);
+  nBytes += columnBytes(mStatus);
+  nBytes += columnBytes(mParent);
+  nBytes += columnBytes(mParentDecay);
+  nBytes += columnBytes(mMate);
+  nBytes += columnBytes(mDecay);
+  nBytes += columnBytes(mFirstChild);
+  nBytes += columnBytes(mLastChild);
+  nBytes += columnBytes(mPx);
+  nBytes += columnBytes(mPy);
+  nBytes += columnBytes(mPz);
+  nBytes += columnBytes(mE);
+  nBytes += columnBytes(mX);
+  nBytes += columnBytes(mY);
+  nBytes += columnBytes(mZ);
+  nBytes += columnBytes(mT);
+  return nBytes;
+}
+
+//_________________
+void McDstColumns::shrink() {
+  // Release unused capacity
+  if (!isWritable("shrink")) return;
+  mEventNr.shrink_to_fit();
+  mB.shrink_to_fit();
+  mPhi.shrink_to_fit();
+  mNes.shrink_to_fit();
+  mStepNr.shrink_to_fit();
+  mStepT.shrink_to_fit();
+  mComment.shrink_to_fit();
+  mNpart.shrink_to_fit();
+  mNcoll.shrink_to_fit();
+  mChainEntry.shrink_to_fit();
+  mParticleOffset.shrink_to_fit();
+  mIndex.shrink_to_fit();
+  mPdg.shrink_to_fit();
+  mStatus.shrink_to_fit();
+  mParent.shrink_to_fit();
+  mParentDecay.shrink_to_fit();
+  mMate.shrink_to_fit();
+  mDecay.shrink_to_fit();
+  mFirstChild.shrink_to_fit();
+  mLastChild.shrink_to_fit();
+  mPx.shrink_to_fit();
+  mPy.shrink_to_fit();
+  mPz.shrink_to_fit();
+  mE.shrink_to_fit();
+  mX.shrink_to_fit();
+  mY.shrink_to_fit();
+  mZ.shrink_to_fit();
+  mT.shrink_to_fit();
+  updateBlocks();
+}
+
+//_________________
+struct McDstColumns::Header {
+  /// "McDstCol"
+  Char_t magic[8];
+  /// Format version
+  UInt_t version;
+  /// Stored particle columns
+  UInt_t particleMask;
+  /// Number of events
+  Long64_t nEvents;
+  /// Number of particles
+  Long64_t nParticles;
+  /// Size of the buffer
+  Long64_t size;
+  /// Position and size of every block in the buffer
+  Long64_t blockOffset[kNBlocks];
+  Long64_t blockBytes[kNBlocks];
+};
+
+//_________________
+static inline Long64_t alignedBytes(Long64_t bytes) {
+  // Blocks start at cache line boundaries
+  return (bytes + 63) & ~Long64_t(63);
+}
+
+//_________________
+Long64_t McDstColumns::blockBytes(Int_t block) const {
+  // Size of the data block in the buffer
+  static const Int_t elementSize[kNBlocks] = {
+    // Particle columns
+    sizeof(UShort_t), sizeof(Int_t), sizeof(Char_t), sizeof(UShort_t), sizeof(UShort_t),
+    sizeof(UShort_t), sizeof(Short_t), sizeof(UShort_t), sizeof(UShort_t),
+    sizeof(Float_t), sizeof(Float_t), sizeof(Float_t), sizeof(Float_t),
+    sizeof(Float_t), sizeof(Float_t), sizeof(Float_t), sizeof(Float_t),
+    // Event columns
+    sizeof(UInt_t), sizeof(Float_t), sizeof(Float_t), sizeof(UShort_t),
+    sizeof(UShort_t), sizeof(Float_t), sizeof(Short_t), sizeof(Short_t), sizeof(Long64_t),
+    // Particle offsets, comment offsets and characters
+    sizeof(Long64_t), sizeof(Long64_t), sizeof(Char_t)
+  };
+  if (block < kNParticleColumns) {
+    return hasColumn(block) ? numberOfParticles() * elementSize[block] : 0;
+  }
+  if (block == kBlockParticleOffset || block == kBlockCommentOffset) {
+    return (mNEvents + 1) * elementSize[block];
+  }
+  if (block == kBlockComment) {
+    return mAttached ? ((const Long64_t*)mBlock[kBlockCommentOffset])[mNEvents] : mCommentBytes;
+  }
+  return mNEvents * elementSize[block];
+}
+
+//_________________
+Long64_t McDstColumns::serializedSize() const {
+  // Header and all blocks
+  Long64_t size = alignedBytes(sizeof(Header));
+  for (Int_t iBlock = 0; iBlock < kNBlocks; ++iBlock) {
+    size += alignedBytes( blockBytes(iBlock) );
+  }
+  return size;
+}
+
+//_________________
+void McDstColumns::serialize(void* buffer) const {
+  // Write header and blocks
+  Char_t *base = (Char_t*)buffer;
+  Header header;
+  std::memset(&header, 0, sizeof(Header));
+  std::memcpy(header.magic, "McDstCol", 8);
+  header.version = 2;
+  header.particleMask = mParticleMask;
+  header.nEvents = mNEvents;
+  header.nParticles = numberOfParticles();
+
+  Long64_t position = alignedBytes(sizeof(Header));
+  for (Int_t iBlock = 0; iBlock < kNBlocks; ++iBlock) {
+    const Long64_t nBytes = blockBytes(iBlock);
+    header.blockOffset[iBlock] = position;
+    header.blockBytes[iBlock] = nBytes;
+    if (!mAttached && iBlock == kBlockCommentOffset) {
+      // Comments are kept as TStrings, offsets are computed here
+      Long64_t *offset = (Long64_t*)(base + position);
+      offset[0] = 0;
+      for (Long64_t i = 0; i < mNEvents; ++i) {
+        offset[i + 1] = offset[i] + mComment[i].Length();
+      }
+    }
+    else if (!mAttached && iBlock == kBlockComment) {
+      Char_t *characters = base + position;
+      for (Long64_t i = 0; i < mNEvents; ++i) {
+        std::memcpy(characters, mComment[i].Data(), mComment[i].Length());
+        characters += mComment[i].Length();
+      }
+    }
+    else if (nBytes > 0) {
+      std::memcpy(base + position, mBlock[iBlock], nBytes);
+    }
+    position += alignedBytes(nBytes);
+  }
+  header.size = position;
+  std::memcpy(base, &header, sizeof(Header));
+}
+
+//_________________
+Bool_t McDstColumns::attach(const void* buffer, Long64_t size) {
+  // Point blocks to the buffer
+  const Char_t *base = (const Char_t*)buffer;
+  if (!base || size < (Long64_t)sizeof(Header)) return kFALSE;
+  Header header;
+  std::memcpy(&header, base, sizeof(Header));
+  if (std::memcmp(header.magic, "McDstCol", 8) != 0 || header.version != 2 ||
+      header.size > size) {
+    std::cout << "[ERROR] McDstColumns::attach: buffer does not contain columns" << std::endl;
+    return kFALSE;
+  }
+
+  // Own data are released
+  clear();
+  shrink();
+  mParticleMask = header.particleMask;
+  mNEvents = header.nEvents;
+  for (Int_t iBlock = 0; iBlock < kNBlocks; ++iBlock) {
+    mBlock[iBlock] = (header.blockBytes[iBlock] > 0) ? base + header.blockOffset[iBlock] : nullptr;
+  }
+  mAttached = kTRUE;
+  mAttachedBytes = header.size;
+  return kTRUE;
+}
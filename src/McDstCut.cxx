@@ -22,6 +22,7 @@ McDstCut::McDstCut(const McDstCut &copy) {
   ptCut[0] = copy.ptCut[0];
   ptCut[1] = copy.ptCut[1];
   pdgExclude = copy.pdgExclude;
+  pdgInclude = copy.pdgInclude;
 }
 
 //_________________
@@ -29,6 +30,11 @@ void McDstCut::excludePdg(int pdg) {
   pdgExclude.push_back(pdg);
 }
 
+//_________________
+void McDstCut::includePdg(int pdg) {
+  pdgInclude.push_back(pdg);
+}
+
 //_________________
 void McDstCut::setEta(float lo, float hi) {
   etaCut[0] = lo;
@@ -65,7 +71,7 @@ void McDstCut::setPtHigh(float val) {
 bool McDstCut::isGoodParticle(const TLorentzVector &v, int pdg) {
   if (v.Eta() > etaCut[0] && v.Eta() < etaCut[1] &&
       v.Pt() > ptCut[0] && v.Pt() < ptCut[1] &&
-      checkExcludePdg(pdg) == false) {
+      checkExcludePdg(pdg) == false && checkIncludePdg(pdg) == true) {
     return true;
   }
   return false;
@@ -79,3 +85,14 @@ bool McDstCut::checkExcludePdg(int pdg) {
   }
   return false;
 }
+
+//_________________
+bool McDstCut::checkIncludePdg(int pdg) {
+  if (pdgInclude.empty())
+    return true;
+  for (std::vector<int>::iterator i = pdgInclude.begin(); i != pdgInclude.end(); ++i) {
+    if (*i == pdg)
+      return true;
+  }
+  return false;
+}
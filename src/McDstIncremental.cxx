@@ -0,0 +1,337 @@
+//
+// Processes only new input files and merges the results
+//
+
+// C++ headers
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <set>
+#include <map>
+
+// ROOT headers
+#include "TFile.h"
+#include "TDirectory.h"
+#include "TKey.h"
+#include "TList.h"
+#include "TH1.h"
+#include "TMD5.h"
+#include "TRegexp.h"
+#include "TSystem.h"
+
+// McDst headers
+#include "McDstIncremental.h"
+
+//_________________
+McDstIncremental::McDstIncremental(const Char_t* inFileName, const Char_t* oFileName,
+                                   const Char_t* config) :
+  mInputFileName(inFileName), mOutputFileName(oFileName),
+  mStateFileName(Form("%s.state", oFileName)), mConfigHash(),
+  mRunInputFileName(), mRunOutputFileName(), mUseChecksum(kFALSE),
+  mFullRun(kTRUE), mNEvents(0), mNormalized(), mFiles(), mToProcess() {
+  // Constructor
+  TMD5 md5;
+  TString configuration(config);
+  md5.Update((const UChar_t*)configuration.Data(), configuration.Length());
+  md5.Final();
+  mConfigHash = md5.AsString();
+}
+
+//_________________
+McDstIncremental::~McDstIncremental() {
+  // Destructor
+}
+
+//_________________
+std::vector<TString> McDstIncremental::inputFiles() const {
+  // Same input conventions as McDstReader
+  std::vector<TString> files;
+  if (mInputFileName.Contains(".list") || mInputFileName.Contains(".lis")) {
+    std::ifstream inputStream(mInputFileName.Data());
+    if (!inputStream) {
+      std::cout << "[ERROR] Cannot open list file " << mInputFileName << std::endl;
+    }
+    std::string file;
+    while (std::getline(inputStream, file)) {
+      if (file.find(".mcDst.root") != std::string::npos) {
+        files.push_back(file.c_str());
+      }
+    }
+  }
+  else if (mInputFileName.Contains(".mcDst.root")) {
+    files.push_back(mInputFileName);
+  }
+  else {
+    std::cout << "[WARNING] No good input file to read ... " << std::endl;
+  }
+  return files;
+}
+
+//_________________
+McDstIncremental::FileState McDstIncremental::fileState(const TString& path) const {
+  // Size, modification time and checksum of the file
+  FileState state;
+  state.path = path;
+  state.size = -1;
+  state.mtime = 0;
+  FileStat_t stat;
+  if (gSystem->GetPathInfo(path.Data(), stat) != 0) return state;
+  state.size = stat.fSize;
+  state.mtime = stat.fMtime;
+  if (mUseChecksum) {
+    TMD5 *md5 = TMD5::FileChecksum(path.Data());
+    if (md5) {
+      state.checksum = md5->AsString();
+      delete md5;
+    }
+  }
+  return state;
+}
+
+//_________________
+Bool_t McDstIncremental::readState(TString& configHash, Long64_t& nEvents,
+                                   std::vector<FileState>& files) const {
+  // Read state file
+  std::ifstream stateStream(mStateFileName.Data());
+  if (!stateStream) return kFALSE;
+
+  std::string line;
+  while (std::getline(stateStream, line)) {
+    std::istringstream iss(line);
+    std::string tag;
+    iss >> tag;
+    if (tag == "config") {
+      std::string hash;
+      iss >> hash;
+      configHash = hash.c_str();
+    }
+    else if (tag == "events") {
+      iss >> nEvents;
+    }
+    else if (tag == "file") {
+      FileState state;
+      std::string path, checksum;
+      iss >> path >> state.size >> state.mtime >> checksum;
+      state.path = path.c_str();
+      state.checksum = (checksum == "-") ? "" : checksum.c_str();
+      files.push_back(state);
+    }
+  }
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstIncremental::writeState() const {
+  // Write state file
+  std::ofstream stateStream(mStateFileName.Data());
+  if (!stateStream) {
+    std::cout << "[ERROR] McDstIncremental: cannot write state file "
+              << mStateFileName << std::endl;
+    return kFALSE;
+  }
+  stateStream << "# McDstIncremental state of " << mOutputFileName << std::endl;
+  stateStream << "config " << mConfigHash << std::endl;
+  stateStream << "events " << mNEvents << std::endl;
+  for (size_t i = 0; i < mFiles.size(); ++i) {
+    stateStream << "file " << mFiles[i].path << " " << mFiles[i].size << " "
+                << mFiles[i].mtime << " "
+                << (mFiles[i].checksum.IsNull() ? TString("-") : mFiles[i].checksum)
+                << std::endl;
+  }
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstIncremental::prepare() {
+  // Compare input with the state of the previous run
+  std::vector<TString> files = inputFiles();
+  mFiles.clear();
+  mToProcess.clear();
+  for (size_t i = 0; i < files.size(); ++i) {
+    FileState state = fileState(files[i]);
+    if (state.size < 0) {
+      std::cout << "[WARNING] McDstIncremental: file " << files[i]
+                << " does not exist" << std::endl;
+      continue;
+    }
+    mFiles.push_back(state);
+  }
+
+  // Decide if the previous output can be reused
+  TString configHash;
+  Long64_t nEvents = 0;
+  std::vector<FileState> previous;
+  mFullRun = kTRUE;
+  if (gSystem->AccessPathName(mOutputFileName.Data())) {
+    std::cout << "McDstIncremental: no previous output, processing all files" << std::endl;
+  }
+  else if (!readState(configHash, nEvents, previous)) {
+    std::cout << "McDstIncremental: no state file, processing all files" << std::endl;
+  }
+  else if (configHash != mConfigHash) {
+    std::cout << "McDstIncremental: configuration has changed, processing all files" << std::endl;
+  }
+  else {
+    mFullRun = kFALSE;
+    std::map<TString, const FileState*> current;
+    for (size_t i = 0; i < mFiles.size(); ++i) {
+      current[mFiles[i].path] = &mFiles[i];
+    }
+    std::set<TString> processed;
+    for (size_t i = 0; i < previous.size() && !mFullRun; ++i) {
+      std::map<TString, const FileState*>::const_iterator it = current.find(previous[i].path);
+      if (it == current.end()) {
+        std::cout << "McDstIncremental: " << previous[i].path
+                  << " has been removed, processing all files" << std::endl;
+        mFullRun = kTRUE;
+      }
+      else if (it->second->size != previous[i].size || it->second->mtime != previous[i].mtime ||
+               (mUseChecksum && !previous[i].checksum.IsNull() &&
+                it->second->checksum != previous[i].checksum)) {
+        std::cout << "McDstIncremental: " << previous[i].path
+                  << " has been changed, processing all files" << std::endl;
+        mFullRun = kTRUE;
+      }
+      processed.insert(previous[i].path);
+    }
+    if (!mFullRun) {
+      mNEvents = nEvents;
+      for (size_t i = 0; i < mFiles.size(); ++i) {
+        if (processed.find(mFiles[i].path) == processed.end()) {
+          mToProcess.push_back(mFiles[i].path);
+        }
+      }
+    }
+  }
+
+  if (mFullRun) {
+    mNEvents = 0;
+    mToProcess.clear();
+    for (size_t i = 0; i < mFiles.size(); ++i) {
+      mToProcess.push_back(mFiles[i].path);
+    }
+  }
+
+  if (mToProcess.empty()) {
+    std::cout << "McDstIncremental: no new files, " << mOutputFileName
+              << " is up to date" << std::endl;
+    return kFALSE;
+  }
+
+  // List of files for this run
+  mRunInputFileName = Form("%s.incremental.list", mOutputFileName.Data());
+  std::ofstream listStream(mRunInputFileName.Data());
+  for (size_t i = 0; i < mToProcess.size(); ++i) {
+    listStream << mToProcess[i] << std::endl;
+  }
+  listStream.close();
+  mRunOutputFileName = mFullRun ? mOutputFileName :
+    TString(Form("%s.incremental.root", mOutputFileName.Data()));
+
+  std::cout << "McDstIncremental: " << mToProcess.size() << " of " << mFiles.size()
+            << " files will be processed" << std::endl;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstIncremental::finish(Long64_t nEvents) {
+  // Merge outputs and write the state
+  gSystem->Unlink(mRunInputFileName.Data());
+
+  if (!mFullRun) {
+    TDirectory::TContext context;
+    TFile *previous = TFile::Open(mOutputFileName.Data());
+    TFile *current = TFile::Open(mRunOutputFileName.Data());
+    TString mergedFileName = Form("%s.merged.root", mOutputFileName.Data());
+    TFile *merged = TFile::Open(mergedFileName.Data(), "recreate");
+    if (!previous || previous->IsZombie() || !current || current->IsZombie() ||
+        !merged || merged->IsZombie()) {
+      std::cout << "[ERROR] McDstIncremental::finish: cannot open files to merge. "
+                << "Results of this run are kept in " << mRunOutputFileName << std::endl;
+      delete previous;
+      delete current;
+      delete merged;
+      return kFALSE;
+    }
+    mergeDirectory(previous, current, merged, mNEvents, nEvents);
+    merged->Close();
+    current->Close();
+    previous->Close();
+    delete merged;
+    delete current;
+    delete previous;
+
+    gSystem->Rename(mergedFileName.Data(), mOutputFileName.Data());
+    gSystem->Unlink(mRunOutputFileName.Data());
+  }
+
+  mNEvents += nEvents;
+  std::cout << "McDstIncremental: " << mOutputFileName << " contains " << mNEvents
+            << " events" << std::endl;
+  return writeState();
+}
+
+//_________________
+Bool_t McDstIncremental::isNormalized(const Char_t* name) const {
+  // Check if the name matches one of the wildcards
+  TString histName(name);
+  for (size_t i = 0; i < mNormalized.size(); ++i) {
+    TRegexp re(mNormalized[i], kTRUE);
+    Ssiz_t len = 0;
+    if (re.Index(histName, &len) == 0 && len == histName.Length()) return kTRUE;
+  }
+  return kFALSE;
+}
+
+//_________________
+void McDstIncremental::mergeDirectory(TDirectory* previous, TDirectory* current,
+                                      TDirectory* output, Long64_t nPrevious,
+                                      Long64_t nCurrent) const {
+  // Merge objects with the same names
+  std::vector<TString> names;
+  std::set<TString> known;
+  TDirectory *dirs[2] = { previous, current };
+  for (Int_t iDir = 0; iDir < 2; ++iDir) {
+    if (!dirs[iDir]) continue;
+    TIter next(dirs[iDir]->GetListOfKeys());
+    while (TKey *key = (TKey*)next()) {
+      if (known.insert(key->GetName()).second) names.push_back(key->GetName());
+    }
+  }
+
+  const Double_t nTotal = (Double_t)(nPrevious + nCurrent);
+  for (size_t i = 0; i < names.size(); ++i) {
+    const Char_t *name = names[i].Data();
+    TObject *prevObj = previous ? previous->Get(name) : nullptr;
+    TObject *currObj = current ? current->Get(name) : nullptr;
+
+    // Subdirectories
+    TDirectory *prevDir = dynamic_cast<TDirectory*>(prevObj);
+    TDirectory *currDir = dynamic_cast<TDirectory*>(currObj);
+    if (prevDir || currDir) {
+      TDirectory *outDir = output->mkdir(name);
+      mergeDirectory(prevDir, currDir, outDir, nPrevious, nCurrent);
+      continue;
+    }
+
+    TH1 *prevHist = dynamic_cast<TH1*>(prevObj);
+    TH1 *currHist = dynamic_cast<TH1*>(currObj);
+    if (prevHist) prevHist->SetDirectory(nullptr);
+    if (currHist) currHist->SetDirectory(nullptr);
+    TObject *result = currObj ? currObj : prevObj;
+    if (prevHist || currHist) {
+      const Bool_t normalized = isNormalized(name) && nTotal > 0;
+      const Double_t wPrev = normalized ? nPrevious / nTotal : 1.;
+      const Double_t wCurr = normalized ? nCurrent / nTotal : 1.;
+      TH1 *sum = prevHist ? prevHist : currHist;
+      if (sum == prevHist && wPrev != 1.) sum->Scale(wPrev);
+      if (sum == currHist && wCurr != 1.) sum->Scale(wCurr);
+      if (prevHist && currHist) sum->Add(currHist, wCurr);
+      result = sum;
+    }
+    output->WriteTObject(result, name);
+    delete prevObj;
+    delete currObj;
+  }
+}
@@ -0,0 +1,247 @@
+//
+// Reads mcDst file or a list of files in several threads
+//
+
+// C++ headers
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+// ROOT headers
+#include "TROOT.h"
+#include "TChain.h"
+
+// McDst headers
+#include "McDstColumns.h"
+#include "McDstReader.h"
+#include "McDstParallelReader.h"
+
+//_________________
+McDstParallelReader::McDstParallelReader(const Char_t* inFileName, UInt_t nThreads) :
+  mInputFileName(inFileName), mNThreads(nThreads), mChunkSize(1000),
+  mClock(10000), mMaxEntries(-1), mStatus(), mFields(), mReaders(), mSelectionFileName(),
+  mSelectionName(), mStagingDirectory(), mStagingMaxBytes(0), mZoneCut(),
+  mSkipClusters(kFALSE), mPrintMutex() {
+  // Constructor
+  if (mNThreads == 0) {
+    mNThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+}
+
+//_________________
+McDstParallelReader::~McDstParallelReader() {
+  // Destructor
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    mReaders[i]->Finish();
+    delete mReaders[i];
+  }
+}
+
+//_________________
+void McDstParallelReader::setStatus(const Char_t* branchNameRegex, Int_t enable) {
+  // Remember the status for readers that are not created yet
+  mStatus.push_back(std::make_pair(TString(branchNameRegex), enable));
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    mReaders[i]->setStatus(branchNameRegex, enable);
+  }
+}
+
+//_________________
+void McDstParallelReader::setFields(Int_t arrayType, const std::vector<TString>& fields) {
+  // Remember the selection for readers that are not created yet
+  mFields.push_back(std::make_pair(arrayType, fields));
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    mReaders[i]->setFields(arrayType, fields);
+  }
+}
+
+//_________________
+void McDstParallelReader::init() {
+  // Readers are created one by one, only reading is parallel
+  if (!mReaders.empty()) return;
+  ROOT::EnableThreadSafety();
+  for (UInt_t iSlot = 0; iSlot < mNThreads; ++iSlot) {
+    McDstReader *reader = new McDstReader(mInputFileName.Data());
+    if (!mStagingDirectory.IsNull()) {
+      reader->setStagingCache(mStagingDirectory.Data(), mStagingMaxBytes);
+    }
+    reader->Init();
+    for (size_t i = 0; i < mStatus.size(); ++i) {
+      reader->setStatus(mStatus[i].first.Data(), mStatus[i].second);
+    }
+    for (size_t i = 0; i < mFields.size(); ++i) {
+      reader->setFields(mFields[i].first, mFields[i].second);
+    }
+    if (!mSelectionFileName.IsNull()) {
+      reader->readSelection(mSelectionFileName.Data(), mSelectionName.Data());
+    }
+    if (mSkipClusters) reader->skipClusters(mZoneCut);
+    mReaders.push_back(reader);
+  }
+}
+
+//_________________
+void McDstParallelReader::setStagingCache(const Char_t* directory, Long64_t maxBytes) {
+  // Applied when the readers are created
+  if (!mReaders.empty()) {
+    std::cout << "[WARNING] McDstParallelReader::setStagingCache: readers are already created"
+              << std::endl;
+    return;
+  }
+  mStagingDirectory = directory;
+  mStagingMaxBytes = maxBytes;
+}
+
+//_________________
+void McDstParallelReader::readSelection(const Char_t* fileName, const Char_t* name) {
+  // Remember the selection for readers that are not created yet
+  mSelectionFileName = fileName;
+  mSelectionName = name;
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    mReaders[i]->readSelection(fileName, name);
+  }
+}
+
+//_________________
+void McDstParallelReader::skipClusters(const McDstZoneMap::Cut& cut) {
+  // Remember the cut for readers that are not created yet
+  mZoneCut = cut;
+  mSkipClusters = kTRUE;
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    mReaders[i]->skipClusters(cut);
+  }
+}
+
+//_________________
+Bool_t McDstParallelReader::writeSelection(const Char_t* fileName, const Char_t* name) {
+  // Merge entries accepted by all slots and write them
+  init();
+  McDstReader *first = nullptr;
+  for (size_t i = 0; i < mReaders.size(); ++i) {
+    if (!mReaders[i]->selection()) continue;
+    if (!first) {
+      first = mReaders[i];
+      continue;
+    }
+    first->selection()->Add( mReaders[i]->selection() );
+    mReaders[i]->clearSelection();
+  }
+  if (!first) {
+    std::cout << "[WARNING] McDstParallelReader::writeSelection: no entries have been accepted"
+              << std::endl;
+    return kFALSE;
+  }
+  return first->writeSelection(fileName, name);
+}
+
+//_________________
+Bool_t McDstParallelReader::loadToMemory(Long64_t maxBytes) {
+  // The first reader owns the events, the others share them
+  init();
+  if (!mReaders[0]->loadToMemory(maxBytes)) return kFALSE;
+  for (size_t i = 1; i < mReaders.size(); ++i) {
+    mReaders[i]->setMemory( mReaders[0]->memory() );
+  }
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstParallelReader::loadToSharedMemory(Long64_t maxBytes, const Char_t* directory) {
+  // The first reader attaches the cache, the others share it
+  init();
+  if (!mReaders[0]->loadToSharedMemory(maxBytes, directory)) return kFALSE;
+  for (size_t i = 1; i < mReaders.size(); ++i) {
+    mReaders[i]->setMemory( mReaders[0]->memory() );
+  }
+  return kTRUE;
+}
+
+//_________________
+const McDstColumns *McDstParallelReader::memory() {
+  // Events in memory
+  init();
+  return mReaders[0]->memory();
+}
+
+//_________________
+Long64_t McDstParallelReader::entries() {
+  // Number of entries in the input
+  init();
+  return mReaders[0]->numberOfEntries();
+}
+
+//_________________
+Long64_t McDstParallelReader::process(const std::function<void(UInt_t, McDstReader*)>& func) {
+  // Process all entries one by one
+  return dispatch([&](UInt_t iSlot, Long64_t first, Long64_t last) {
+    McDstReader *reader = mReaders[iSlot];
+    Long64_t nGood = 0;
+    for (Long64_t iEntry = first; iEntry < last; ++iEntry) {
+      if (!reader->loadEntry( reader->entryNumber(iEntry) )) {
+        std::lock_guard<std::mutex> lock(mPrintMutex);
+        std::cout << "[WARNING] McDstParallelReader: cannot read entry "
+                  << iEntry << std::endl;
+        continue;
+      }
+      func(iSlot, reader);
+      ++nGood;
+    }
+    return nGood;
+  });
+}
+
+//_________________
+Long64_t McDstParallelReader::processBatches(const std::function<void(UInt_t, const McDstColumns&)>& func) {
+  // Process all entries in batches of the chunk size
+  init();
+  std::vector<McDstColumns> batches(mNThreads);
+  return dispatch([&](UInt_t iSlot, Long64_t first, Long64_t last) {
+    McDstColumns &batch = batches[iSlot];
+    Long64_t nGood = mReaders[iSlot]->loadBatch(first, last - first, batch);
+    if (nGood > 0) func(iSlot, batch);
+    return nGood;
+  });
+}
+
+//_________________
+Long64_t McDstParallelReader::dispatch(const std::function<Long64_t(UInt_t, Long64_t, Long64_t)>& chunk) {
+  // Hand out chunks of entries to the threads
+  Long64_t nEntries = entries();
+  if (mMaxEntries >= 0 && mMaxEntries < nEntries) {
+    nEntries = mMaxEntries;
+  }
+
+  std::atomic<Long64_t> nextEntry(0);
+  std::atomic<Long64_t> nDone(0);
+  std::atomic<Long64_t> nProcessed(0);
+
+  auto worker = [&](UInt_t iSlot) {
+    for (;;) {
+      Long64_t first = nextEntry.fetch_add(mChunkSize);
+      if (first >= nEntries) break;
+      Long64_t last = std::min(first + mChunkSize, nEntries);
+      nProcessed += chunk(iSlot, first, last);
+
+      Long64_t n = last - first;
+      Long64_t done = nDone.fetch_add(n) + n;
+      if (mClock > 0 && done / mClock != (done - n) / mClock) {
+        std::lock_guard<std::mutex> lock(mPrintMutex);
+        std::cout << "Working on event #[" << (done / mClock) * mClock
+                  << "/" << nEntries << "]" << std::endl;
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  for (UInt_t iSlot = 1; iSlot < mNThreads; ++iSlot) {
+    threads.emplace_back(worker, iSlot);
+  }
+  worker(0);
+  for (size_t i = 0; i < threads.size(); ++i) {
+    threads[i].join();
+  }
+
+  return nProcessed;
+}
@@ -0,0 +1,100 @@
+//
+// Writes mcDst from several threads into a single file
+//
+
+// C++ headers
+#include <iostream>
+
+// ROOT headers
+#include "TROOT.h"
+
+// McDst headers
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McRun.h"
+#include "McDstParallelWriter.h"
+
+//_________________
+McDstParallelWriter::Slot::Slot(std::shared_ptr<McBufferMergerFile> file,
+                                const Char_t* treeTitle, Long64_t flushSize) :
+  mFile(file), mTree(nullptr), mArrays{}, mFlushSize(flushSize),
+  mBytes(0), mEntries(0) {
+  // Constructor
+  mFile->cd();
+  mTree = new TTree("McDst", treeTitle);
+  // The tree is handled by this thread only
+  mTree->ResetBit(TObject::kMustCleanup);
+  // Tree header is written by the merger
+  mTree->SetAutoSave(0);
+  for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
+    mArrays[i] = new TClonesArray(McArrays::mcArrayTypes[i], McArrays::mcArraySizes[i]);
+    mTree->Branch(McArrays::mcArrayNames[i], &mArrays[i]);
+  }
+}
+
+//_________________
+McDstParallelWriter::Slot::~Slot() {
+  // Destructor
+  flush();
+  // The tree is deleted together with the in-memory file
+  mFile.reset();
+  for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
+    delete mArrays[i];
+  }
+}
+
+//_________________
+void McDstParallelWriter::Slot::clear() {
+  // Clear arrays
+  for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
+    mArrays[i]->Clear();
+  }
+}
+
+//_________________
+Int_t McDstParallelWriter::Slot::fill() {
+  // Serialize current event. Baskets are compressed here
+  Int_t nBytes = mTree->Fill();
+  if (nBytes > 0) {
+    mBytes += nBytes;
+    ++mEntries;
+  }
+  if (mFlushSize > 0 && mBytes >= mFlushSize) {
+    flush();
+  }
+  return nBytes;
+}
+
+//_________________
+void McDstParallelWriter::Slot::flush() {
+  // Send baskets to the merger. The slot tree is reset after that
+  if (mBytes == 0 || !mFile) return;
+  mFile->Write();
+  mBytes = 0;
+}
+
+//_________________
+McDstParallelWriter::McDstParallelWriter(const Char_t* oFileName,
+                                         Int_t compressionSettings,
+                                         const Char_t* treeTitle) :
+  mMerger(nullptr), mTreeTitle(treeTitle), mFlushSize(32 << 20) {
+  // Constructor
+  ROOT::EnableThreadSafety();
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+  mMerger.reset( new McBufferMerger(oFileName, "RECREATE", compressionSettings) );
+}
+
+//_________________
+McDstParallelWriter::~McDstParallelWriter() {
+  // Destructor. Merger writes the rest and closes the file
+  mMerger.reset();
+}
+
+//_________________
+std::unique_ptr<McDstParallelWriter::Slot> McDstParallelWriter::createSlot() {
+  // Create new slot that writes to its own in-memory file
+  std::lock_guard<std::mutex> lock(mMutex);
+  return std::unique_ptr<Slot>( new Slot(mMerger->GetFile(), mTreeTitle.Data(), mFlushSize) );
+}
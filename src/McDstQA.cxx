@@ -0,0 +1,314 @@
+//
+// Produces quality assurance histograms for mcDst files
+//
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+#include <cstdlib>
+
+// ROOT headers
+#include "TFile.h"
+#include "TH1.h"
+#include "TH2.h"
+#include "TMath.h"
+#include "TStopwatch.h"
+#include "TDatabasePDG.h"
+#include "TParticlePDG.h"
+#include "TLorentzVector.h"
+
+// McDst headers
+#include "McDstQA.h"
+#include "McDstReader.h"
+#include "McDstParallelReader.h"
+#include "McEvent.h"
+#include "McParticle.h"
+
+//_________________
+McDstQA::Species::Species() :
+  hPt(200, 0., 5.), hEta(160, -8., 8.), hRapidity(160, -8., 8.),
+  hPhi(100, -TMath::Pi(), TMath::Pi()) {
+  // Constructor
+}
+
+//_________________
+void McDstQA::Species::add(const Species& s) {
+  hPt.add(s.hPt);
+  hEta.add(s.hEta);
+  hRapidity.add(s.hRapidity);
+  hPhi.add(s.hPhi);
+}
+
+//_________________
+McDstQA::Histograms::Histograms() :
+  hImpactPar(200, 0., 20.), hMult(1000, 0., 10000.), hNpart(500, 0., 500.),
+  hNcoll(500, 0., 2500.), hMultVsImpactPar(200, 0., 20., 500, 0., 10000.),
+  hNpartVsImpactPar(200, 0., 20., 250, 0., 500.),
+  hNcollVsImpactPar(200, 0., 20., 250, 0., 2500.),
+  hPt(200, 0., 5.), hEta(160, -8., 8.), hRapidity(160, -8., 8.),
+  hPhi(100, -TMath::Pi(), TMath::Pi()), hPtVsEta(160, -8., 8., 100, 0., 5.),
+  hPtVsRapidity(160, -8., 8., 100, 0., 5.),
+  hX(200, -50., 50.), hY(200, -50., 50.), hZ(200, -100., 100.),
+  hT(200, 0., 200.), hTau(200, 0., 200.), hEtaS(160, -8., 8.),
+  hXY(100, -50., 50., 100, -50., 50.), hTauVsEtaS(160, -8., 8., 100, 0., 200.),
+  mColumns(), mDense(2 * kDenseRange, -1), mSparse(), mPdg(), mSpecies() {
+  // Constructor
+}
+
+//_________________
+McDstQA::Species& McDstQA::Histograms::species(Int_t pdg) {
+  // Look up the species, add it when found for the first time
+  Int_t *index;
+  if (pdg > -kDenseRange && pdg < kDenseRange) {
+    index = &mDense[pdg + kDenseRange];
+  }
+  else {
+    index = &mSparse.insert(std::make_pair(pdg, -1)).first->second;
+  }
+  if (*index < 0) {
+    *index = mSpecies.size();
+    mPdg.push_back(pdg);
+    mSpecies.push_back(Species());
+  }
+  return mSpecies[*index];
+}
+
+//_________________
+void McDstQA::Histograms::add(const Histograms& h) {
+  // Add histograms of another thread
+  hImpactPar.add(h.hImpactPar);
+  hMult.add(h.hMult);
+  hNpart.add(h.hNpart);
+  hNcoll.add(h.hNcoll);
+  hMultVsImpactPar.add(h.hMultVsImpactPar);
+  hNpartVsImpactPar.add(h.hNpartVsImpactPar);
+  hNcollVsImpactPar.add(h.hNcollVsImpactPar);
+
+  hPt.add(h.hPt);
+  hEta.add(h.hEta);
+  hRapidity.add(h.hRapidity);
+  hPhi.add(h.hPhi);
+  hPtVsEta.add(h.hPtVsEta);
+  hPtVsRapidity.add(h.hPtVsRapidity);
+
+  hX.add(h.hX);
+  hY.add(h.hY);
+  hZ.add(h.hZ);
+  hT.add(h.hT);
+  hTau.add(h.hTau);
+  hEtaS.add(h.hEtaS);
+  hXY.add(h.hXY);
+  hTauVsEtaS.add(h.hTauVsEtaS);
+
+  // Species are added in the order of the other thread
+  for (size_t i = 0; i < h.mSpecies.size(); ++i) {
+    species(h.mPdg[i]).add(h.mSpecies[i]);
+  }
+}
+
+//_________________
+McDstQA::McDstQA(const Char_t* iFileName, const Char_t* oFileName, UInt_t nThreads) :
+  mInputFileName(iFileName), mOutputFileName(oFileName), mNThreads(nThreads),
+  mMaxEvents(-1), mCut(nullptr) {
+  // Constructor
+}
+
+//_________________
+McDstQA::~McDstQA() {
+  // Destructor
+  delete mCut;
+}
+
+//_________________
+void McDstQA::setMcDstCut(McDstCut* cut) {
+  // Set particle selection
+  delete mCut;
+  mCut = cut ? new McDstCut(*cut) : nullptr;
+}
+
+//_________________
+void McDstQA::fill(Histograms& h, McDstCut* cut, McDstReader* reader) {
+  // Fill histograms with the current event
+  McEvent *event = reader->event();
+  if (!event) {
+    std::cout << "[WARNING] McDstQA::fill: event is missing" << std::endl;
+    return;
+  }
+
+  for (Int_t i = 0; i < Histograms::kNColumns; ++i) {
+    h.mColumns[i].clear();
+  }
+
+  const UInt_t nParticles = reader->numberOfParticles();
+  for (UInt_t iTrk = 0; iTrk < nParticles; ++iTrk) {
+    McParticle *particle = reader->particle(iTrk);
+    if (!particle) continue;
+
+    TLorentzVector mom = particle->momentum();
+    if (cut && !cut->isGoodParticle(mom, particle->pdg())) continue;
+
+    const Float_t pt = mom.Pt();
+    const Float_t eta = mom.Eta();
+    const Float_t rapidity = mom.Rapidity();
+    const Float_t phi = mom.Phi();
+
+    Species &s = h.species(particle->pdg());
+    s.hPt.fill(pt);
+    s.hEta.fill(eta);
+    s.hRapidity.fill(rapidity);
+    s.hPhi.fill(phi);
+
+    h.mColumns[Histograms::kPt].push_back(pt);
+    h.mColumns[Histograms::kEta].push_back(eta);
+    h.mColumns[Histograms::kRapidity].push_back(rapidity);
+    h.mColumns[Histograms::kPhi].push_back(phi);
+    h.mColumns[Histograms::kX].push_back(particle->x());
+    h.mColumns[Histograms::kY].push_back(particle->y());
+    h.mColumns[Histograms::kZ].push_back(particle->z());
+    h.mColumns[Histograms::kT].push_back(particle->t());
+    h.mColumns[Histograms::kTau].push_back(particle->tau());
+    h.mColumns[Histograms::kEtaS].push_back(particle->etaS());
+  }
+
+  // Particles of the event are filled in batches
+  const std::vector<Float_t> *c = h.mColumns;
+  const Long64_t n = c[Histograms::kPt].size();
+  h.hPt.fill(c[Histograms::kPt].data(), n);
+  h.hEta.fill(c[Histograms::kEta].data(), n);
+  h.hRapidity.fill(c[Histograms::kRapidity].data(), n);
+  h.hPhi.fill(c[Histograms::kPhi].data(), n);
+  h.hPtVsEta.fill(c[Histograms::kEta].data(), c[Histograms::kPt].data(), n);
+  h.hPtVsRapidity.fill(c[Histograms::kRapidity].data(), c[Histograms::kPt].data(), n);
+  h.hX.fill(c[Histograms::kX].data(), n);
+  h.hY.fill(c[Histograms::kY].data(), n);
+  h.hZ.fill(c[Histograms::kZ].data(), n);
+  h.hT.fill(c[Histograms::kT].data(), n);
+  h.hTau.fill(c[Histograms::kTau].data(), n);
+  h.hEtaS.fill(c[Histograms::kEtaS].data(), n);
+  h.hXY.fill(c[Histograms::kX].data(), c[Histograms::kY].data(), n);
+  h.hTauVsEtaS.fill(c[Histograms::kEtaS].data(), c[Histograms::kTau].data(), n);
+
+  const Double_t b = event->b();
+  h.hImpactPar.fill(b);
+  h.hMult.fill(n);
+  h.hNpart.fill(event->npart());
+  h.hNcoll.fill(event->ncoll());
+  h.hMultVsImpactPar.fill(b, n);
+  h.hNpartVsImpactPar.fill(b, event->npart());
+  h.hNcollVsImpactPar.fill(b, event->ncoll());
+}
+
+//_________________
+void McDstQA::run() {
+  // Fill and write histograms
+  TStopwatch timer;
+  timer.Start();
+
+  McDstParallelReader reader(mInputFileName.Data(), mNThreads);
+  reader.setStatus("*", 0);
+  reader.setStatus("Event", 1);
+  reader.setStatus("Particle", 1);
+  reader.setMaxEntries(mMaxEvents);
+
+  // Every thread has its own histograms and its own copy of the cut
+  McHistReplicas<Histograms> histograms(Histograms(), reader.numberOfThreads());
+  std::vector<McDstCut> cuts;
+  if (mCut) {
+    cuts.assign(reader.numberOfThreads(), *mCut);
+  }
+
+  Long64_t nEvents = reader.process([&](UInt_t iSlot, McDstReader *r) {
+    fill(histograms[iSlot], mCut ? &cuts[iSlot] : nullptr, r);
+  });
+
+  write(histograms.merge(), nEvents);
+
+  timer.Stop();
+  std::cout << "McDstQA: " << nEvents << " events processed in "
+            << reader.numberOfThreads() << " threads, "
+            << timer.RealTime() << " s" << std::endl;
+}
+
+//_________________
+void McDstQA::write(TDirectory* dir, TObject* h) {
+  // Write histogram and delete it
+  dir->WriteTObject(h);
+  delete h;
+}
+
+//_________________
+void McDstQA::write(const Histograms& h, Long64_t nEvents) {
+  // Write histograms to the output file
+  TFile *oFile = TFile::Open(mOutputFileName.Data(), "RECREATE");
+  if (!oFile || oFile->IsZombie()) {
+    std::cout << "[ERROR] McDstQA: cannot create output file "
+              << mOutputFileName << std::endl;
+    delete oFile;
+    return;
+  }
+
+  TDirectory *dir = oFile->mkdir("event");
+  write(dir, h.hImpactPar.toTH1("hImpactPar", "Impact parameter;b (fm);Entries"));
+  write(dir, h.hMult.toTH1("hMult", "Multiplicity of accepted particles;N;Entries"));
+  write(dir, h.hNpart.toTH1("hNpart", "Number of participants;N_{part};Entries"));
+  write(dir, h.hNcoll.toTH1("hNcoll", "Number of binary collisions;N_{coll};Entries"));
+  write(dir, h.hMultVsImpactPar.toTH2("hMultVsImpactPar", "Multiplicity vs. impact parameter;b (fm);N"));
+  write(dir, h.hNpartVsImpactPar.toTH2("hNpartVsImpactPar", "N_{part} vs. impact parameter;b (fm);N_{part}"));
+  write(dir, h.hNcollVsImpactPar.toTH2("hNcollVsImpactPar", "N_{coll} vs. impact parameter;b (fm);N_{coll}"));
+
+  dir = oFile->mkdir("particle");
+  write(dir, h.hPt.toTH1("hPt", "Transverse momentum;p_{T} (GeV/c);Entries"));
+  write(dir, h.hEta.toTH1("hEta", "Pseudorapidity;#eta;Entries"));
+  write(dir, h.hRapidity.toTH1("hRapidity", "Rapidity;y;Entries"));
+  write(dir, h.hPhi.toTH1("hPhi", "Azimuthal angle;#phi (rad);Entries"));
+  write(dir, h.hPtVsEta.toTH2("hPtVsEta", "p_{T} vs. #eta;#eta;p_{T} (GeV/c)"));
+  write(dir, h.hPtVsRapidity.toTH2("hPtVsRapidity", "p_{T} vs. y;y;p_{T} (GeV/c)"));
+
+  // Species are written in the order of PDG codes
+  std::vector<Int_t> order(h.mPdg.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(),
+            [&h](Int_t a, Int_t b) { return h.mPdg[a] < h.mPdg[b]; });
+
+  TH1D *hAbundance = new TH1D("hAbundance", "Accepted particles per event;;dN/dEvent",
+                              order.size(), 0., order.size());
+  for (size_t i = 0; i < order.size(); ++i) {
+    const Int_t pdg = h.mPdg[order[i]];
+    const Species &s = h.mSpecies[order[i]];
+    TParticlePDG *p = TDatabasePDG::Instance()->GetParticle(pdg);
+    TString label = p ? TString(p->GetName()) : TString::Format("%d", pdg);
+    TString tag = TString::Format("%s%d", (pdg < 0) ? "m" : "", std::abs(pdg));
+
+    write(dir, s.hPt.toTH1(Form("hPt_%s", tag.Data()),
+                           Form("Transverse momentum of %s;p_{T} (GeV/c);Entries", label.Data())));
+    write(dir, s.hEta.toTH1(Form("hEta_%s", tag.Data()),
+                            Form("Pseudorapidity of %s;#eta;Entries", label.Data())));
+    write(dir, s.hRapidity.toTH1(Form("hRapidity_%s", tag.Data()),
+                                 Form("Rapidity of %s;y;Entries", label.Data())));
+    write(dir, s.hPhi.toTH1(Form("hPhi_%s", tag.Data()),
+                            Form("Azimuthal angle of %s;#phi (rad);Entries", label.Data())));
+
+    hAbundance->GetXaxis()->SetBinLabel(i + 1, label.Data());
+    hAbundance->SetBinContent(i + 1, s.hPt.entries());
+  }
+  if (nEvents > 0) {
+    hAbundance->Scale(1. / nEvents);
+  }
+  write(dir, hAbundance);
+
+  dir = oFile->mkdir("freezeout");
+  write(dir, h.hX.toTH1("hX", "Freeze-out x;x (fm);Entries"));
+  write(dir, h.hY.toTH1("hY", "Freeze-out y;y (fm);Entries"));
+  write(dir, h.hZ.toTH1("hZ", "Freeze-out z;z (fm);Entries"));
+  write(dir, h.hT.toTH1("hT", "Freeze-out time;t (fm/c);Entries"));
+  write(dir, h.hTau.toTH1("hTau", "Proper time;#tau (fm/c);Entries"));
+  write(dir, h.hEtaS.toTH1("hEtaS", "Space-time rapidity;#eta_{s};Entries"));
+  write(dir, h.hXY.toTH2("hXY", "Freeze-out y vs. x;x (fm);y (fm)"));
+  write(dir, h.hTauVsEtaS.toTH2("hTauVsEtaS", "Proper time vs. space-time rapidity;#eta_{s};#tau (fm/c)"));
+
+  oFile->Close();
+  delete oFile;
+  std::cout << "McDstQA: histograms are written to " << mOutputFileName << std::endl;
+}
@@ -0,0 +1,81 @@
+//
+// Warms up the next file of the chain in the background
+//
+
+// C++ headers
+#include <iostream>
+
+// ROOT headers
+#include "TFile.h"
+#include "TTree.h"
+#include "TBranch.h"
+#include "TDirectory.h"
+#include "TROOT.h"
+
+// McDst headers
+#include "McDstReadAhead.h"
+
+//_________________
+McDstReadAhead::McDstReadAhead() : mThread(), mBusy(kFALSE), mNFiles(0) {
+  // Default constructor. Files are warmed in a thread of their own
+  ROOT::EnableThreadSafety();
+}
+
+//_________________
+McDstReadAhead::~McDstReadAhead() {
+  // Destructor
+  if (mThread.joinable()) mThread.join();
+}
+
+//_________________
+Bool_t McDstReadAhead::warm(const TString& fileName, const TString& treeName,
+                            const std::vector<TString>& branches) {
+  // Start the background thread unless it is busy
+  if (mBusy) return kFALSE;
+  if (mThread.joinable()) mThread.join();
+  mBusy = kTRUE;
+  mThread = std::thread(&McDstReadAhead::run, this, fileName, treeName, branches);
+  return kTRUE;
+}
+
+//_________________
+void McDstReadAhead::run(TString fileName, TString treeName, std::vector<TString> branches) {
+  // Open the file, load the tree and read the baskets of the first cluster
+  TDirectory::TContext context;
+  TFile *file = TFile::Open(fileName.Data());
+  TTree *tree = (file && !file->IsZombie()) ?
+    dynamic_cast<TTree*>( file->Get(treeName.Data()) ) : nullptr;
+  if (tree) {
+    TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+    clusters();
+    const Long64_t clusterEnd = clusters.GetNextEntry();
+
+    // Positions and sizes of the baskets
+    std::vector<Long64_t> positions;
+    std::vector<Int_t> lengths;
+    for (size_t i = 0; i < branches.size(); ++i) {
+      TBranch *branch = tree->GetBranch(branches[i].Data());
+      if (!branch) continue;
+      const Long64_t *entries = branch->GetBasketEntry();
+      const Int_t *bytes = branch->GetBasketBytes();
+      const Long64_t *seeks = branch->GetBasketSeek();
+      for (Int_t iBasket = 0; iBasket < branch->GetWriteBasket(); ++iBasket) {
+        if (entries[iBasket] >= clusterEnd) break;
+        positions.push_back( seeks[iBasket] );
+        lengths.push_back( bytes[iBasket] );
+      }
+    }
+
+    // One vectored read. The buffers are only needed to fill the caches
+    if (!positions.empty()) {
+      Long64_t total = 0;
+      for (size_t i = 0; i < lengths.size(); ++i) total += lengths[i];
+      std::vector<Char_t> buffer(total);
+      file->ReadBuffers(buffer.data(), positions.data(), lengths.data(), positions.size());
+    }
+    ++mNFiles;
+  }
+  if (file) file->Close();
+  delete file;
+  mBusy = kFALSE;
+}
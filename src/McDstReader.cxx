@@ -8,6 +8,8 @@
 #include <iostream>
 #include <fstream>
 #include <assert.h>
+#include <algorithm>
+#include <cstdlib>
 
 // McDst headers
 #include "McDst.h"
@@ -16,14 +18,28 @@
 #include "McParticle.h"
 #include "McRun.h"
 #include "McArrays.h"
+#include "McDstColumns.h"
+#include "McDstSharedCache.h"
+#include "McDstStagingCache.h"
+#include "McDstReadAhead.h"
 
 // ROOT headers
 #include "TRegexp.h"
+#include "TFile.h"
+#include "TDirectory.h"
+#include "TMD5.h"
+#include "TSystem.h"
+#include "TROOT.h"
+#include "TTreeCacheUnzip.h"
 
 //_________________
 McDstReader::McDstReader(const Char_t* inFileName) :
   mMcDst(new McDst()), mMcRun(nullptr), mChain(nullptr), mTree(nullptr),
-  mEventCounter(0), mMcArrays{}, mStatusArrays{} {
+  mEventCounter(0), mMcArrays{}, mBranches{}, mStatusArrays{}, mFields(),
+  mDerived(new McDerivedColumns()), mSelectionOut(nullptr), mSelectionIn(nullptr),
+  mMemory(nullptr), mOwnMemory(kFALSE), mSharedCache(nullptr),
+  mStaging(nullptr), mStagingFiles(), mStagedEntries{}, mReadAhead(nullptr),
+  mReadAheadTree(-1) {
   // Constructor
   streamerOff();
   createArrays();
@@ -40,6 +56,12 @@ McDstReader::~McDstReader() {
   if(mMcDst) {
     delete mMcDst;
   }
+  delete mDerived;
+  delete mSelectionOut;
+  delete mSelectionIn;
+  releaseMemory();
+  delete mStaging;
+  delete mReadAhead;
 }
 
 //_________________
@@ -70,11 +92,24 @@ void McDstReader::setStatus(const Char_t *branchNameRegex, Int_t enable) {
   setBranchAddresses(mChain);
 }
 
+//_________________
+void McDstReader::setFields(Int_t arrayType, const std::vector<TString>& fields) {
+  // Select data members to read
+  if (arrayType < 0 || arrayType >= McArrays::NAllMcArrays) {
+    std::cout << "[WARNING] McDstReader::setFields: wrong array type "
+              << arrayType << std::endl;
+    return;
+  }
+  mFields[arrayType] = fields;
+  setBranchAddresses(mChain);
+}
+
 //_________________
 void McDstReader::setBranchAddresses(TChain *chain) {
   // Set addresses of branches listed in mcArrays
   if (!chain) return;
   chain->SetBranchStatus("*", 0);
+  std::fill_n(mBranches, McArrays::NAllMcArrays, nullptr);
   TString ts;
   for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
     if (mStatusArrays[i] == 0) continue;
@@ -88,10 +123,18 @@ void McDstReader::setBranchAddresses(TChain *chain) {
     ts = bname;
     ts += "*";
     chain->SetBranchStatus(ts, 1);
-    chain->SetBranchAddress(bname, mMcArrays + i);
+    if (!mFields[i].empty()) {
+      // Keep the array branch (and its size), read only selected members
+      chain->SetBranchStatus(Form("%s.*", bname), 0);
+      for (size_t iField = 0; iField < mFields[i].size(); ++iField) {
+        chain->SetBranchStatus(Form("%s.%s*", bname, mFields[i][iField].Data()), 1);
+      }
+    }
+    chain->SetBranchAddress(bname, mMcArrays + i, mBranches + i);
     assert(tb->GetAddress() == (char*)(mMcArrays + i));
   }
   mTree = mChain->GetTree();
+  updateCache();
 }
 
 //_________________
@@ -120,13 +163,119 @@ void McDstReader::Finish() {
 }
 
 //_________________
-void McDstReader::Init() {
-  // McDst initialization
-  if(!mChain) {
-    mChain = new TChain("McDst");
+void McDstReader::setStagingCache(const Char_t* directory, Long64_t maxBytes) {
+  // Files are staged when Init() is called
+  if (mChain) {
+    std::cout << "[WARNING] McDstReader::setStagingCache: must be called before Init()"
+              << std::endl;
+    return;
+  }
+  delete mStaging;
+  mStaging = new McDstStagingCache(directory, maxBytes);
+}
+
+//_________________
+Int_t McDstReader::treeNumber(Long64_t iEntry) const {
+  // Offsets are known for the trees loaded so far
+  const Int_t nTrees = mChain->GetNtrees();
+  const Long64_t *offset = mChain->GetTreeOffset();
+  return std::upper_bound(offset, offset + nTrees + 1, iEntry) - offset - 1;
+}
+
+//_________________
+void McDstReader::useStagedFile(Long64_t iEntry) {
+  // Nothing to do within the same file
+  if (iEntry >= mStagedEntries[0] && iEntry < mStagedEntries[1]) return;
+  const Int_t iTree = treeNumber(iEntry);
+  if (iTree < 0 || iTree >= mChain->GetNtrees() || iTree >= (Int_t)mStagingFiles.size()) return;
+  const Long64_t *offset = mChain->GetTreeOffset();
+  mStagedEntries[0] = offset[iTree];
+  mStagedEntries[1] = offset[iTree + 1];
+  if (iTree == mChain->GetTreeNumber()) return;
+
+  // The chain opens the file by the title of its element. The original
+  // name is restored, since selections refer to it
+  TNamed *element = (TNamed*)mChain->GetListOfFiles()->At(iTree);
+  element->SetTitle( mStaging->localFile(mStagingFiles[iTree]).Data() );
+  mChain->LoadTree(iEntry);
+  element->SetTitle( mStagingFiles[iTree].Data() );
+}
+
+//_________________
+void McDstReader::setParallelUnzip(Bool_t enable, UInt_t nThreads) {
+  // Unzipping tasks run in the implicit MT pool
+  if (enable && !ROOT::IsImplicitMTEnabled()) ROOT::EnableImplicitMT(nThreads);
+  TTreeCacheUnzip::SetParallelUnzip(enable ? TTreeCacheUnzip::kEnable : TTreeCacheUnzip::kDisable);
+  std::cout << "McDstReader: parallel unzipping is " << (enable ? "enabled" : "disabled");
+  if (enable) std::cout << " with " << ROOT::GetThreadPoolSize() << " threads";
+  std::cout << std::endl;
+
+  // The kind of the cache is chosen when it is created
+  if (mChain && mChain->GetCacheSize() > 0) {
+    const Long64_t cacheSize = mChain->GetCacheSize();
+    mChain->SetCacheSize(0);
+    mChain->SetCacheSize(cacheSize);
+    updateCache();
   }
+}
 
-  std::string const dirFile = mInputFileName.Data();
+//_________________
+void McDstReader::updateCache() {
+  // Disabled arrays and data members are neither read nor unzipped
+  if (!mChain || mChain->GetCacheSize() <= 0) return;
+  mChain->DropBranchFromCache("*", kTRUE);
+  for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
+    if (mStatusArrays[i] == 0) continue;
+    const Char_t *bname = McArrays::mcArrayNames[i];
+    if (mFields[i].empty()) {
+      mChain->AddBranchToCache(bname, kTRUE);
+      continue;
+    }
+    mChain->AddBranchToCache(bname);
+    for (size_t iField = 0; iField < mFields[i].size(); ++iField) {
+      mChain->AddBranchToCache(Form("%s.%s*", bname, mFields[i][iField].Data()), kTRUE);
+    }
+  }
+}
+
+//_________________
+void McDstReader::setReadAhead(Bool_t readAhead) {
+  // Create or remove the background reader
+  delete mReadAhead;
+  mReadAhead = readAhead ? new McDstReadAhead() : nullptr;
+  mReadAheadTree = -1;
+}
+
+//_________________
+void McDstReader::readAhead() {
+  // Branches that are read from the current tree
+  mReadAheadTree = mChain->GetTreeNumber();
+  TObjArray *files = mChain->GetListOfFiles();
+  if (mStaging || mReadAheadTree < 0 || mReadAheadTree + 1 >= files->GetEntriesFast()) return;
+
+  std::vector<TString> branches;
+  std::vector<TObjArray*> lists(1, mChain->GetTree()->GetListOfBranches());
+  while (!lists.empty()) {
+    TObjArray *list = lists.back();
+    lists.pop_back();
+    for (Int_t i = 0; i < list->GetEntriesFast(); ++i) {
+      TBranch *branch = (TBranch*)list->At(i);
+      if (branch->GetListOfBranches()->GetEntriesFast() > 0) {
+        lists.push_back(branch->GetListOfBranches());
+      }
+      if (mChain->GetBranchStatus(branch->GetName())) branches.push_back(branch->GetName());
+    }
+  }
+  mReadAhead->warm(files->At(mReadAheadTree + 1)->GetTitle(), mChain->GetName(), branches);
+}
+
+//_________________
+Int_t McDstReader::addFiles(TChain* chain, const Char_t* inFileName) {
+  // Add mcDst file or files from the list to the chain
+  if (!chain) return 0;
+
+  std::string const dirFile = inFileName;
+  Int_t nFile = 0;
 
   if( dirFile.find(".list") != std::string::npos ||
       dirFile.find(".lis") != std::string::npos ) {
@@ -137,14 +286,13 @@ void McDstReader::Init() {
       std::cout << "[ERROR] Cannot open list file " << dirFile << std::endl;
     }
 
-    Int_t nFile = 0;
     std::string file;
     while(getline(inputStream, file)) {
       if(file.find(".mcDst.root") != std::string::npos) {
         TFile* ftmp = TFile::Open(file.c_str());
         if(ftmp && !ftmp->IsZombie() && ftmp->GetNkeys()) {
           std::cout << " Read in mcDst file " << file << std::endl;
-          mChain->Add(file.c_str());
+          chain->Add(file.c_str());
           ++nFile;
         } //if(ftmp && !ftmp->IsZombie() && ftmp->GetNkeys())
 
@@ -157,23 +305,49 @@ void McDstReader::Init() {
     std::cout << " Total " << nFile << " files have been read in. " << std::endl;
   } //if(dirFile.find(".list") != std::string::npos || dirFile.find(".lis" != string::npos))
   else if(dirFile.find(".mcDst.root") != std::string::npos) {
-    mChain->Add( dirFile.c_str() );
+    chain->Add( dirFile.c_str() );
+    ++nFile;
   }
   else {
     std::cout << "[WARNING] No good input file to read ... " << std::endl;
   }
+  return nFile;
+}
+
+//_________________
+void McDstReader::Init() {
+  // McDst initialization
+  if(!mChain) {
+    mChain = new TChain("McDst");
+  }
+
+  addFiles(mChain, mInputFileName.Data());
+
+  if (mStaging) {
+    TIter next(mChain->GetListOfFiles());
+    while (TObject *element = next()) {
+      mStagingFiles.push_back(element->GetTitle());
+    }
+    // Tree offsets are needed to find the file of an entry
+    mChain->GetEntries();
+    mStaging->prefetch(mStagingFiles);
+  }
 
   if(mChain) {
     setBranchAddresses(mChain);
+    // Legacy macros can use parallel unzipping without changes
+    if (const Char_t *unzipThreads = gSystem->Getenv("MCDST_UNZIP_THREADS")) {
+      setParallelUnzip(kTRUE, std::max(0, atoi(unzipThreads)));
+    }
     mChain->SetCacheSize(50e6);
-    mChain->AddBranchToCache("*");
+    updateCache();
     mMcDst->set(mMcArrays);
     // mMcRun = (McRun*)mChain->GetFile()->Get("run");
   }
 }
 
 //_________________
-Bool_t McDstReader::loadEntry(Long64_t iEntry __attribute__((unused))) {
+Bool_t McDstReader::loadEntry(Long64_t iEntry) {
   // Read McDst entry
   Int_t mStatusRead = true; // true - okay, false - nothing to read
 
@@ -183,6 +357,22 @@ Bool_t McDstReader::loadEntry(Long64_t iEntry __attribute__((unused))) {
     return mStatusRead;
   }
 
+  if (mMemory) {
+    // Event from memory, nothing is read
+    if (iEntry < 0 || iEntry >= mMemory->numberOfEvents()) return false;
+    mMcArrays[McArrays::Event]->Clear();
+    McEvent *ev = new ((*mMcArrays[McArrays::Event])[0]) McEvent();
+    mMemory->fill(iEntry, ev, mMcArrays[McArrays::Particle]);
+    // Chain entry of the event, e.g. for acceptEntry()
+    mEventCounter = mMemory->chainEntry()[iEntry] + 1;
+    mDerived->reset(mMcArrays[McArrays::Particle]);
+    return true;
+  }
+
+  // Entries may be requested in any order, e.g. by several
+  // readers that process different ranges of the same chain
+  if (mStaging) useStagedFile(iEntry);
+  mEventCounter = iEntry;
   Int_t bytes = mChain->GetEntry(mEventCounter++);
   Int_t nCycles = 0;
   while( bytes <= 0) {
@@ -201,5 +391,361 @@ Bool_t McDstReader::loadEntry(Long64_t iEntry __attribute__((unused))) {
       break;
     }
   }
+  if (mReadAhead && mChain->GetTreeNumber() != mReadAheadTree) readAhead();
+  // Derived quantities of the previous entry are not valid anymore
+  mDerived->reset(mMcArrays[McArrays::Particle]);
   return mStatusRead;
 }
+
+//_________________
+Long64_t McDstReader::loadBatch(Long64_t first, Long64_t nEntries, McDstColumns& batch) {
+  // Read consecutive entries into the columnar batch
+  batch.clear();
+  if (mMemory) {
+    batch.append(*mMemory, first, first + nEntries);
+    return batch.numberOfEvents();
+  }
+  // Only the data members that are read are stored
+  batch.setParticleFields(mFields[McArrays::Particle]);
+  if (!mChain) {
+    std::cout << "[WARNING] No input files ... ! EXIT" << std::endl;
+    return 0;
+  }
+
+  const Long64_t last = std::min(first + nEntries, numberOfEntries());
+  for (Long64_t i = first; i < last; ++i) {
+    const Long64_t iEntry = entryNumber(i);
+    if (mStaging) useStagedFile(iEntry);
+    const Long64_t localEntry = mChain->LoadTree(iEntry);
+    if (localEntry < 0) {
+      std::cout << "[WARNING] McDstReader::loadBatch: cannot load entry "
+                << iEntry << std::endl;
+      break;
+    }
+    mEventCounter = iEntry + 1;
+    if (mReadAhead && mChain->GetTreeNumber() != mReadAheadTree) readAhead();
+
+    // Only the enabled arrays are read, the branch pointers are
+    // updated by the chain when a new tree is loaded
+    Int_t bytes = 0;
+    for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+      if (mStatusArrays[iArr] && mBranches[iArr]) {
+        bytes += mBranches[iArr]->GetEntry(localEntry);
+      }
+      else {
+        mMcArrays[iArr]->Clear();
+      }
+    }
+    if (bytes <= 0) {
+      std::cout << "[WARNING] Encountered invalid entry or I/O error while reading entry "
+                << iEntry << " from \"" << mChain->GetName() << "\" input tree\n";
+      continue;
+    }
+
+    batch.append(mMcArrays[McArrays::Event]->GetEntriesFast() > 0 ? event() : nullptr,
+                 mMcArrays[McArrays::Particle], iEntry);
+  }
+  mDerived->reset(mMcArrays[McArrays::Particle]);
+  return batch.numberOfEvents();
+}
+
+//_________________
+Long64_t McDstReader::numberOfEntries() const {
+  // Number of entries to process
+  if (mMemory) return mMemory->numberOfEvents();
+  if (!mChain) return 0;
+  return mSelectionIn ? mSelectionIn->GetN() : mChain->GetEntries();
+}
+
+//_________________
+void McDstReader::acceptEntry() {
+  // Add the current entry to the selection
+  if (!mChain || mEventCounter <= 0) return;
+  if (!mSelectionOut) {
+    mSelectionOut = new TEntryList("mcDstSelection", "Selected mcDst entries");
+    mSelectionOut->SetDirectory(nullptr);
+    // Tree offsets are needed also if the events in memory were read
+    // by another process (see loadToSharedMemory())
+    mChain->GetEntries();
+  }
+  // Entry is stored in the list of its tree under the name of the chain
+  // element, which is the original file also if the chain reads its
+  // local copy (see useStagedFile()). No tree is loaded
+  const Long64_t iEntry = mEventCounter - 1;
+  const Int_t iTree = treeNumber(iEntry);
+  const TObject *element = (iTree >= 0) ? mChain->GetListOfFiles()->At(iTree) : nullptr;
+  if (!element) return;
+  mSelectionOut->Enter(iEntry - mChain->GetTreeOffset()[iTree],
+                       mChain->GetName(), element->GetTitle());
+}
+
+//_________________
+void McDstReader::clearSelection() {
+  // Remove accepted entries
+  delete mSelectionOut;
+  mSelectionOut = nullptr;
+}
+
+//_________________
+Bool_t McDstReader::writeSelection(const Char_t* fileName, const Char_t* name) const {
+  // Write accepted entries
+  if (!mSelectionOut) {
+    std::cout << "[WARNING] McDstReader::writeSelection: no entries have been accepted"
+              << std::endl;
+    return kFALSE;
+  }
+
+  TDirectory::TContext context;
+  TFile *oFile = TFile::Open(fileName, "recreate");
+  if (!oFile || oFile->IsZombie()) {
+    std::cout << "[ERROR] McDstReader::writeSelection: cannot create file "
+              << fileName << std::endl;
+    delete oFile;
+    return kFALSE;
+  }
+  mSelectionOut->Write(name);
+  oFile->Close();
+  delete oFile;
+  std::cout << "McDstReader: " << mSelectionOut->GetN() << " entries written to "
+            << fileName << std::endl;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstReader::readSelection(const Char_t* fileName, const Char_t* name) {
+  // Read entry list and set it to the chain
+  if (!mChain) {
+    std::cout << "[ERROR] McDstReader::readSelection: Init() must be called first"
+              << std::endl;
+    return kFALSE;
+  }
+
+  TDirectory::TContext context;
+  TFile *iFile = TFile::Open(fileName);
+  if (!iFile || iFile->IsZombie()) {
+    std::cout << "[ERROR] McDstReader::readSelection: cannot open file "
+              << fileName << std::endl;
+    delete iFile;
+    return kFALSE;
+  }
+  TEntryList *list = dynamic_cast<TEntryList*>( iFile->Get(name) );
+  if (!list) {
+    std::cout << "[ERROR] McDstReader::readSelection: no entry list " << name
+              << " in " << fileName << std::endl;
+    iFile->Close();
+    delete iFile;
+    return kFALSE;
+  }
+  // The list must outlive the file
+  list->SetDirectory(nullptr);
+  iFile->Close();
+  delete iFile;
+
+  mChain->SetEntryList(list);
+  delete mSelectionIn;
+  mSelectionIn = list;
+  std::cout << "McDstReader: " << mSelectionIn->GetN() << " selected entries will be read"
+            << std::endl;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstReader::skipClusters(const McDstZoneMap::Cut& cut) {
+  // Entry list with the entries of the clusters that may pass the cut
+  if (!mChain) {
+    std::cout << "[ERROR] McDstReader::skipClusters: Init() must be called first"
+              << std::endl;
+    return kFALSE;
+  }
+
+  TDirectory::TContext context;
+  TEntryList *list = new TEntryList("mcDstSelection", "Entries of the selected clusters");
+  list->SetDirectory(nullptr);
+  Int_t nZones = 0;
+  Int_t nSkipped = 0;
+  TIter next(mChain->GetListOfFiles());
+  while (TObject *element = next()) {
+    const Char_t *fileName = element->GetTitle();
+    McDstZoneMap zoneMap;
+    Bool_t hasZones = kFALSE;
+    Long64_t nEntries = 0;
+    TFile *iFile = TFile::Open(fileName);
+    if (iFile && !iFile->IsZombie()) {
+      hasZones = zoneMap.read(iFile);
+      TTree *tree = dynamic_cast<TTree*>( iFile->Get(mChain->GetName()) );
+      if (tree) nEntries = tree->GetEntries();
+      iFile->Close();
+    }
+    delete iFile;
+
+    // Entry ranges of the clusters to read
+    std::vector< std::pair<Long64_t, Long64_t> > ranges;
+    if (!hasZones) {
+      std::cout << "[WARNING] McDstReader::skipClusters: no zone map in " << fileName
+                << ", all entries will be read" << std::endl;
+    }
+    else if (!zoneMap.covers(nEntries)) {
+      // E.g. zone maps of several files concatenated by hadd
+      std::cout << "[WARNING] McDstReader::skipClusters: zone map of " << fileName
+                << " does not match the tree, all entries will be read" << std::endl;
+      hasZones = kFALSE;
+    }
+    if (hasZones) {
+      for (Int_t iZone = 0; iZone < zoneMap.numberOfZones(); ++iZone) {
+        const McDstZoneMap::Zone &zone = zoneMap.zones()[iZone];
+        ++nZones;
+        if (cut.mayMatch(zone)) ranges.push_back( std::make_pair(zone.firstEntry, zone.lastEntry) );
+        else ++nSkipped;
+      }
+    }
+    else {
+      ranges.push_back( std::make_pair(0LL, nEntries) );
+    }
+
+    TEntryList *selected = mSelectionIn ?
+      mSelectionIn->GetEntryList(mChain->GetName(), fileName) : nullptr;
+    if (mSelectionIn && !selected) continue;
+    TEntryList fileList("", "", mChain->GetName(), fileName);
+    for (size_t iRange = 0; iRange < ranges.size(); ++iRange) {
+      for (Long64_t iEntry = ranges[iRange].first; iEntry < ranges[iRange].second; ++iEntry) {
+        if (!selected || selected->Contains(iEntry)) fileList.Enter(iEntry);
+      }
+    }
+    list->Add(&fileList);
+  }
+
+  mChain->SetEntryList(list);
+  delete mSelectionIn;
+  mSelectionIn = list;
+  std::cout << "McDstReader: " << nSkipped << " of " << nZones << " clusters skipped, "
+            << mSelectionIn->GetN() << " entries will be read" << std::endl;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstReader::loadToMemory(Long64_t maxBytes) {
+  // Read all entries to process into memory
+  releaseMemory();
+  if (!mChain) {
+    std::cout << "[ERROR] McDstReader::loadToMemory: Init() must be called first"
+              << std::endl;
+    return kFALSE;
+  }
+
+  McDstColumns *memory = new McDstColumns();
+  memory->setParticleFields(mFields[McArrays::Particle]);
+  McDstColumns batch;
+  const Long64_t nEntries = numberOfEntries();
+  const Long64_t batchSize = 1000;
+  for (Long64_t first = 0; first < nEntries; first += batchSize) {
+    loadBatch(first, batchSize, batch);
+    memory->append(batch, 0, batch.numberOfEvents());
+    if (maxBytes > 0 && memory->bytes() > maxBytes) {
+      std::cout << "[WARNING] McDstReader::loadToMemory: data do not fit into "
+                << maxBytes / 1048576. << " MB after " << memory->numberOfEvents()
+                << " events, entries will be read from files" << std::endl;
+      delete memory;
+      return kFALSE;
+    }
+  }
+  memory->shrink();
+
+  mMemory = memory;
+  mOwnMemory = kTRUE;
+  std::cout << "McDstReader: " << mMemory->numberOfEvents() << " events with "
+            << mMemory->numberOfParticles() << " particles are in memory, "
+            << mMemory->bytes() / 1048576. << " MB" << std::endl;
+  return kTRUE;
+}
+
+//_________________
+void McDstReader::setMemory(const McDstColumns* memory) {
+  // Use events of another reader
+  releaseMemory();
+  mMemory = memory;
+  mOwnMemory = kFALSE;
+}
+
+//_________________
+void McDstReader::releaseMemory() {
+  // Release events in memory
+  if (mOwnMemory) delete mMemory;
+  mMemory = nullptr;
+  mOwnMemory = kFALSE;
+  delete mSharedCache;
+  mSharedCache = nullptr;
+}
+
+//_________________
+TString McDstReader::sharedCacheKey() const {
+  // Files (with sizes and modification times), arrays, data members and selection
+  TString description;
+  TIter next(mChain->GetListOfFiles());
+  while (TObject *element = next()) {
+    const Char_t *fileName = element->GetTitle();
+    FileStat_t stat;
+    description += fileName;
+    if (gSystem->GetPathInfo(fileName, stat) == 0) {
+      description += Form(" %lld %ld", (Long64_t)stat.fSize, stat.fMtime);
+    }
+    description += "\n";
+  }
+  for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+    description += Form("%s %d", McArrays::mcArrayNames[iArr], (Int_t)mStatusArrays[iArr]);
+    for (size_t iField = 0; iField < mFields[iArr].size(); ++iField) {
+      description += " " + mFields[iArr][iField];
+    }
+    description += "\n";
+  }
+
+  TMD5 md5;
+  md5.Update((const UChar_t*)description.Data(), description.Length());
+  if (mSelectionIn) {
+    const Long64_t nEntries = mSelectionIn->GetN();
+    for (Long64_t i = 0; i < nEntries; ++i) {
+      const Long64_t entry = mChain->GetEntryNumber(i);
+      md5.Update((const UChar_t*)&entry, sizeof(entry));
+    }
+  }
+  md5.Final();
+  return md5.AsString();
+}
+
+//_________________
+Bool_t McDstReader::loadToSharedMemory(Long64_t maxBytes, const Char_t* directory) {
+  // Attach the shared cache or fill it
+  releaseMemory();
+  if (!mChain) {
+    std::cout << "[ERROR] McDstReader::loadToSharedMemory: Init() must be called first"
+              << std::endl;
+    return kFALSE;
+  }
+
+  McDstSharedCache *cache = new McDstSharedCache(sharedCacheKey().Data(), directory);
+  if (!cache->attach()) {
+    // Only one process reads the files, the others wait and attach
+    if (!cache->lock()) {
+      std::cout << "[WARNING] McDstReader::loadToSharedMemory: cannot lock the cache, "
+                << "events are kept in the memory of this process" << std::endl;
+      delete cache;
+      return loadToMemory(maxBytes);
+    }
+    if (!cache->attach()) {
+      if (!loadToMemory(maxBytes)) {
+        delete cache;
+        return kFALSE;
+      }
+      const Bool_t stored = cache->store(*mMemory);
+      if (!stored) {
+        std::cout << "[WARNING] McDstReader::loadToSharedMemory: events are kept "
+                  << "in the memory of this process" << std::endl;
+        delete cache;
+        return kTRUE;
+      }
+    }
+    cache->unlock();
+  }
+  setMemory(cache->columns());
+  mSharedCache = cache;
+  return kTRUE;
+}
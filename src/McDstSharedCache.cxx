@@ -0,0 +1,169 @@
+//
+// Decoded mcDst events shared between processes via shared memory
+//
+
+// C++ headers
+#include <iostream>
+#include <cerrno>
+#include <cstring>
+
+// POSIX headers
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+// McDst headers
+#include "McDstSharedCache.h"
+#include "McDstCacheDirectory.h"
+
+//_________________
+McDstSharedCache::McDstSharedCache(const Char_t* key, const Char_t* directory) :
+  mDirectory(directory), mFileName(Form("%s/mcdst_%s.cache", directory, key)),
+  mLockFileName(Form("%s/mcdst_%s.cache.lock", directory, key)), mMaxTotalBytes(0),
+  mFd(-1), mLockFd(-1), mAddress(nullptr), mSize(0), mColumns() {
+  // Constructor
+  struct statvfs fs;
+  if (statvfs(directory, &fs) == 0) {
+    mMaxTotalBytes = (Long64_t)fs.f_blocks * fs.f_frsize / 2;
+  }
+}
+
+//_________________
+McDstSharedCache::~McDstSharedCache() {
+  // Destructor
+  detach();
+  unlock();
+}
+
+//_________________
+Bool_t McDstSharedCache::lock() {
+  // Exclusive lock of the lock file
+  if (mLockFd >= 0) return kTRUE;
+  mLockFd = open(mLockFileName.Data(), O_RDONLY | O_CREAT, 0666);
+  if (mLockFd < 0) {
+    std::cout << "[ERROR] McDstSharedCache::lock: cannot open " << mLockFileName
+              << ": " << std::strerror(errno) << std::endl;
+    return kFALSE;
+  }
+  // Processes of other users lock the same file, the umask is bypassed
+  fchmod(mLockFd, 0666);
+  if (flock(mLockFd, LOCK_EX) != 0) {
+    std::cout << "[ERROR] McDstSharedCache::lock: cannot lock " << mLockFileName
+              << ": " << std::strerror(errno) << std::endl;
+    close(mLockFd);
+    mLockFd = -1;
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+//_________________
+void McDstSharedCache::unlock() {
+  // Release the lock file
+  if (mLockFd < 0) return;
+  flock(mLockFd, LOCK_UN);
+  close(mLockFd);
+  mLockFd = -1;
+}
+
+//_________________
+Bool_t McDstSharedCache::attach() {
+  // Map the cache file read-only
+  if (isAttached()) return kTRUE;
+  mFd = open(mFileName.Data(), O_RDONLY);
+  if (mFd < 0) return kFALSE;
+
+  // Shared lock is held while the cache is in use
+  struct stat st;
+  if (flock(mFd, LOCK_SH) != 0 || fstat(mFd, &st) != 0 || st.st_size <= 0) {
+    detach();
+    return kFALSE;
+  }
+  mSize = st.st_size;
+  mAddress = mmap(nullptr, mSize, PROT_READ, MAP_SHARED, mFd, 0);
+  if (mAddress == MAP_FAILED) {
+    std::cout << "[ERROR] McDstSharedCache::attach: cannot map " << mFileName
+              << ": " << std::strerror(errno) << std::endl;
+    mAddress = nullptr;
+    detach();
+    return kFALSE;
+  }
+  if (!mColumns.attach(mAddress, mSize)) {
+    detach();
+    return kFALSE;
+  }
+
+  // Modification time marks the last use
+  futimens(mFd, nullptr);
+  std::cout << "McDstSharedCache: " << mColumns.numberOfEvents() << " events, "
+            << mSize / 1048576. << " MB attached from " << mFileName << std::endl;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstSharedCache::store(const McDstColumns& columns) {
+  // Write the columns to a temporary file and rename it
+  detach();
+  const Long64_t size = columns.serializedSize();
+  if (mMaxTotalBytes > 0) {
+    if (size > mMaxTotalBytes) {
+      std::cout << "[WARNING] McDstSharedCache::store: " << size / 1048576.
+                << " MB exceed the cache limit" << std::endl;
+      return kFALSE;
+    }
+    evict(mDirectory.Data(), mMaxTotalBytes - size);
+  }
+
+  TString tmpFileName = Form("%s.%d.tmp", mFileName.Data(), (Int_t)getpid());
+  Int_t fd = open(tmpFileName.Data(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0) {
+    std::cout << "[ERROR] McDstSharedCache::store: cannot create " << tmpFileName
+              << ": " << std::strerror(errno) << std::endl;
+    return kFALSE;
+  }
+  // Processes of other users update the modification time when they attach
+  fchmod(fd, 0666);
+  // Space is allocated first: writing to a mapped tmpfs without space is fatal
+  Int_t status = posix_fallocate(fd, 0, size);
+  void *address = (status == 0) ?
+    mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+  if (address == MAP_FAILED) {
+    std::cout << "[ERROR] McDstSharedCache::store: cannot write " << size / 1048576.
+              << " MB to " << tmpFileName << ": "
+              << std::strerror(status ? status : errno) << std::endl;
+    close(fd);
+    unlink(tmpFileName.Data());
+    return kFALSE;
+  }
+  columns.serialize(address);
+  munmap(address, size);
+  close(fd);
+
+  if (rename(tmpFileName.Data(), mFileName.Data()) != 0) {
+    std::cout << "[ERROR] McDstSharedCache::store: cannot rename " << tmpFileName
+              << ": " << std::strerror(errno) << std::endl;
+    unlink(tmpFileName.Data());
+    return kFALSE;
+  }
+  return attach();
+}
+
+//_________________
+void McDstSharedCache::detach() {
+  // Unmap and release the shared lock
+  mColumns.clear();
+  if (mAddress) munmap(mAddress, mSize);
+  mAddress = nullptr;
+  mSize = 0;
+  if (mFd >= 0) close(mFd);
+  mFd = -1;
+}
+
+//_________________
+Long64_t McDstSharedCache::evict(const Char_t* directory, Long64_t maxBytes) {
+  // Caches not attached by any process
+  return McDstCacheDirectory::evict(directory, ".cache", maxBytes);
+}
@@ -0,0 +1,193 @@
+//
+// Local copies of the input files staged in the background
+//
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+// POSIX headers
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <sys/statvfs.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+// ROOT headers
+#include "TFile.h"
+#include "TMD5.h"
+#include "TROOT.h"
+#include "TSystem.h"
+
+// McDst headers
+#include "McDstStagingCache.h"
+#include "McDstCacheDirectory.h"
+
+//_________________
+McDstStagingCache::McDstStagingCache(const Char_t* directory, Long64_t maxBytes) :
+  mDirectory(directory), mMaxBytes(maxBytes), mFilesAhead(2), mFiles(), mNext(0),
+  mCurrent(0), mStatus(), mFd(-1), mThread(), mMutex(), mCondition(), mStop(kFALSE) {
+  // Constructor
+  gSystem->mkdir(directory, kTRUE);
+  struct statvfs fs;
+  if (mMaxBytes <= 0 && statvfs(directory, &fs) == 0) {
+    mMaxBytes = (Long64_t)fs.f_blocks * fs.f_frsize / 2;
+  }
+}
+
+//_________________
+McDstStagingCache::~McDstStagingCache() {
+  // Destructor
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = kTRUE;
+  }
+  mCondition.notify_all();
+  if (mThread.joinable()) mThread.join();
+  if (mFd >= 0) close(mFd);
+}
+
+//_________________
+TString McDstStagingCache::stagedName(const TString& file) const {
+  // Hash of the path, size and modification time
+  TString description = file;
+  FileStat_t stat;
+  if (gSystem->GetPathInfo(file.Data(), stat) == 0) {
+    description += Form(" %lld %ld", (Long64_t)stat.fSize, stat.fMtime);
+  }
+  TMD5 md5;
+  md5.Update((const UChar_t*)description.Data(), description.Length());
+  md5.Final();
+  return Form("%s/mcdst_%s_%s", mDirectory.Data(), md5.AsString(),
+              gSystem->BaseName(file.Data()));
+}
+
+//_________________
+void McDstStagingCache::prefetch(const std::vector<TString>& files) {
+  // Start the background thread
+  if (mThread.joinable()) {
+    std::cout << "[WARNING] McDstStagingCache::prefetch: files are already being staged"
+              << std::endl;
+    return;
+  }
+  mFiles = files;
+  mNext = 0;
+  mCurrent = 0;
+  for (size_t i = 0; i < mFiles.size(); ++i) mStatus[mFiles[i]] = kQueued;
+  // The copying thread runs TFile::Cp next to the event loop
+  ROOT::EnableThreadSafety();
+  mThread = std::thread(&McDstStagingCache::run, this);
+}
+
+//_________________
+void McDstStagingCache::run() {
+  // Copy files in order, not too far ahead of the one being read
+  for (;;) {
+    TString file;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mCondition.wait(lock, [this] {
+          return mStop || mNext >= mFiles.size() ||
+            mNext <= mCurrent + (size_t)std::max(mFilesAhead, 0); });
+      if (mStop || mNext >= mFiles.size()) return;
+      file = mFiles[mNext++];
+      mStatus[file] = kCopying;
+    }
+    const Bool_t staged = stage(file);
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mStatus[file] = staged ? kStaged : kFailed;
+    }
+    mCondition.notify_all();
+  }
+}
+
+//_________________
+Bool_t McDstStagingCache::stage(const TString& file) {
+  // Copy the file to a temporary name and rename it
+  const TString local = stagedName(file);
+  const TString lockName = local + ".lock";
+  // Jobs of other users lock the same file: flock needs no write access,
+  // and the umask is bypassed for the file created here
+  Int_t lockFd = open(lockName.Data(), O_RDONLY | O_CREAT, 0666);
+  if (lockFd >= 0) fchmod(lockFd, 0666);
+  if (lockFd < 0 || flock(lockFd, LOCK_EX) != 0) {
+    std::cout << "[WARNING] McDstStagingCache: cannot lock " << lockName << ": "
+              << std::strerror(errno) << std::endl;
+    if (lockFd >= 0) close(lockFd);
+    return kFALSE;
+  }
+
+  // Another job may have copied it already
+  Bool_t staged = (access(local.Data(), R_OK) == 0);
+  if (staged) {
+    // Fails only for copies of other users that are not writable by all
+    // (staged by older versions); they are then evicted earlier
+    utimes(local.Data(), nullptr);
+  }
+  else {
+    FileStat_t stat;
+    const Long64_t size = (gSystem->GetPathInfo(file.Data(), stat) == 0) ? stat.fSize : 0;
+    if (size > mMaxBytes) {
+      std::cout << "[WARNING] McDstStagingCache: " << file
+                << " is larger than the cache, it is read directly" << std::endl;
+    }
+    else {
+      evict(mMaxBytes - size);
+      const TString tmpName = Form("%s.%d.tmp", local.Data(), (Int_t)getpid());
+      staged = TFile::Cp(file.Data(), tmpName.Data(), kFALSE);
+      // Jobs of other users update the modification time of the copy
+      if (staged && chmod(tmpName.Data(), 0666) != 0) {
+        std::cout << "[WARNING] McDstStagingCache: cannot share " << tmpName << ": "
+                  << std::strerror(errno) << std::endl;
+      }
+      staged = staged && rename(tmpName.Data(), local.Data()) == 0;
+      if (!staged) {
+        std::cout << "[WARNING] McDstStagingCache: cannot copy " << file << " to "
+                  << mDirectory << ", it is read directly" << std::endl;
+        unlink(tmpName.Data());
+      }
+    }
+  }
+  flock(lockFd, LOCK_UN);
+  close(lockFd);
+  return staged;
+}
+
+//_________________
+TString McDstStagingCache::localFile(const TString& file) {
+  // Local copy if staged
+  {
+    std::unique_lock<std::mutex> lock(mMutex);
+    std::vector<TString>::const_iterator it = std::find(mFiles.begin(), mFiles.end(), file);
+    if (it != mFiles.end()) mCurrent = it - mFiles.begin();
+    mCondition.notify_all();
+    // Waiting for the copy in progress is faster than reading the file twice
+    mCondition.wait(lock, [this, &file] {
+        std::map<TString, Int_t>::const_iterator st = mStatus.find(file);
+        return st == mStatus.end() || st->second != kCopying; });
+  }
+
+  // Copies are used also if they were staged by another job
+  const TString local = stagedName(file);
+  Int_t fd = open(local.Data(), O_RDONLY);
+  if (fd >= 0 && flock(fd, LOCK_SH) == 0) {
+    if (mFd >= 0) close(mFd);
+    mFd = fd;
+    // Modification time marks the last use (see utimes() in stage())
+    futimens(fd, nullptr);
+    std::cout << "McDstStagingCache: reading " << local << std::endl;
+    return local;
+  }
+  if (fd >= 0) close(fd);
+  return file;
+}
+
+//_________________
+Long64_t McDstStagingCache::evict(Long64_t maxBytes) const {
+  // Copies not being read by any job
+  return McDstCacheDirectory::evict(mDirectory.Data(), ".root", maxBytes);
+}
@@ -0,0 +1,72 @@
+//
+// Base class of analysis tasks run by McDstTrain
+//
+
+// C++ headers
+#include <algorithm>
+
+// McDst headers
+#include "McDstTask.h"
+
+//_________________
+McDstTask::McDstTask(const Char_t* name) : mName(name), mUsage{}, mFields() {
+  // Constructor
+}
+
+//_________________
+McDstTask::~McDstTask() {
+  // Destructor
+}
+
+//_________________
+void McDstTask::addField(Int_t arrayType, const Char_t* field) {
+  // Declare data member
+  if (mUsage[arrayType] == kAllFields) return;
+  mUsage[arrayType] = kFields;
+  if (std::find(mFields[arrayType].begin(), mFields[arrayType].end(), field) ==
+      mFields[arrayType].end()) {
+    mFields[arrayType].push_back(field);
+  }
+}
+
+//_________________
+void McDstTask::addAllFields(Int_t arrayType) {
+  // Declare all data members
+  mUsage[arrayType] = kAllFields;
+  mFields[arrayType].clear();
+}
+
+//_________________
+void McDstTask::skipArray(Int_t arrayType) {
+  // Declare that the array is not read
+  mUsage[arrayType] = kSkip;
+  mFields[arrayType].clear();
+}
+
+//_________________
+Bool_t McDstTask::usesArray(Int_t arrayType) const {
+  // Undeclared arrays are read, unless other arrays are declared
+  if (mUsage[arrayType] != kUndeclared) {
+    return mUsage[arrayType] != kSkip;
+  }
+  for (Int_t i = 0; i < McArrays::NAllMcArrays; ++i) {
+    if (mUsage[i] != kUndeclared) return kFALSE;
+  }
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstTask::usesAllFields(Int_t arrayType) const {
+  // All members are read if none is declared
+  return usesArray(arrayType) && mUsage[arrayType] != kFields;
+}
+
+//_________________
+void McDstTask::init(UInt_t nSlots __attribute__((unused))) {
+  // Nothing to prepare by default
+}
+
+//_________________
+void McDstTask::finish() {
+  // Nothing to finish by default
+}
@@ -0,0 +1,111 @@
+//
+// Runs several analysis tasks in one pass over mcDst files
+//
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+
+// ROOT headers
+#include "TStopwatch.h"
+
+// McDst headers
+#include "McArrays.h"
+#include "McDstReader.h"
+#include "McDstParallelReader.h"
+#include "McDstTask.h"
+#include "McDstTrain.h"
+
+//_________________
+McDstTrain::McDstTrain(const Char_t* inFileName, UInt_t nThreads) :
+  mInputFileName(inFileName), mNThreads(nThreads), mMaxEvents(-1), mTasks(),
+  mSelectionInput(), mSelectionOutput() {
+  // Constructor
+}
+
+//_________________
+McDstTrain::~McDstTrain() {
+  // Destructor
+}
+
+//_________________
+void McDstTrain::addTask(McDstTask* task) {
+  // Add task
+  if (!task) return;
+  mTasks.push_back(task);
+}
+
+//_________________
+Long64_t McDstTrain::run() {
+  // Run all tasks
+  if (mTasks.empty()) {
+    std::cout << "[WARNING] McDstTrain::run: no tasks have been added" << std::endl;
+    return 0;
+  }
+
+  TStopwatch timer;
+  timer.Start();
+
+  McDstParallelReader reader(mInputFileName.Data(), mNThreads);
+  reader.setMaxEntries(mMaxEvents);
+  if (!mSelectionInput.IsNull()) reader.readSelection(mSelectionInput.Data());
+  for (size_t iTask = 0; iTask < mTasks.size(); ++iTask) {
+    mTasks[iTask]->init(reader.numberOfThreads());
+  }
+
+  // Union of the arrays and data members of all tasks
+  reader.setStatus("*", 0);
+  for (Int_t iArr = 0; iArr < McArrays::NAllMcArrays; ++iArr) {
+    Bool_t used = kFALSE;
+    Bool_t allFields = kFALSE;
+    std::vector<TString> fields;
+    for (size_t iTask = 0; iTask < mTasks.size(); ++iTask) {
+      const McDstTask *task = mTasks[iTask];
+      if (!task->usesArray(iArr)) continue;
+      used = kTRUE;
+      if (task->usesAllFields(iArr)) {
+        allFields = kTRUE;
+        continue;
+      }
+      for (size_t i = 0; i < task->fields(iArr).size(); ++i) {
+        const TString &field = task->fields(iArr)[i];
+        if (std::find(fields.begin(), fields.end(), field) == fields.end()) {
+          fields.push_back(field);
+        }
+      }
+    }
+
+    std::cout << "McDstTrain: " << McArrays::mcArrayNames[iArr] << ": ";
+    if (!used) {
+      std::cout << "not read" << std::endl;
+      continue;
+    }
+    if (allFields) {
+      fields.clear();
+      std::cout << "all members";
+    }
+    for (size_t i = 0; i < fields.size(); ++i) {
+      std::cout << fields[i] << " ";
+    }
+    std::cout << std::endl;
+    reader.setStatus(McArrays::mcArrayNames[iArr], 1);
+    reader.setFields(iArr, fields);
+  }
+
+  Long64_t nEvents = reader.process([this](UInt_t iSlot, McDstReader *r) {
+    for (size_t iTask = 0; iTask < mTasks.size(); ++iTask) {
+      mTasks[iTask]->process(iSlot, r);
+    }
+  });
+
+  for (size_t iTask = 0; iTask < mTasks.size(); ++iTask) {
+    mTasks[iTask]->finish();
+  }
+  if (!mSelectionOutput.IsNull()) reader.writeSelection(mSelectionOutput.Data());
+
+  timer.Stop();
+  std::cout << "McDstTrain: " << mTasks.size() << " tasks processed "
+            << nEvents << " events in " << reader.numberOfThreads()
+            << " threads, " << timer.RealTime() << " s" << std::endl;
+  return nEvents;
+}
@@ -0,0 +1,144 @@
+//
+// Per-cluster statistics (zone map) of the McEvent fields
+//
+
+// C++ headers
+#include <iostream>
+#include <algorithm>
+
+// ROOT headers
+#include "TTree.h"
+#include "TBranch.h"
+#include "TBranchElement.h"
+#include "TDirectory.h"
+
+// McDst headers
+#include "McDstZoneMap.h"
+
+//_________________
+Bool_t McDstZoneMap::build(TTree* tree) {
+  // Read McEvent members and array sizes cluster by cluster
+  mZones.clear();
+  if (!tree) return kFALSE;
+  TBranchElement *eventBranch = dynamic_cast<TBranchElement*>( tree->GetBranch("Event") );
+  if (!eventBranch || !tree->GetBranch("Particle")) {
+    std::cout << "[ERROR] McDstZoneMap::build: " << tree->GetName()
+              << " is not a McDst tree" << std::endl;
+    return kFALSE;
+  }
+
+  // Members are read directly into arrays as in the MakeClass mode
+  const Int_t capacity = std::max(1, eventBranch->GetMaximum());
+  std::vector<Float_t> b(capacity);
+  std::vector<UInt_t> eventNr(capacity);
+  std::vector<UShort_t> stepNr(capacity);
+  Int_t nEvents = 0;
+  Int_t nParticles = 0;
+  TBranch *branches[5] = {};
+  tree->SetMakeClass(1);
+  tree->SetBranchStatus("*", 0);
+  const Char_t *names[5] = { "Event", "Particle", "Event.fB", "Event.fEventNr", "Event.fStepNr" };
+  void *addresses[5] = { &nEvents, &nParticles, b.data(), eventNr.data(), stepNr.data() };
+  for (Int_t i = 0; i < 5; ++i) {
+    tree->SetBranchStatus(names[i], 1);
+    tree->SetBranchAddress(names[i], addresses[i], branches + i);
+  }
+
+  const Long64_t nEntries = tree->GetEntries();
+  TTree::TClusterIterator clusters = tree->GetClusterIterator(0);
+  Long64_t first = 0;
+  while ((first = clusters()) < nEntries) {
+    Zone zone;
+    zone.firstEntry = first;
+    zone.lastEntry = std::min(clusters.GetNextEntry(), nEntries);
+    zone.bMin = std::numeric_limits<Float_t>::max();
+    zone.bMax = -std::numeric_limits<Float_t>::max();
+    zone.multMin = std::numeric_limits<Int_t>::max();
+    zone.multMax = 0;
+    zone.eventNrMin = std::numeric_limits<UInt_t>::max();
+    zone.eventNrMax = 0;
+    zone.stepNrMin = std::numeric_limits<UShort_t>::max();
+    zone.stepNrMax = 0;
+    for (Long64_t iEntry = zone.firstEntry; iEntry < zone.lastEntry; ++iEntry) {
+      for (Int_t i = 0; i < 5; ++i) {
+        if (branches[i]) branches[i]->GetEntry(iEntry);
+      }
+      zone.multMin = std::min(zone.multMin, nParticles);
+      zone.multMax = std::max(zone.multMax, nParticles);
+      if (nEvents <= 0) continue;
+      zone.bMin = std::min(zone.bMin, b[0]);
+      zone.bMax = std::max(zone.bMax, b[0]);
+      zone.eventNrMin = std::min(zone.eventNrMin, eventNr[0]);
+      zone.eventNrMax = std::max(zone.eventNrMax, eventNr[0]);
+      zone.stepNrMin = std::min(zone.stepNrMin, stepNr[0]);
+      zone.stepNrMax = std::max(zone.stepNrMax, stepNr[0]);
+    }
+    mZones.push_back(zone);
+  }
+
+  tree->ResetBranchAddresses();
+  tree->SetMakeClass(0);
+  tree->SetBranchStatus("*", 1);
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstZoneMap::write(TDirectory* dir) const {
+  // One entry per zone
+  if (!dir) return kFALSE;
+  TDirectory::TContext context(dir);
+  TTree tree(treeName(), "Cluster statistics of the McDst tree");
+  Zone zone;
+  tree.Branch("firstEntry", &zone.firstEntry, "firstEntry/L");
+  tree.Branch("lastEntry", &zone.lastEntry, "lastEntry/L");
+  tree.Branch("bMin", &zone.bMin, "bMin/F");
+  tree.Branch("bMax", &zone.bMax, "bMax/F");
+  tree.Branch("multMin", &zone.multMin, "multMin/I");
+  tree.Branch("multMax", &zone.multMax, "multMax/I");
+  tree.Branch("eventNrMin", &zone.eventNrMin, "eventNrMin/i");
+  tree.Branch("eventNrMax", &zone.eventNrMax, "eventNrMax/i");
+  tree.Branch("stepNrMin", &zone.stepNrMin, "stepNrMin/s");
+  tree.Branch("stepNrMax", &zone.stepNrMax, "stepNrMax/s");
+  for (size_t i = 0; i < mZones.size(); ++i) {
+    zone = mZones[i];
+    tree.Fill();
+  }
+  return tree.Write(treeName(), TObject::kOverwrite) > 0;
+}
+
+//_________________
+Bool_t McDstZoneMap::read(TDirectory* dir) {
+  // Read zones from the tree
+  mZones.clear();
+  TTree *tree = dir ? dynamic_cast<TTree*>( dir->Get(treeName()) ) : nullptr;
+  if (!tree) return kFALSE;
+  Zone zone;
+  tree->SetBranchAddress("firstEntry", &zone.firstEntry);
+  tree->SetBranchAddress("lastEntry", &zone.lastEntry);
+  tree->SetBranchAddress("bMin", &zone.bMin);
+  tree->SetBranchAddress("bMax", &zone.bMax);
+  tree->SetBranchAddress("multMin", &zone.multMin);
+  tree->SetBranchAddress("multMax", &zone.multMax);
+  tree->SetBranchAddress("eventNrMin", &zone.eventNrMin);
+  tree->SetBranchAddress("eventNrMax", &zone.eventNrMax);
+  tree->SetBranchAddress("stepNrMin", &zone.stepNrMin);
+  tree->SetBranchAddress("stepNrMax", &zone.stepNrMax);
+  const Long64_t nZones = tree->GetEntries();
+  for (Long64_t i = 0; i < nZones; ++i) {
+    tree->GetEntry(i);
+    mZones.push_back(zone);
+  }
+  delete tree;
+  return kTRUE;
+}
+
+//_________________
+Bool_t McDstZoneMap::covers(Long64_t nEntries) const {
+  // Zones must follow each other from the first to the last entry
+  Long64_t next = 0;
+  for (size_t i = 0; i < mZones.size(); ++i) {
+    if (mZones[i].firstEntry != next || mZones[i].lastEntry <= next) return kFALSE;
+    next = mZones[i].lastEntry;
+  }
+  return next == nEntries;
+}
@@ -0,0 +1,114 @@
+//
+// Fixed-binning histograms over flat arrays
+//
+
+// C++ headers
+#include <iostream>
+
+// ROOT headers
+#include "TH1.h"
+#include "TH2.h"
+#include "TH3.h"
+
+// McDst headers
+#include "McHist.h"
+
+//_________________
+void McHistBase::reset() {
+  // Reset contents
+  std::fill(mSumw.begin(), mSumw.end(), 0.);
+  mSumw2.clear();
+  mEntries = 0;
+}
+
+//_________________
+void McHistBase::addBase(const McHistBase& hist) {
+  // Add contents
+  if (hist.mSumw.size() != mSumw.size()) {
+    std::cout << "[ERROR] McHistBase::add: histograms have different binning" << std::endl;
+    return;
+  }
+  if (hist.isWeighted() && !isWeighted()) {
+    setWeighted();
+  }
+  const size_t n = mSumw.size();
+  for (size_t i = 0; i < n; ++i) {
+    mSumw[i] += hist.mSumw[i];
+  }
+  if (isWeighted()) {
+    const std::vector<Double_t> &sumw2 = hist.isWeighted() ? hist.mSumw2 : hist.mSumw;
+    for (size_t i = 0; i < n; ++i) {
+      mSumw2[i] += sumw2[i];
+    }
+  }
+  mEntries += hist.mEntries;
+}
+
+//_________________
+void McHistBase::copyTo(TH1* h, Double_t* array) const {
+  // Both use the same global bin numbering
+  std::copy(mSumw.begin(), mSumw.end(), array);
+  if (isWeighted()) {
+    h->Sumw2();
+    std::copy(mSumw2.begin(), mSumw2.end(), h->GetSumw2()->GetArray());
+  }
+  // Statistics are recalculated from the bin contents
+  h->ResetStats();
+  h->SetEntries(mEntries);
+}
+
+//_________________
+void McHist1D::add(const McHist1D& hist) {
+  // Add histogram
+  if (!(hist.mX == mX)) {
+    std::cout << "[ERROR] McHist1D::add: histograms have different binning" << std::endl;
+    return;
+  }
+  addBase(hist);
+}
+
+//_________________
+TH1D* McHist1D::toTH1(const Char_t* name, const Char_t* title) const {
+  // Create ROOT histogram
+  TH1D *h = new TH1D(name, title, mX.nBins(), mX.min(), mX.max());
+  copyTo(h, h->GetArray());
+  return h;
+}
+
+//_________________
+void McHist2D::add(const McHist2D& hist) {
+  // Add histogram
+  if (!(hist.mX == mX) || !(hist.mY == mY)) {
+    std::cout << "[ERROR] McHist2D::add: histograms have different binning" << std::endl;
+    return;
+  }
+  addBase(hist);
+}
+
+//_________________
+TH2D* McHist2D::toTH2(const Char_t* name, const Char_t* title) const {
+  // Create ROOT histogram
+  TH2D *h = new TH2D(name, title, mX.nBins(), mX.min(), mX.max(),
+                     mY.nBins(), mY.min(), mY.max());
+  copyTo(h, h->GetArray());
+  return h;
+}
+
+//_________________
+void McHist3D::add(const McHist3D& hist) {
+  // Add histogram
+  if (!(hist.mX == mX) || !(hist.mY == mY) || !(hist.mZ == mZ)) {
+    std::cout << "[ERROR] McHist3D::add: histograms have different binning" << std::endl;
+    return;
+  }
+  addBase(hist);
+}
+
+//_________________
+TH3D* McHist3D::toTH3(const Char_t* name, const Char_t* title) const {
+  // Create ROOT histogram
+  TH3D *h = new TH3D(name, title, mX.nBins(), mX.min(), mX.max(),
+                     mY.nBins(), mY.min(), mY.max(), mZ.nBins(), mZ.min(), mZ.max());
+  copyTo(h, h->GetArray());
+  return h;
+}
@@ -0,0 +1,142 @@
+//
+// Set of histograms booked for every particle species
+//
+
+// C++ headers
+#include <iostream>
+#include <mutex>
+
+// ROOT headers
+#include "TDirectory.h"
+
+// McDst headers
+#include "McHistogramBank.h"
+
+namespace {
+  // Cloning goes through ROOT global state (dictionaries, directories)
+  std::mutex gBookMutex;
+}
+
+//_________________
+McHistogramBank::McHistogramBank() :
+  mDense(2 * kDenseRange, -1), mSparse(), mPdg(), mLabels(),
+  mTemplates(), mOwnTemplates(kTRUE), mHistograms() {
+  // Default constructor
+}
+
+//_________________
+McHistogramBank::McHistogramBank(const McHistogramBank& bank) :
+  mDense(bank.mDense), mSparse(bank.mSparse), mPdg(bank.mPdg),
+  mLabels(bank.mLabels), mTemplates(bank.mTemplates), mOwnTemplates(kFALSE),
+  mHistograms(bank.mHistograms.size(), nullptr) {
+  // Replica shares templates of the original bank
+}
+
+//_________________
+McHistogramBank::~McHistogramBank() {
+  // Destructor
+  clear();
+  if (mOwnTemplates) {
+    for (size_t i = 0; i < mTemplates.size(); ++i) {
+      delete mTemplates[i];
+    }
+  }
+}
+
+//_________________
+Int_t McHistogramBank::addSpecies(Int_t pdg, const Char_t* label) {
+  // Add species
+  Int_t i = index(pdg);
+  if (i >= 0) {
+    std::cout << "[WARNING] McHistogramBank::addSpecies: species " << pdg
+              << " is already in the bank" << std::endl;
+    return i;
+  }
+  i = mPdg.size();
+  if (pdg > -kDenseRange && pdg < kDenseRange) {
+    mDense[pdg + kDenseRange] = i;
+  }
+  else {
+    mSparse[pdg] = i;
+  }
+  mPdg.push_back(pdg);
+  mLabels.push_back(label);
+  clear();
+  mHistograms.assign(mPdg.size() * mTemplates.size(), nullptr);
+  return i;
+}
+
+//_________________
+Int_t McHistogramBank::addHistogram(TH1* hTemplate) {
+  // Add histogram template
+  hTemplate->SetDirectory(nullptr);
+  mTemplates.push_back(hTemplate);
+  clear();
+  mHistograms.assign(mPdg.size() * mTemplates.size(), nullptr);
+  return mTemplates.size() - 1;
+}
+
+//_________________
+void McHistogramBank::book(Int_t index) {
+  // Clone templates for the species
+  std::lock_guard<std::mutex> lock(gBookMutex);
+  const size_t nHist = mTemplates.size();
+  for (size_t i = 0; i < nHist; ++i) {
+    TH1 *hTemplate = mTemplates[i];
+    TString title = hTemplate->GetTitle();
+    title.ReplaceAll("%s", mLabels[index]);
+    TH1 *h = (TH1*)hTemplate->Clone(Form("%s_%d", hTemplate->GetName(), index));
+    h->SetDirectory(nullptr);
+    h->SetTitle(title);
+    mHistograms[index * nHist + i] = h;
+  }
+}
+
+//_________________
+void McHistogramBank::clear() {
+  // Delete booked histograms
+  for (size_t i = 0; i < mHistograms.size(); ++i) {
+    delete mHistograms[i];
+    mHistograms[i] = nullptr;
+  }
+}
+
+//_________________
+void McHistogramBank::merge(const McHistogramBank& bank) {
+  // Add histograms of another bank
+  if (bank.mPdg != mPdg || bank.mTemplates.size() != mTemplates.size()) {
+    std::cout << "[ERROR] McHistogramBank::merge: banks have different species or histograms"
+              << std::endl;
+    return;
+  }
+  const size_t nHist = mTemplates.size();
+  for (Int_t iSpecies = 0; iSpecies < numberOfSpecies(); ++iSpecies) {
+    if (!bank.isBooked(iSpecies)) continue;
+    TH1 **h = histograms(iSpecies);
+    for (size_t i = 0; i < nHist; ++i) {
+      h[i]->Add(bank.mHistograms[iSpecies * nHist + i]);
+    }
+  }
+}
+
+//_________________
+void McHistogramBank::scale(Int_t iHist, Double_t factor) {
+  // Scale histogram of all booked species
+  for (Int_t iSpecies = 0; iSpecies < numberOfSpecies(); ++iSpecies) {
+    if (!isBooked(iSpecies)) continue;
+    mHistograms[iSpecies * mTemplates.size() + iHist]->Scale(factor);
+  }
+}
+
+//_________________
+void McHistogramBank::write(TDirectory* dir) const {
+  // Write booked histograms
+  if (!dir) dir = gDirectory;
+  const size_t nHist = mTemplates.size();
+  for (size_t i = 0; i < nHist; ++i) {
+    for (Int_t iSpecies = 0; iSpecies < numberOfSpecies(); ++iSpecies) {
+      if (!isBooked(iSpecies)) continue;
+      dir->WriteTObject(mHistograms[iSpecies * nHist + i]);
+    }
+  }
+}
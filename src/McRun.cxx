@@ -7,6 +7,7 @@
 
 // ROOT headers
 #include "TMath.h"
+#include "TCollection.h"
 
 // McDst headers
 #include "McRun.h"
@@ -109,6 +110,49 @@ void McRun::Print( Option_t* option __attribute__((unused)) ) const {
             << "--------------------------------------------------" << std::endl;
 }
 
+//_________________
+Bool_t McRun::isCompatible(const McRun& other) const {
+  // Compare collision setup
+  return ( fGenerator == other.fGenerator &&
+           fAProj == other.fAProj && fZProj == other.fZProj &&
+           fATarg == other.fATarg && fZTarg == other.fZTarg &&
+           TMath::Abs( fPProj - other.fPProj ) <= 1e-5 * TMath::Abs( fPProj ) &&
+           TMath::Abs( fPTarg - other.fPTarg ) <= 1e-5 * TMath::Abs( fPTarg ) );
+}
+
+//_________________
+Long64_t McRun::Merge(TCollection* list) {
+  // Merge run headers
+  if ( !list ) return fNEvents;
+
+  Double_t nEvents = fNEvents;
+  Double_t xSection = Double_t(fXSection) * fNEvents;
+  TIter next(list);
+  TObject *obj = nullptr;
+  while ( ( obj = next() ) ) {
+    McRun *run = dynamic_cast<McRun*>(obj);
+    if ( !run ) {
+      std::cout << "Warning:: McRun::Merge: cannot merge with " << obj->ClassName()
+                << std::endl;
+      continue;
+    }
+    if ( !isCompatible( *run ) ) {
+      std::cout << "Warning:: McRun::Merge: merging run headers with different "
+                << "collision setup (" << fGenerator << " vs. " << run->fGenerator
+                << "). Parameters of the first one are kept" << std::endl;
+    }
+    nEvents += run->fNEvents;
+    xSection += Double_t(run->fXSection) * run->fNEvents;
+  }
+
+  if ( nEvents > 0 ) {
+    fXSection = (Float_t)( xSection / nEvents );
+  }
+  fNEvents = ( ( nEvents > std::numeric_limits<unsigned int>::max() ) ?
+               std::numeric_limits<unsigned int>::max() : (UInt_t)nEvents );
+  return (Long64_t)fNEvents;
+}
+
 //_________________
 Double_t McRun::projectileEnergy() const {
   // Get the projectile energy
@@ -0,0 +1,314 @@
+/*
+  mcdst-merge merges many mcDst files into one.
+
+  The McDst trees are merged with TFileMerger. When the compression
+  settings of an input file are the same as for the output file the
+  compressed baskets are copied without decompression (fast cloning).
+  Run headers are merged with McRun::Merge, i.e. the numbers of events
+  are summed up. Zone maps (McDstZoneMap) of the inputs are not merged,
+  since their entry ranges refer to the input trees; with --zone-map
+  the zone map of the output is built instead.
+
+  For long lists the inputs can be split into several contiguous groups
+  that are merged by parallel worker processes into temporary files,
+  which are then fast-merged into the output. The order of the events
+  is the order of the input files in both cases.
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+// fork/waitpid
+#include <sys/types.h>
+#include <sys/wait.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ROOT headers
+#include "TFile.h"
+#include "TFileMerger.h"
+#include "TTree.h"
+#include "TSystem.h"
+#include "TString.h"
+
+// McDst headers
+#include "McRun.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McDstZoneMap.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-merge.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-merge"
+#define VERSION "1.0"
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "ofname", .has_arg = 1, .flag = 0, .val = 'o' },
+  { .name = "input-list", .has_arg = 1, .flag = 0, .val = 'f' },
+  { .name = "jobs", .has_arg = 1, .flag = 0, .val = 'j' },
+  { .name = "compression", .has_arg = 1, .flag = 0, .val = 'c' },
+  { .name = "zone-map", .has_arg = 0, .flag = 0, .val = 'z' },
+  { .name = "verbose", .has_arg = 0, .flag = 0, .val = 'v' },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " merges mcDst files\n"                       \
+    "Usage: " PROGNAME " [Options] -o <output> [input files]\n"         \
+    "Options:\n\
+    -h, --help                        help\n\
+    -o, --ofname <filename>           output file\n\
+    -f, --input-list <filename>       file with one input file per line\n\
+    -j, --jobs <number of jobs>       number of parallel merge subtrees (default: 1)\n\
+    -c, --compression <settings>      compression settings of the output, algorithm*100+level\n\
+                                      (default: the ones of the first input file)\n\
+    -z, --zone-map                    build the zone map of the output\n\
+    -v, --verbose                     print merger messages\n\
+Baskets are copied without recompression from inputs that have the same\n\
+compression settings as the output.\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+/*
+  Merge inputs to the output file ofname. Return true on success.
+*/
+bool
+merge_files(const std::vector<std::string> &inputs, const std::string &ofname,
+            int compression, bool verbose)
+{
+  // Fast cloning is possible only if the baskets need no recompression.
+  std::size_t nslow = 0;
+  std::size_t nzones = 0;
+  for (std::vector<std::string>::const_iterator it = inputs.begin(); it != inputs.end(); ++it)
+  {
+    TFile *file = TFile::Open(it->c_str(), "READ");
+    if (!file || file->IsZombie())
+    {
+      ERR(0, "cannot open %s", it->c_str());
+      delete file;
+      return false;
+    }
+    if (file->GetCompressionSettings() != compression)
+      ++nslow;
+    if (file->Get(McDstZoneMap::treeName()))
+      ++nzones;
+    file->Close();
+    delete file;
+  }
+  if (nslow > 0)
+    std::cout << PROGNAME ": " << nslow << " of " << inputs.size()
+              << " files have different compression settings, baskets are recompressed"
+              << std::endl;
+  if (nzones > 0)
+    std::cout << PROGNAME ": zone maps of " << nzones << " files are dropped" << std::endl;
+
+  TFileMerger merger(kFALSE, kFALSE);
+  merger.SetMsgPrefix(PROGNAME);
+  merger.SetPrintLevel(verbose ? 1 : 0);
+  merger.SetFastMethod(nslow == 0);
+  if (!merger.OutputFile(ofname.c_str(), "RECREATE", compression))
+  {
+    ERR(0, "cannot create %s", ofname.c_str());
+    return false;
+  }
+  for (std::vector<std::string>::const_iterator it = inputs.begin(); it != inputs.end(); ++it)
+  {
+    if (!merger.AddFile(it->c_str(), verbose))
+    {
+      ERR(0, "cannot add %s", it->c_str());
+      return false;
+    }
+  }
+  // Concatenated zone maps would not match the entries of the output.
+  merger.AddObjectNames(McDstZoneMap::treeName());
+  return merger.PartialMerge(TFileMerger::kAll | TFileMerger::kRegular | TFileMerger::kSkipListed);
+}
+
+/*
+  Build the zone map of the merged file. Return true on success.
+*/
+bool
+write_zone_map(const std::string &fname)
+{
+  TFile *file = TFile::Open(fname.c_str(), "UPDATE");
+  if (!file || file->IsZombie())
+  {
+    ERR(0, "cannot open %s", fname.c_str());
+    delete file;
+    return false;
+  }
+  TTree *tree = dynamic_cast<TTree*>(file->Get("McDst"));
+  McDstZoneMap zones;
+  bool ok = tree && zones.build(tree) && zones.write(file);
+  if (ok)
+    std::cout << PROGNAME ": zone map of " << zones.numberOfZones() << " clusters written" << std::endl;
+  file->Close();
+  delete file;
+  return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "ho:f:j:c:zv"; // This string must be sync with a struct option array.
+  int opt;
+  std::string ofname;
+  int njobs = 1;
+  int compression = -1;
+  bool zoneMap = false;
+  bool verbose = false;
+  std::vector<std::string> inputs;
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'f':
+    {
+      std::ifstream flist(optarg);
+      if (!flist)
+        ERR(1, "cannot open input list %s", optarg);
+      std::string line;
+      while (std::getline(flist, line))
+      {
+        if (!line.empty() && line[0] != '#')
+          inputs.push_back(line);
+      }
+      break;
+    }
+    case 'j':
+      njobs = std::stoi(optarg);
+      break;
+    case 'c':
+      compression = std::stoi(optarg);
+      break;
+    case 'z':
+      zoneMap = true;
+      break;
+    case 'v':
+      verbose = true;
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  for (int i = optind; i < argc; ++i)
+    inputs.push_back(argv[i]);
+  if (ofname.empty())
+    ERR(1, "no output file is given");
+  if (inputs.empty())
+    ERR(1, "no input files are given");
+
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+
+  // Use compression of the first file by default.
+  if (compression < 0)
+  {
+    TFile *file = TFile::Open(inputs.front().c_str(), "READ");
+    if (!file || file->IsZombie())
+      ERR(1, "cannot open %s", inputs.front().c_str());
+    compression = file->GetCompressionSettings();
+    file->Close();
+    delete file;
+  }
+
+  // Do not make subtrees with less than two files.
+  if (njobs > (int)inputs.size() / 2)
+    njobs = inputs.size() / 2;
+  if (njobs <= 1)
+  {
+    if (!merge_files(inputs, ofname, compression, verbose))
+      ERR(1, "merging failed");
+    if (zoneMap && !write_zone_map(ofname))
+      ERR(1, "cannot write zone map of %s", ofname.c_str());
+    std::cout << PROGNAME ": " << inputs.size() << " files merged to " << ofname << std::endl;
+    return EXIT_SUCCESS;
+  }
+
+  // Merge contiguous groups in worker processes.
+  std::vector<std::string> parts;
+  std::vector<pid_t> pids;
+  std::cout.flush();
+  for (int k = 0; k < njobs; ++k)
+  {
+    std::size_t first = inputs.size() * k / njobs;
+    std::size_t last = inputs.size() * (k + 1) / njobs;
+    parts.push_back(ofname + ".part" + std::to_string(k) + ".root");
+    pid_t pid = fork();
+    if (pid < 0)
+      ERR(1, "cannot fork");
+    if (pid == 0)
+    {
+      std::vector<std::string> group(inputs.begin() + first, inputs.begin() + last);
+      bool ok = merge_files(group, parts.back(), compression, verbose);
+      std::cout.flush();
+      fflush(NULL);
+      _exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+    }
+    pids.push_back(pid);
+  }
+
+  bool ok = true;
+  for (std::size_t k = 0; k < pids.size(); ++k)
+  {
+    int wstatus = 0;
+    if (waitpid(pids[k], &wstatus, 0) < 0 || !WIFEXITED(wstatus) ||
+        WEXITSTATUS(wstatus) != EXIT_SUCCESS)
+    {
+      ERR(0, "merging of subtree %d failed", (int)k);
+      ok = false;
+    }
+  }
+
+  // Parts have the output compression, so this step is a fast clone.
+  if (ok)
+    ok = merge_files(parts, ofname, compression, verbose);
+  for (std::size_t k = 0; k < parts.size(); ++k)
+    gSystem->Unlink(parts[k].c_str());
+  if (!ok)
+    ERR(1, "merging failed");
+  if (zoneMap && !write_zone_map(ofname))
+    ERR(1, "cannot write zone map of %s", ofname.c_str());
+
+  std::cout << PROGNAME ": " << inputs.size() << " files merged to " << ofname
+            << " in " << njobs << " subtrees" << std::endl;
+  return EXIT_SUCCESS;
+}
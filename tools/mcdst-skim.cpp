@@ -0,0 +1,363 @@
+/*
+  mcdst-skim writes a reduced mcDst with the selected events and particles.
+
+  Particles are selected with McDstCut (pT, eta, PDG codes). Events are
+  selected by the impact parameter and by the number of selected
+  particles. Particle indices of the output are the positions in the
+  output event; parent, parent decay, mate, decay and children indices
+  are remapped accordingly and set to -1 if the referenced particle was
+  not selected. Children keep the range of the selected ones.
+
+  The run header of the output is the merged run header of the inputs,
+  its comment records the skim selection and the number of events is
+  the number of selected events.
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <limits>
+#include <cstdint>
+
+// ROOT headers
+#include "TFile.h"
+#include "TTree.h"
+#include "TChain.h"
+#include "TList.h"
+#include "TClonesArray.h"
+#include "TLorentzVector.h"
+#include "Compression.h"
+
+// McDst headers
+#include "McDstReader.h"
+#include "McDst.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McRun.h"
+#include "McArrays.h"
+#include "McDstCut.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-skim.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-skim"
+#define VERSION "1.0"
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "ifname", .has_arg = 1, .flag = 0, .val = 'i' },
+  { .name = "ofname", .has_arg = 1, .flag = 0, .val = 'o' },
+  { .name = "events", .has_arg = 1, .flag = 0, .val = 'e' },
+  { .name = "b-min", .has_arg = 1, .flag = 0, .val = 0xFF01 },
+  { .name = "b-max", .has_arg = 1, .flag = 0, .val = 0xFF02 },
+  { .name = "mult-min", .has_arg = 1, .flag = 0, .val = 0xFF03 },
+  { .name = "mult-max", .has_arg = 1, .flag = 0, .val = 0xFF04 },
+  { .name = "pt-min", .has_arg = 1, .flag = 0, .val = 0xFF05 },
+  { .name = "pt-max", .has_arg = 1, .flag = 0, .val = 0xFF06 },
+  { .name = "eta-min", .has_arg = 1, .flag = 0, .val = 0xFF07 },
+  { .name = "eta-max", .has_arg = 1, .flag = 0, .val = 0xFF08 },
+  { .name = "pdg", .has_arg = 1, .flag = 0, .val = 0xFF09 },
+  { .name = "exclude-pdg", .has_arg = 1, .flag = 0, .val = 0xFF0A },
+  { .name = "compression", .has_arg = 1, .flag = 0, .val = 'c' },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " writes selected events and particles to a new mcDst\n" \
+    "Usage: " PROGNAME " [Options]\n"                                   \
+    "Options:\n\
+    -h, --help                        help\n\
+    -i, --ifname <filename>           input .mcDst.root file or a .list of them\n\
+    -o, --ofname <filename>           output file\n\
+    -e, --events <number of events>   number of input events to process\n\
+    -c, --compression <settings>      compression settings, algorithm*100+level\n\
+                                      (default: LZMA with the default level)\n\
+Event selection:\n\
+    --b-min <b>, --b-max <b>          impact parameter range (fm)\n\
+    --mult-min <n>, --mult-max <n>    range of the number of selected particles\n\
+Particle selection:\n\
+    --pt-min <pt>, --pt-max <pt>      transverse momentum range (GeV/c)\n\
+    --eta-min <eta>, --eta-max <eta>  pseudorapidity range\n\
+    --pdg <code>                      keep only particles with this PDG code (repeatable)\n\
+    --exclude-pdg <code>              drop particles with this PDG code (repeatable)\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+/*
+  Return new index of the particle that had index old, or -1.
+*/
+static inline int
+new_index(const std::vector<int> &newIdx, int old)
+{
+  return (old >= 0 && (std::size_t)old < newIdx.size()) ? newIdx[old] : -1;
+}
+
+/*
+  Read and merge run headers of all files in the chain. Return 0 if
+  there are none.
+*/
+McRun*
+merged_run(TChain *chain)
+{
+  McRun *run = 0;
+  TList others;
+  TObjArray *files = chain->GetListOfFiles();
+  for (Int_t i = 0; i < files->GetEntriesFast(); ++i)
+  {
+    TFile *file = TFile::Open(files->At(i)->GetTitle(), "READ");
+    if (!file || file->IsZombie())
+    {
+      delete file;
+      continue;
+    }
+    McRun *fileRun = (McRun*)file->Get("run");
+    if (fileRun)
+    {
+      if (!run)
+        run = fileRun;
+      else
+        others.Add(fileRun);
+    }
+    file->Close();
+    delete file;
+  }
+  if (run)
+    run->Merge(&others);
+  others.Delete();
+  return run;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hi:o:e:c:"; // This string must be sync with a struct option array.
+  int opt;
+  const char *ifname = 0;
+  const char *ofname = 0;
+  Long64_t nev = std::numeric_limits<Long64_t>::max();
+  int compression = ROOT::kLZMA * 100 + ROOT::RCompressionSetting::ELevel::kDefaultLZMA;
+  double bMin = -std::numeric_limits<double>::infinity();
+  double bMax = std::numeric_limits<double>::infinity();
+  long multMin = 0;
+  long multMax = std::numeric_limits<long>::max();
+  McDstCut cut;
+  // Text of the selection for the run header.
+  std::ostringstream selection;
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'i':
+      ifname = optarg;
+      break;
+    case 'o':
+      ofname = optarg;
+      break;
+    case 'e':
+      nev = std::stoll(optarg);
+      break;
+    case 'c':
+      compression = std::stoi(optarg);
+      break;
+    case 0xFF01:
+      bMin = std::stod(optarg);
+      selection << " b>=" << optarg;
+      break;
+    case 0xFF02:
+      bMax = std::stod(optarg);
+      selection << " b<=" << optarg;
+      break;
+    case 0xFF03:
+      multMin = std::stol(optarg);
+      selection << " mult>=" << optarg;
+      break;
+    case 0xFF04:
+      multMax = std::stol(optarg);
+      selection << " mult<=" << optarg;
+      break;
+    case 0xFF05:
+      cut.setPtLow(std::stof(optarg));
+      selection << " pt>" << optarg;
+      break;
+    case 0xFF06:
+      cut.setPtHigh(std::stof(optarg));
+      selection << " pt<" << optarg;
+      break;
+    case 0xFF07:
+      cut.setEtaLow(std::stof(optarg));
+      selection << " eta>" << optarg;
+      break;
+    case 0xFF08:
+      cut.setEtaHigh(std::stof(optarg));
+      selection << " eta<" << optarg;
+      break;
+    case 0xFF09:
+      cut.includePdg(std::stoi(optarg));
+      selection << " pdg=" << optarg;
+      break;
+    case 0xFF0A:
+      cut.excludePdg(std::stoi(optarg));
+      selection << " pdg!=" << optarg;
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  if (!ifname || !ofname)
+    ERR(1, "input and output files must be given");
+
+  McDstReader reader(ifname);
+  reader.Init();
+  if (!reader.chain())
+    ERR(1, "cannot read %s", ifname);
+  Long64_t nentries = reader.chain()->GetEntries();
+  if (nentries > nev)
+    nentries = nev;
+  McRun *run = merged_run(reader.chain());
+
+  // Output
+  TFile *ofile = new TFile(ofname, "RECREATE", "", compression);
+  if (!ofile || ofile->IsZombie())
+    ERR(1, "cannot create %s", ofname);
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+  TTree *tree = new TTree("McDst", "Skimmed McDst tree");
+  tree->SetAutoSave(-(4 << 20));
+  TClonesArray *mcArrays[McArrays::NAllMcArrays];
+  for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+  {
+    mcArrays[i] = new TClonesArray(McArrays::mcArrayTypes[i], McArrays::mcArraySizes[i]);
+    tree->Branch(McArrays::mcArrayNames[i], &mcArrays[i]);
+  }
+
+  // Event loop
+  std::vector<int> newIdx;
+  std::vector<UInt_t> selected;
+  Long64_t nread = 0, nselected = 0, nparticles = 0;
+  for (Long64_t iEntry = 0; iEntry < nentries; ++iEntry)
+  {
+    if (!reader.loadEntry(iEntry))
+      break;
+    ++nread;
+
+    McEvent *event = McDst::event();
+    if (!event || event->b() < bMin || event->b() > bMax)
+      continue;
+
+    // Select particles and assign new indices.
+    UInt_t npart = McDst::numberOfParticles();
+    selected.clear();
+    newIdx.clear();
+    TLorentzVector mom;
+    for (UInt_t i = 0; i < npart; ++i)
+    {
+      McParticle *particle = McDst::particle(i);
+      particle->momentum(mom);
+      int index = particle->index();
+      if (index >= 0 && (std::size_t)index >= newIdx.size())
+        newIdx.resize(index + 1, -1);
+      if (!cut.isGoodParticle(mom, particle->pdg()))
+        continue;
+      if (index >= 0)
+        newIdx[index] = selected.size();
+      selected.push_back(i);
+    }
+    if ((long)selected.size() < multMin || (long)selected.size() > multMax)
+      continue;
+
+    // Fill output event.
+    for (int i = 0; i < McArrays::NAllMcArrays; mcArrays[i++]->Clear());
+    TClonesArray *evCol = mcArrays[McArrays::Event];
+    new ((*evCol)[0]) McEvent(*event);
+    TClonesArray *trkCol = mcArrays[McArrays::Particle];
+    for (std::size_t k = 0; k < selected.size(); ++k)
+    {
+      McParticle *particle = new ((*trkCol)[k]) McParticle(*McDst::particle(selected[k]));
+      particle->setIndex(k);
+      particle->setParent(new_index(newIdx, particle->parent()));
+      particle->setParentDecay(new_index(newIdx, particle->parentDecay()));
+      particle->setMate(new_index(newIdx, particle->mate()));
+      particle->setDecay(new_index(newIdx, particle->decay()));
+
+      // Children: the first and the last selected particle of the range.
+      int first = -1, last = -1;
+      if (particle->firstChild() >= 0)
+      {
+        int hi = (particle->lastChild() >= particle->firstChild()) ?
+          particle->lastChild() : particle->firstChild();
+        for (int old = particle->firstChild(); old <= hi; ++old)
+        {
+          int idx = new_index(newIdx, old);
+          if (idx < 0)
+            continue;
+          if (first < 0)
+            first = idx;
+          last = idx;
+        }
+      }
+      particle->setFirstChild(first);
+      particle->setLastChild(last);
+    }
+    tree->Fill();
+    ++nselected;
+    nparticles += selected.size();
+  }
+  reader.Finish();
+
+  // Derived run header
+  ofile->cd();
+  std::ostringstream comment;
+  if (run)
+  {
+    TString origComment;
+    run->comment(origComment);
+    comment << origComment << "\n";
+  }
+  comment << PROGNAME ": " << nselected << " of " << nread << " events from " << ifname
+          << ", selection:" << (selection.str().empty() ? " none" : selection.str());
+  if (!run)
+    run = new McRun("", "", 0, 0, 0., 0, 0, 0., 0., 0., 0, 0., 0., 0., 0);
+  run->setComment(comment.str().c_str());
+  run->setNEvents(nselected);
+  run->Write();
+  ofile->Write();
+  ofile->Close();
+
+  std::cout << PROGNAME ": " << nselected << " of " << nread << " events, "
+            << nparticles << " particles written to " << ofname << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,379 @@
+/*
+  mcdst-split rewrites a dataset into N files of about the same size.
+
+  The inputs (a .list of mcDst files or the files themselves) are
+  treated as one sequence of events that is cut into N parts of equal
+  compressed size (default) or equal number of entries. All events are
+  rewritten, so all outputs have the same cluster size (--cluster-size).
+  With --fast-clone the input files that go to an output as a whole are
+  copied with fast cloning instead (the compressed baskets are copied
+  without decompression), which is much faster, but these files keep
+  their own clusters and an output can mix cluster sizes. A cut that is
+  close to a file boundary is moved to this boundary, so that most of
+  the input files can be fast-cloned.
+
+  Each output gets the merged run header of its inputs with the number
+  of events set to the number of entries. A .list of the outputs and a
+  manifest are written:
+    output entries zip_bytes input:first-last ...
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+
+// ROOT headers
+#include "TFile.h"
+#include "TTree.h"
+#include "TList.h"
+#include "TClonesArray.h"
+#include "TString.h"
+
+// McDst headers
+#include "McRun.h"
+#include "McEvent.h"
+#include "McParticle.h"
+#include "McArrays.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-split.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-split"
+#define VERSION "1.0"
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "nfiles", .has_arg = 1, .flag = 0, .val = 'n' },
+  { .name = "prefix", .has_arg = 1, .flag = 0, .val = 'p' },
+  { .name = "entries", .has_arg = 0, .flag = 0, .val = 'e' },
+  { .name = "tolerance", .has_arg = 1, .flag = 0, .val = 't' },
+  { .name = "compression", .has_arg = 1, .flag = 0, .val = 'c' },
+  { .name = "cluster-size", .has_arg = 1, .flag = 0, .val = 0xFF01 },
+  { .name = "recluster", .has_arg = 0, .flag = 0, .val = 0xFF02 },
+  { .name = "fast-clone", .has_arg = 0, .flag = 0, .val = 0xFF03 },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " rewrites mcDst files into files of equal size\n" \
+    "Usage: " PROGNAME " [Options] -n <N> -p <prefix> <input.list or files>\n" \
+    "Options:\n\
+    -h, --help                        help\n\
+    -n, --nfiles <N>                  number of output files\n\
+    -p, --prefix <prefix>             outputs are <prefix>_<i>.mcDst.root, <prefix>.list\n\
+                                      and <prefix>.manifest\n\
+    -e, --entries                     balance number of entries instead of compressed size\n\
+    -t, --tolerance <fraction>        move cuts to file boundaries that are closer than\n\
+                                      fraction of the output size (default: 0.1)\n\
+    -c, --compression <settings>      compression settings, algorithm*100+level\n\
+                                      (default: the ones of the first input file)\n\
+    --cluster-size <entries>          cluster size of the outputs (default: ROOT's)\n\
+    --recluster                       rewrite all events with the same cluster size (default)\n\
+    --fast-clone                      copy whole input files without decompression. Much\n\
+                                      faster, but these files keep their own clusters, so\n\
+                                      an output can mix cluster sizes\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+// Input file.
+struct Input
+{
+  std::string name;
+  Long64_t entries;
+  Long64_t zipBytes;
+  double first;       // cumulative weight before the file
+  double weight;      // weight of the file
+};
+
+// Range of entries of one input.
+struct Segment
+{
+  std::size_t input;
+  Long64_t first;     // first entry
+  Long64_t last;      // last entry + 1
+};
+
+//_________________
+// Read names of the input files.
+static void
+add_inputs(const char *name, std::vector<Input> &inputs)
+{
+  std::string fname(name);
+  if (fname.find(".list") != std::string::npos || fname.find(".lis") != std::string::npos)
+  {
+    std::ifstream flist(name);
+    if (!flist)
+      ERR(1, "cannot open list %s", name);
+    std::string line;
+    while (std::getline(flist, line))
+    {
+      if (line.find(".mcDst.root") == std::string::npos)
+        continue;
+      Input input = { line, 0, 0, 0., 0. };
+      inputs.push_back(input);
+    }
+  }
+  else
+  {
+    Input input = { fname, 0, 0, 0., 0. };
+    inputs.push_back(input);
+  }
+}
+
+//_________________
+// Convert a global weight position to (input, entry).
+static void
+locate(const std::vector<Input> &inputs, double pos, std::size_t &input, Long64_t &entry)
+{
+  while (input + 1 < inputs.size() && pos >= inputs[input].first + inputs[input].weight)
+    ++input;
+  const Input &in = inputs[input];
+  double frac = (in.weight > 0) ? (pos - in.first) / in.weight : 0.;
+  if (frac < 0)
+    frac = 0;
+  entry = (Long64_t)(frac * in.entries + 0.5);
+  if (entry > in.entries)
+    entry = in.entries;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hn:p:et:c:"; // This string must be sync with a struct option array.
+  int opt;
+  int nfiles = 0;
+  std::string prefix;
+  bool byEntries = false;
+  double tolerance = 0.1;
+  int compression = -1;
+  Long64_t clusterSize = 0;
+  bool fastClone = false;
+  std::vector<Input> inputs;
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'n':
+      nfiles = std::stoi(optarg);
+      break;
+    case 'p':
+      prefix = optarg;
+      break;
+    case 'e':
+      byEntries = true;
+      break;
+    case 't':
+      tolerance = std::stod(optarg);
+      break;
+    case 'c':
+      compression = std::stoi(optarg);
+      break;
+    case 0xFF01:
+      clusterSize = std::stoll(optarg);
+      break;
+    case 0xFF02:
+      fastClone = false;
+      break;
+    case 0xFF03:
+      fastClone = true;
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  for (int i = optind; i < argc; ++i)
+    add_inputs(argv[i], inputs);
+  if (nfiles <= 0 || prefix.empty())
+    ERR(1, "number of output files and prefix must be given");
+  if (inputs.empty())
+    ERR(1, "no input files are given");
+
+  McEvent::Class()->IgnoreTObjectStreamer();
+  McParticle::Class()->IgnoreTObjectStreamer();
+  McRun::Class()->IgnoreTObjectStreamer();
+
+  // Sizes of the inputs.
+  double total = 0;
+  for (std::size_t i = 0; i < inputs.size(); ++i)
+  {
+    TFile *file = TFile::Open(inputs[i].name.c_str(), "READ");
+    TTree *tree = (file && !file->IsZombie()) ? (TTree*)file->Get("McDst") : 0;
+    if (!tree)
+      ERR(1, "cannot read McDst tree from %s", inputs[i].name.c_str());
+    if (compression < 0)
+      compression = file->GetCompressionSettings();
+    inputs[i].entries = tree->GetEntries();
+    inputs[i].zipBytes = tree->GetZipBytes();
+    inputs[i].first = total;
+    inputs[i].weight = byEntries ? inputs[i].entries : inputs[i].zipBytes;
+    total += inputs[i].weight;
+    file->Close();
+    delete file;
+  }
+  if (total <= 0)
+    ERR(1, "inputs are empty");
+
+  // Cut points. A cut close to a file boundary is moved there.
+  const double target = total / nfiles;
+  std::vector<std::size_t> cutInput(nfiles + 1, 0);
+  std::vector<Long64_t> cutEntry(nfiles + 1, 0);
+  cutInput[nfiles] = inputs.size() - 1;
+  cutEntry[nfiles] = inputs.back().entries;
+  std::size_t input = 0;
+  for (int j = 1; j < nfiles; ++j)
+  {
+    double pos = j * target;
+    locate(inputs, pos, input, cutEntry[j]);
+    const Input &in = inputs[input];
+    if (pos - in.first <= tolerance * target)
+      cutEntry[j] = 0;
+    else if (in.first + in.weight - pos <= tolerance * target)
+      cutEntry[j] = in.entries;
+    cutInput[j] = input;
+    // Cuts must not go backwards (possible only for tolerance >= 1).
+    if (cutInput[j] == cutInput[j - 1] && cutEntry[j] < cutEntry[j - 1])
+      cutEntry[j] = cutEntry[j - 1];
+  }
+
+  // Output files.
+  std::ofstream flist((prefix + ".list").c_str());
+  std::ofstream fmanifest((prefix + ".manifest").c_str());
+  if (!flist || !fmanifest)
+    ERR(1, "cannot write %s.list or %s.manifest", prefix.c_str(), prefix.c_str());
+  fmanifest << "# output entries zip_bytes input:first-last ...\n";
+
+  for (int j = 0; j < nfiles; ++j)
+  {
+    // Segments of the output.
+    std::vector<Segment> segments;
+    for (std::size_t i = cutInput[j]; i <= cutInput[j + 1]; ++i)
+    {
+      Segment seg = { i, 0, inputs[i].entries };
+      if (i == cutInput[j])
+        seg.first = cutEntry[j];
+      if (i == cutInput[j + 1])
+        seg.last = cutEntry[j + 1];
+      if (seg.last > seg.first)
+        segments.push_back(seg);
+    }
+
+    TString oname = TString::Format("%s_%d.mcDst.root", prefix.c_str(), j);
+    TFile *ofile = new TFile(oname, "RECREATE", "", compression);
+    if (!ofile || ofile->IsZombie())
+      ERR(1, "cannot create %s", oname.Data());
+    TClonesArray *mcArrays[McArrays::NAllMcArrays];
+    TTree *otree = new TTree("McDst", "McDst tree");
+    if (clusterSize > 0)
+      otree->SetAutoFlush(clusterSize);
+    for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+    {
+      mcArrays[i] = new TClonesArray(McArrays::mcArrayTypes[i], McArrays::mcArraySizes[i]);
+      otree->Branch(McArrays::mcArrayNames[i], &mcArrays[i]);
+    }
+
+    McRun *run = 0;
+    TList runs;
+    for (std::size_t s = 0; s < segments.size(); ++s)
+    {
+      const Segment &seg = segments[s];
+      const Input &in = inputs[seg.input];
+      TFile *file = TFile::Open(in.name.c_str(), "READ");
+      TTree *tree = (file && !file->IsZombie()) ? (TTree*)file->Get("McDst") : 0;
+      if (!tree)
+        ERR(1, "cannot read McDst tree from %s", in.name.c_str());
+      McRun *fileRun = (McRun*)file->Get("run");
+      if (fileRun)
+      {
+        if (!run)
+          run = fileRun;
+        else
+          runs.Add(fileRun);
+      }
+
+      ofile->cd();
+      if (fastClone && seg.first == 0 && seg.last == in.entries &&
+          file->GetCompressionSettings() == compression)
+      {
+        // Whole file: copy compressed baskets.
+        otree->CopyEntries(tree, -1, "fast");
+      }
+      else
+      {
+        for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+          tree->SetBranchAddress(McArrays::mcArrayNames[i], &mcArrays[i]);
+        for (Long64_t iEntry = seg.first; iEntry < seg.last; ++iEntry)
+        {
+          if (tree->GetEntry(iEntry) <= 0)
+            ERR(1, "cannot read entry %lld of %s", iEntry, in.name.c_str());
+          otree->Fill();
+        }
+        tree->ResetBranchAddresses();
+      }
+      file->Close();
+      delete file;
+    }
+
+    // Run header
+    ofile->cd();
+    if (run)
+    {
+      run->Merge(&runs);
+      run->setNEvents(otree->GetEntries());
+      run->Write();
+    }
+    runs.Delete();
+    delete run;
+    Long64_t entries = otree->GetEntries();
+    Long64_t zipBytes = otree->GetZipBytes();
+    ofile->Write();
+    ofile->Close();
+    delete ofile;
+    for (int i = 0; i < McArrays::NAllMcArrays; ++i)
+      delete mcArrays[i];
+
+    flist << oname << "\n";
+    fmanifest << oname << " " << entries << " " << zipBytes;
+    for (std::size_t s = 0; s < segments.size(); ++s)
+      fmanifest << " " << inputs[segments[s].input].name << ":" << segments[s].first
+                << "-" << segments[s].last - 1;
+    fmanifest << "\n";
+    std::cout << PROGNAME ": " << oname << " " << entries << " entries, "
+              << zipBytes / (1024. * 1024.) << " MB" << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
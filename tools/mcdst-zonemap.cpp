@@ -0,0 +1,165 @@
+/*
+  mcdst-zonemap writes zone maps to mcDst files.
+
+  For every cluster of entries of the McDst tree the zone map keeps the
+  minimal and maximal impact parameter, multiplicity, event number and
+  time step number (see McDstZoneMap). It is stored as the small tree
+  McDstZoneMap in the same file, an existing zone map is replaced.
+  McDstReader::skipClusters() then reads only the clusters that may
+  contain selected events.
+
+  Only the McEvent members and the sizes of the particle arrays are
+  read, the particle baskets are not decompressed.
+*/
+
+// getopt
+#include <unistd.h>
+#include <getopt.h>
+
+#include <errno.h>
+
+// C++ headers
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// ROOT headers
+#include "TFile.h"
+#include "TTree.h"
+
+// McDst headers
+#include "McDstZoneMap.h"
+
+/*
+  Emit error message and exit. Args:
+  * doexit - if 0 then do not exit, else exit from a program.
+  * format - printf-like format string.
+  * ... - arguments for format string.
+  There is no need to add a new line character explicitly at the end of the
+  format string.
+*/
+#define ERR(doexit, format, ...)                                        \
+  { fprintf(stderr, "mcdst-zonemap.cpp:%d / errno=%d / " format "\n", __LINE__, errno, ##__VA_ARGS__); \
+    if (doexit) exit(EXIT_FAILURE); }                                   \
+
+#define PROGNAME "mcdst-zonemap"
+#define VERSION "1.0"
+
+// Options for getopt.
+struct option longopts[] =
+{
+  { .name = "help", .has_arg = 0, .flag = 0, .val = 'h' },
+  { .name = "input-list", .has_arg = 1, .flag = 0, .val = 'f' },
+  { .name = "verbose", .has_arg = 0, .flag = 0, .val = 'v' },
+  { 0, 0, 0, 0 }
+};
+
+// Output help string.
+void
+help_me()
+{
+  const char *hstr =                                                    \
+    PROGNAME " v" VERSION " writes per-cluster event statistics to mcDst files\n" \
+    "Usage: " PROGNAME " [Options] [input files]\n"                     \
+    "Options:\n\
+    -h, --help                        help\n\
+    -f, --input-list <filename>       file with one input file per line\n\
+    -v, --verbose                     print statistics of every cluster\n\
+The files are updated in place.\n";
+
+  std::cout << hstr;
+  exit(EXIT_SUCCESS);
+}
+
+/*
+  Build the zone map of the file and write it. Return true on success.
+*/
+bool
+write_zone_map(const std::string &fname, bool verbose)
+{
+  TFile *file = TFile::Open(fname.c_str(), "UPDATE");
+  if (!file || file->IsZombie())
+  {
+    ERR(0, "cannot open %s", fname.c_str());
+    delete file;
+    return false;
+  }
+  TTree *tree = dynamic_cast<TTree*>(file->Get("McDst"));
+  McDstZoneMap zones;
+  bool ok = tree && zones.build(tree) && zones.write(file);
+  if (!ok)
+    ERR(0, "cannot write zone map of %s", fname.c_str());
+  if (ok && verbose)
+  {
+    for (std::size_t i = 0; i < zones.zones().size(); ++i)
+    {
+      const McDstZoneMap::Zone &z = zones.zones()[i];
+      std::cout << "  entries [" << z.firstEntry << ", " << z.lastEntry << ")"
+                << " b [" << z.bMin << ", " << z.bMax << "]"
+                << " mult [" << z.multMin << ", " << z.multMax << "]"
+                << " eventNr [" << z.eventNrMin << ", " << z.eventNrMax << "]"
+                << " stepNr [" << z.stepNrMin << ", " << z.stepNrMax << "]" << std::endl;
+    }
+  }
+  if (ok)
+    std::cout << PROGNAME ": " << fname << ": " << zones.numberOfZones() << " clusters" << std::endl;
+  file->Close();
+  delete file;
+  return ok;
+}
+
+int
+main(int argc, char *argv[])
+{
+  const char optstring[] = "hf:v"; // This string must be sync with a struct option array.
+  int opt;
+  bool verbose = false;
+  std::vector<std::string> inputs;
+
+  // Parse command line arguments.
+  if (argc <= 1)
+    ERR(1, "For the help message try: %s --help", PROGNAME);
+
+  while ((opt = getopt_long(argc, argv, optstring, longopts, 0)) != -1)
+  {
+    switch (opt)
+    {
+    case 'h':
+      help_me();
+      break;
+    case 'f':
+    {
+      std::ifstream flist(optarg);
+      if (!flist)
+        ERR(1, "cannot open input list %s", optarg);
+      std::string line;
+      while (std::getline(flist, line))
+      {
+        if (!line.empty() && line[0] != '#')
+          inputs.push_back(line);
+      }
+      break;
+    }
+    case 'v':
+      verbose = true;
+      break;
+    default:
+      ERR(1, "Wrong option: %c", (char)opt);
+    }
+  }
+  for (int i = optind; i < argc; ++i)
+    inputs.push_back(argv[i]);
+  if (inputs.empty())
+    ERR(1, "no input files are given");
+
+  std::size_t nfailed = 0;
+  for (std::size_t i = 0; i < inputs.size(); ++i)
+  {
+    if (!write_zone_map(inputs[i], verbose))
+      ++nfailed;
+  }
+  if (nfailed > 0)
+    ERR(1, "%d of %d files failed", (int)nfailed, (int)inputs.size());
+  return EXIT_SUCCESS;
+}